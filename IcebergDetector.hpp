@@ -2,31 +2,53 @@
 
 #include <string>
 #include <map>
-#include <unordered_map>
 #include <iostream>
+#include "core/fixed_point.hpp"
 #include "core/serialization.hpp"  // For OrderBookUpdate
 
+// Price levels tracked per book side. Once a side is full, a new level takes over the
+// node of the level farthest from the touch, so a drifting book stops allocating.
+constexpr size_t ICEBERG_MAX_LEVELS = 1024;
+
 // Structure to track price level state
 struct IcebergLevelState {
-    double last_quantity = 0.0;
+    int64_t last_quantity = 0;  // In lots
     int iceberg_counter = 0;
 };
 
 class IcebergDetector {
 public:
-    IcebergDetector();
+    // Tracks the book of one symbol; updates carry no symbol of their own. Levels are
+    // keyed by price in whole units and quantities compared in lots, at precision.
+    explicit IcebergDetector(std::string symbol = "BTCUSDT", SymbolPrecision precision = {});
     ~IcebergDetector();
 
     // Process an order book update
     void process_update(const OrderBookUpdate& update);
 
+    // Levels dropped as out of fixed-point range at this symbol's precision
+    uint64_t skipped_levels() const { return skipped_levels_; }
+
 private:
-    // Map of symbol -> price -> state
-    std::unordered_map<std::string, std::map<double, IcebergLevelState>> book_state_;
+    std::string symbol_;
+    SymbolPrecision precision_;
+    uint64_t skipped_levels_ = 0;
+
+    using BookSide = std::map<int64_t, IcebergLevelState>;  // Price units -> state
+
+    BookSide bids_;
+    BookSide asks_;
     
+    // State for price, or nullptr when the side is full and price is beyond its far end
+    static IcebergLevelState* find_level(BookSide& side, int64_t price, bool is_bid);
+
+    // Convert a level to units and lots, skipping it if either is out of fixed-point
+    // range; the first skip is logged
+    void process_level(BookSide& side, const PriceLevel& level, bool is_bid);
+
     // Detect iceberg patterns at a specific price level
-    void detect_iceberg(const std::string& symbol, double price, double quantity, bool is_bid);
+    void detect_iceberg(BookSide& side, int64_t price, int64_t quantity, bool is_bid);
     
     // Emit an iceberg detection event
-    void emit_iceberg_event(const std::string& symbol, double price, bool is_bid);
+    void emit_iceberg_event(int64_t price, bool is_bid);
 };
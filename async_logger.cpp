@@ -0,0 +1,371 @@
+#include "core/async_logger.hpp"
+#include "core/spsc_queue.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Records each thread can have waiting for the writer before it starts dropping
+constexpr size_t LOG_RING_CAPACITY = 4096;
+
+// Longest formatted line; longer lines are cut short
+constexpr size_t LOG_LINE_SIZE = 512;
+
+// Formatted output gathered before each write to stdout or stderr
+constexpr size_t LOG_WRITE_BUFFER_SIZE = 64 * 1024;
+
+// How long the writer sleeps when every ring is empty
+constexpr auto LOG_IDLE_WAIT = std::chrono::milliseconds(1);
+
+constexpr uint64_t RATE_WINDOW_NS = 1000000000;
+
+static_assert(LOG_CATEGORY_COUNT == 6, "Give every log category its default level");
+std::atomic<LogLevel> log_levels[LOG_CATEGORY_COUNT] = {
+    {LOG_INFO}, {LOG_INFO}, {LOG_INFO}, {LOG_INFO}, {LOG_INFO}, {LOG_INFO}};
+
+static std::atomic<uint32_t> log_rate_limit(0);
+
+// A thread's records waiting for the writer, kept until the writer stops so records
+// logged just before the thread exited are still written
+struct ThreadLog {
+    ThreadLog() : ring(LOG_RING_CAPACITY) {}
+
+    SPSCQueue<LogRecord> ring;
+    std::atomic<uint64_t> dropped{0};  // Ring full
+};
+
+// Per-thread, per-category rate limit window
+struct RateWindow {
+    uint64_t start_ns = 0;
+    uint32_t count = 0;
+    uint64_t suppressed = 0;
+};
+
+static std::mutex registry_mutex;
+static std::vector<std::unique_ptr<ThreadLog>> thread_logs;
+static std::atomic<bool> writer_running(false);
+static std::thread writer_thread;
+static std::atomic<uint64_t> total_suppressed(0);
+
+static thread_local ThreadLog* thread_log = nullptr;
+static thread_local RateWindow rate_windows[LOG_CATEGORY_COUNT];
+static thread_local LogRecord direct_record;  // Written on the spot with the writer stopped
+
+const char* log_level_name(LogLevel level) {
+    switch (level) {
+        case LOG_DEBUG: return "debug";
+        case LOG_INFO: return "info";
+        case LOG_WARN: return "warn";
+        case LOG_ERROR: return "error";
+        case LOG_OFF: return "off";
+        default: return "unknown";
+    }
+}
+
+const char* log_category_name(LogCategory category) {
+    switch (category) {
+        case LOG_WEBSOCKET: return "websocket";
+        case LOG_CONSUMER: return "consumer";
+        case LOG_TRADE: return "trade";
+        case LOG_ORDER_FLOW: return "order_flow";
+        case LOG_ICEBERG: return "iceberg";
+        case LOG_BUCKET: return "bucket";
+        default: return "unknown";
+    }
+}
+
+static bool parse_log_level(const std::string& name, LogLevel& out) {
+    for (int level = LOG_DEBUG; level <= LOG_OFF; ++level) {
+        if (name == log_level_name(static_cast<LogLevel>(level))) {
+            out = static_cast<LogLevel>(level);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool parse_log_levels(const std::string& text, LogLevels& out) {
+    LogLevels levels = out;
+    size_t start = 0;
+    while (start <= text.size()) {
+        size_t end = text.find(',', start);
+        if (end == std::string::npos) end = text.size();
+        std::string item = text.substr(start, end - start);
+        start = end + 1;
+        if (item.empty()) {
+            continue;
+        }
+
+        size_t equals = item.find('=');
+        LogLevel level;
+        if (equals == std::string::npos) {
+            if (!parse_log_level(item, level)) return false;
+            levels.fill(level);
+            continue;
+        }
+        if (!parse_log_level(item.substr(equals + 1), level)) return false;
+        std::string name = item.substr(0, equals);
+        bool found = false;
+        for (int category = 0; category < LOG_CATEGORY_COUNT; ++category) {
+            if (name == log_category_name(static_cast<LogCategory>(category))) {
+                levels[category] = level;
+                found = true;
+            }
+        }
+        if (!found) return false;
+    }
+    out = levels;
+    return true;
+}
+
+void set_log_levels(const LogLevels& levels) {
+    for (int category = 0; category < LOG_CATEGORY_COUNT; ++category) {
+        log_levels[category].store(levels[category], std::memory_order_relaxed);
+    }
+}
+
+void set_log_rate_limit(uint32_t records_per_second) {
+    log_rate_limit.store(records_per_second, std::memory_order_relaxed);
+}
+
+// "YYYY-MM-DD HH:MM:SS.mmm" of a nanosecond UTC timestamp
+static size_t format_log_timestamp(uint64_t timestamp_ns, char* out, size_t capacity) {
+    uint64_t timestamp_ms = timestamp_ns / 1000000;
+    std::time_t time = static_cast<std::time_t>(timestamp_ms / 1000);
+    std::tm tm_utc;
+    gmtime_r(&time, &tm_utc);
+    size_t len = std::strftime(out, capacity, "%Y-%m-%d %H:%M:%S", &tm_utc);
+    int written = std::snprintf(out + len, capacity - len, ".%03u",
+                                static_cast<unsigned>(timestamp_ms % 1000));
+    return written > 0 ? len + static_cast<size_t>(written) : len;
+}
+
+static size_t format_log_arg(const LogRecord& record, const LogArg& arg, int precision,
+                             char* out, size_t capacity) {
+    int written = 0;
+    switch (arg.type) {
+        case LogArg::INT:
+            written = std::snprintf(out, capacity, "%lld", static_cast<long long>(arg.i));
+            break;
+        case LogArg::UINT:
+            written = std::snprintf(out, capacity, "%llu", static_cast<unsigned long long>(arg.u));
+            break;
+        case LogArg::DOUBLE:
+            written = precision < 0 ? std::snprintf(out, capacity, "%g", arg.d)
+                                    : std::snprintf(out, capacity, "%.*f", precision, arg.d);
+            break;
+        case LogArg::TEXT:
+            written = std::snprintf(out, capacity, "%s", record.text + arg.text_offset);
+            break;
+    }
+    if (written < 0) {
+        return 0;
+    }
+    return static_cast<size_t>(written) < capacity ? static_cast<size_t>(written) : capacity - 1;
+}
+
+size_t format_log_record(const LogRecord& record, char* out, size_t capacity) {
+    // Leave room for the newline
+    size_t limit = capacity - 1;
+    size_t len = 0;
+    if (record.timestamp_ns != 0 && limit > 2) {
+        out[len++] = '[';
+        len += format_log_timestamp(record.timestamp_ns, out + len, limit - len);
+        len += std::snprintf(out + len, limit - len, "] ");
+    }
+
+    size_t next_arg = 0;
+    const char* p = record.format;
+    while (*p && len + 1 < limit) {
+        if (*p == '{') {
+            const char* q = p + 1;
+            int precision = -1;
+            if (*q == '.') {
+                precision = 0;
+                for (++q; *q >= '0' && *q <= '9'; ++q) {
+                    precision = precision * 10 + (*q - '0');
+                }
+            }
+            if (*q == '}' && next_arg < record.arg_count) {
+                len += format_log_arg(record, record.args[next_arg++], precision, out + len, limit - len);
+                p = q + 1;
+                continue;
+            }
+        }
+        out[len++] = *p++;
+    }
+    out[len++] = '\n';
+    return len;
+}
+
+void pack_log_text(LogRecord& record, const char* text, size_t length) {
+    LogArg& arg = record.args[record.arg_count++];
+    arg.type = LogArg::TEXT;
+    size_t room = LOG_TEXT_SIZE - record.text_used;
+    if (room == 0) {
+        // Out of text space: point at the terminator of the previous string
+        arg.text_offset = LOG_TEXT_SIZE - 1;
+        return;
+    }
+    size_t copied = length < room - 1 ? length : room - 1;
+    std::memcpy(record.text + record.text_used, text, copied);
+    record.text[record.text_used + copied] = '\0';
+    arg.text_offset = record.text_used;
+    record.text_used = static_cast<uint8_t>(record.text_used + copied + 1);
+}
+
+static void write_direct(const LogRecord& record) {
+    char line[LOG_LINE_SIZE];
+    size_t len = format_log_record(record, line, sizeof(line));
+    std::FILE* stream = record.level >= LOG_WARN ? stderr : stdout;
+    std::fwrite(line, 1, len, stream);
+    std::fflush(stream);
+}
+
+static uint64_t steady_now_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// False if category is over this thread's rate limit for the current window.
+// Closing a window that suppressed records logs how many.
+static bool within_rate_limit(LogCategory category) {
+    uint32_t limit = log_rate_limit.load(std::memory_order_relaxed);
+    if (limit == 0) {
+        return true;
+    }
+    RateWindow& window = rate_windows[category];
+    uint64_t now = steady_now_ns();
+    if (now - window.start_ns >= RATE_WINDOW_NS) {
+        uint64_t suppressed = window.suppressed;
+        window.start_ns = now;
+        window.count = 0;
+        window.suppressed = 0;
+        if (suppressed > 0) {
+            log_event(category, LOG_WARN, 0, "[Log] Suppressed {} {} records over the rate limit",
+                      suppressed, log_category_name(category));
+        }
+    }
+    if (window.count >= limit) {
+        ++window.suppressed;
+        total_suppressed.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    ++window.count;
+    return true;
+}
+
+static ThreadLog* register_thread_log() {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    thread_logs.push_back(std::make_unique<ThreadLog>());
+    return thread_logs.back().get();
+}
+
+LogRecord* claim_log_record(LogCategory category) {
+    if (!within_rate_limit(category)) {
+        return nullptr;
+    }
+    if (!writer_running.load(std::memory_order_acquire)) {
+        return &direct_record;
+    }
+    if (!thread_log) {
+        thread_log = register_thread_log();
+    }
+    LogRecord* record = thread_log->ring.try_claim();
+    if (!record) {
+        thread_log->dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+    return record;
+}
+
+void publish_log_record(LogRecord& record) {
+    if (&record == &direct_record) {
+        write_direct(record);
+        return;
+    }
+    thread_log->ring.publish();
+}
+
+// Output for one stream, written out whenever it fills and at the end of each pass
+class LogWriteBuffer {
+public:
+    explicit LogWriteBuffer(std::FILE* stream) : stream_(stream) {}
+
+    void append(const LogRecord& record) {
+        if (LOG_WRITE_BUFFER_SIZE - used_ < LOG_LINE_SIZE) {
+            flush();
+        }
+        used_ += format_log_record(record, buffer_ + used_, LOG_LINE_SIZE);
+    }
+
+    void flush() {
+        if (used_ > 0) {
+            std::fwrite(buffer_, 1, used_, stream_);
+            std::fflush(stream_);
+            used_ = 0;
+        }
+    }
+
+private:
+    std::FILE* stream_;
+    char buffer_[LOG_WRITE_BUFFER_SIZE];
+    size_t used_ = 0;
+};
+
+// Write every record queued so far; returns how many
+static size_t drain_thread_logs(LogWriteBuffer& out, LogWriteBuffer& err) {
+    size_t written = 0;
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    for (auto& log : thread_logs) {
+        while (const LogRecord* record = log->ring.peek()) {
+            (record->level >= LOG_WARN ? err : out).append(*record);
+            log->ring.advance();
+            ++written;
+        }
+    }
+    out.flush();
+    err.flush();
+    return written;
+}
+
+static void run_writer() {
+    auto out = std::make_unique<LogWriteBuffer>(stdout);
+    auto err = std::make_unique<LogWriteBuffer>(stderr);
+    while (writer_running.load(std::memory_order_acquire)) {
+        if (drain_thread_logs(*out, *err) == 0) {
+            std::this_thread::sleep_for(LOG_IDLE_WAIT);
+        }
+    }
+    drain_thread_logs(*out, *err);
+}
+
+void start_async_logger() {
+    if (writer_running.exchange(true, std::memory_order_acq_rel)) {
+        return;
+    }
+    writer_thread = std::thread(run_writer);
+}
+
+void stop_async_logger() {
+    if (!writer_running.exchange(false, std::memory_order_acq_rel)) {
+        return;
+    }
+    writer_thread.join();
+
+    uint64_t dropped = 0;
+    {
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        for (const auto& log : thread_logs) {
+            dropped += log->dropped.load(std::memory_order_relaxed);
+        }
+    }
+    uint64_t suppressed = total_suppressed.load(std::memory_order_relaxed);
+    if (dropped > 0 || suppressed > 0) {
+        std::fprintf(stderr, "[Log] %llu records dropped on full rings, %llu over the rate limit\n",
+                     static_cast<unsigned long long>(dropped), static_cast<unsigned long long>(suppressed));
+    }
+}
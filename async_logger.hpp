@@ -0,0 +1,166 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// Asynchronous logging for the hot path.
+//
+// log_event() copies the format string pointer and its arguments as raw values into a
+// fixed-size record on a ring owned by the calling thread: no formatting, no locking,
+// no allocation after the thread's first record. A background thread drains every
+// thread's ring, formats the records and writes them to stdout (stderr from LOG_WARN
+// up). Until start_async_logger(), and after stop_async_logger(), records are
+// formatted and written on the spot instead, so tools that never start it still print.
+//
+// A record is dropped rather than waited for when its thread's ring is full, and
+// counted; so is a record over its category's rate limit, and the count of those is
+// logged once the limit's one-second window has passed.
+
+enum LogLevel : uint8_t {
+    LOG_DEBUG,
+    LOG_INFO,
+    LOG_WARN,
+    LOG_ERROR,
+    LOG_OFF
+};
+
+enum LogCategory : uint8_t {
+    LOG_WEBSOCKET,   // Network thread: ring overflow, per-message debug output
+    LOG_CONSUMER,    // Feed ring consumer: every frame it processes, bad frames
+    LOG_TRADE,       // Trade executions seen by a liquidity tracker
+    LOG_ORDER_FLOW,  // Order book additions, removals and cancels
+    LOG_ICEBERG,     // Iceberg detections
+    LOG_BUCKET,      // Filled volume and cancel buckets
+    LOG_CATEGORY_COUNT
+};
+
+const char* log_level_name(LogLevel level);
+const char* log_category_name(LogCategory category);
+
+using LogLevels = std::array<LogLevel, LOG_CATEGORY_COUNT>;
+
+inline LogLevels default_log_levels() {
+    LogLevels levels;
+    levels.fill(LOG_INFO);
+    return levels;
+}
+
+// Parse "info", or "warn,consumer=debug,iceberg=off": an optional level for every
+// category, then per-category overrides. Returns false on malformed input.
+bool parse_log_levels(const std::string& text, LogLevels& out);
+
+// Placeholders in a log_event() format: "{}" prints the next argument as is, "{.N}"
+// prints a floating-point argument with N decimals
+constexpr size_t LOG_MAX_ARGS = 6;
+// Bytes per record shared by its string arguments; longer text is cut short
+constexpr size_t LOG_TEXT_SIZE = 128;
+
+struct LogArg {
+    enum Type : uint8_t { INT, UINT, DOUBLE, TEXT };
+
+    union {
+        int64_t i;
+        uint64_t u;
+        double d;
+        uint32_t text_offset;  // Into LogRecord::text
+    };
+    Type type;
+};
+
+struct alignas(64) LogRecord {
+    uint64_t timestamp_ns;  // Event time, printed as a "[YYYY-MM-DD HH:MM:SS.mmm] " prefix; 0 for none
+    const char* format;     // Must be a string literal: only the pointer is kept
+    LogCategory category;
+    LogLevel level;
+    uint8_t arg_count;
+    uint8_t text_used;
+    LogArg args[LOG_MAX_ARGS];
+    char text[LOG_TEXT_SIZE];
+};
+
+extern std::atomic<LogLevel> log_levels[LOG_CATEGORY_COUNT];
+
+inline bool log_enabled(LogCategory category, LogLevel level) {
+    return level != LOG_OFF && level >= log_levels[category].load(std::memory_order_relaxed);
+}
+
+void set_log_levels(const LogLevels& levels);
+
+// Records per second each thread may log in one category before the rest are
+// suppressed; 0, the default, for no limit
+void set_log_rate_limit(uint32_t records_per_second);
+
+// Start the background writer, and stop it after writing everything logged so far.
+// Call stop only once no other thread logs any more.
+void start_async_logger();
+void stop_async_logger();
+
+// Record slot for the calling thread, or nullptr when the record is to be dropped;
+// log_event() fills it and hands it back through publish_log_record()
+LogRecord* claim_log_record(LogCategory category);
+void publish_log_record(LogRecord& record);
+
+template <typename T>
+inline typename std::enable_if<std::is_integral<T>::value>::type
+pack_log_arg(LogRecord& record, T value) {
+    LogArg& arg = record.args[record.arg_count++];
+    if (std::is_signed<T>::value) {
+        arg.type = LogArg::INT;
+        arg.i = static_cast<int64_t>(value);
+    } else {
+        arg.type = LogArg::UINT;
+        arg.u = static_cast<uint64_t>(value);
+    }
+}
+
+template <typename T>
+inline typename std::enable_if<std::is_floating_point<T>::value>::type
+pack_log_arg(LogRecord& record, T value) {
+    LogArg& arg = record.args[record.arg_count++];
+    arg.type = LogArg::DOUBLE;
+    arg.d = static_cast<double>(value);
+}
+
+void pack_log_text(LogRecord& record, const char* text, size_t length);
+
+inline void pack_log_arg(LogRecord& record, const char* text) {
+    pack_log_text(record, text, std::char_traits<char>::length(text));
+}
+
+inline void pack_log_arg(LogRecord& record, std::string_view text) {
+    pack_log_text(record, text.data(), text.size());
+}
+
+// Log format with args under category at level, stamped with the event's timestamp_ns
+// (0 for no timestamp). Costs one relaxed load when the level is filtered out.
+//
+//     log_event(LOG_CONSUMER, LOG_INFO, trade.timestamp_ns,
+//               "[Consumer] Processed trade: {}, price: ${.2}", trade.trade_id, trade.price);
+template <typename... Args>
+inline void log_event(LogCategory category, LogLevel level, uint64_t timestamp_ns,
+                      const char* format, const Args&... args) {
+    static_assert(sizeof...(Args) <= LOG_MAX_ARGS, "Too many arguments for one log record");
+    if (!log_enabled(category, level)) {
+        return;
+    }
+    LogRecord* record = claim_log_record(category);
+    if (!record) {
+        return;
+    }
+    record->timestamp_ns = timestamp_ns;
+    record->format = format;
+    record->category = category;
+    record->level = level;
+    record->arg_count = 0;
+    record->text_used = 0;
+    (pack_log_arg(*record, args), ...);
+    publish_log_record(*record);
+}
+
+// Format record as one line, newline included, into out; returns the length
+size_t format_log_record(const LogRecord& record, char* out, size_t capacity);
@@ -0,0 +1,158 @@
+// depthUpdate decoding cost: parse_orderbook_json_into (nlohmann) and a jsoncpp DOM
+// decode, as BinanceOrderBook::process_ws_update falls back to, against
+// parse_depth_message into OrderBookUpdate, DepthMessage and FixedDepthMessage.
+//
+// First checks that parse_depth_message matches parse_orderbook_json_into on 20000
+// random updates of 1 to 60 levels a side, then times each decoder at 5, 20, 100 and
+// 1000 levels a side and counts heap allocations with a replaced operator new.
+//
+//   depth_parser_bench
+//
+// Links against feed_parser.cpp, serialization.cpp and -ljsoncpp. Build it a second
+// time with feed_parser.cpp compiled with -DFEED_PARSER_SCALAR=1 for the scalar scan.
+// Exits non-zero on a mismatch.
+
+#include "core/feed_parser.hpp"
+#include "core/wire_format.hpp"
+#include <jsoncpp/json/json.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+
+static size_t allocations = 0;
+
+void* operator new(size_t size) {
+    ++allocations;
+    void* p = std::malloc(size ? size : 1);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+static std::string decimal(double value, int decimals) {
+    char buffer[64];
+    std::snprintf(buffer, sizeof(buffer), "%.*f", decimals, value);
+    return buffer;
+}
+
+// Prices at 2 to 8 decimals, quantities at 8, zero_percent of levels removed
+static std::string make_update(int levels, unsigned seed, unsigned zero_percent) {
+    std::mt19937 rng(seed);
+    std::string message = R"({"e":"depthUpdate","E":)" + std::to_string(1700000000000ull + rng() % 1000000) +
+                          R"(,"s":"BTCUSDT","U":)" + std::to_string(1000 + rng() % 1000000) +
+                          R"(,"u":)" + std::to_string(5000 + rng() % 1000000) + R"(,"b":[)";
+    int price_decimals = 2 + rng() % 7;
+    for (int side = 0; side < 2; ++side) {
+        for (int i = 0; i < levels; ++i) {
+            double price = (rng() % 100000) + (rng() % 100000000) * 1e-8;
+            double quantity = rng() % 100 < zero_percent ? 0.0 : (rng() % 100000000) * 1e-8 * (rng() % 1000);
+            message += i ? "," : "";
+            message += "[\"" + decimal(price, price_decimals) + "\",\"" + decimal(quantity, 8) + "\"]";
+        }
+        message += side == 0 ? R"(],"a":[)" : "]}";
+    }
+    return message;
+}
+
+static bool same(const OrderBookUpdate& a, const OrderBookUpdate& b) {
+    if (a.timestamp_ns != b.timestamp_ns || a.last_update_id != b.last_update_id ||
+        a.bids.size() != b.bids.size() || a.asks.size() != b.asks.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.bids.size(); ++i) {
+        if (a.bids[i].price != b.bids[i].price || a.bids[i].quantity != b.bids[i].quantity) {
+            return false;
+        }
+    }
+    for (size_t i = 0; i < a.asks.size(); ++i) {
+        if (a.asks[i].price != b.asks[i].price || a.asks[i].quantity != b.asks[i].quantity) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static int check_random(unsigned count) {
+    OrderBookUpdate fast;
+    OrderBookUpdate generic;
+    int mismatches = 0;
+    for (unsigned seed = 1; seed <= count; ++seed) {
+        std::string message = make_update(1 + seed % 60, seed, 20);
+        if (!parse_depth_message(message.data(), message.size(), fast) ||
+            !parse_orderbook_json_into(message, generic) || !same(fast, generic)) {
+            if (++mismatches <= 10) {
+                std::printf("MISMATCH %s\n", message.c_str());
+            }
+        }
+    }
+    return mismatches;
+}
+
+// Microseconds and allocations per message
+template <typename Parse>
+static void time_parser(const char* name, int iterations, Parse&& parse) {
+    parse();  // Let reused buffers grow to size first
+    size_t allocations_before = allocations;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        parse();
+    }
+    double elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    std::printf("  %-30s %9.2f us/msg  %7.0f allocations/msg\n", name, elapsed / iterations,
+                double(allocations - allocations_before) / iterations);
+}
+
+static void time_levels(int levels) {
+    std::string message = make_update(levels, 42, 10);
+    const int iterations = levels >= 1000 ? 500 : 20000;
+    std::printf("%d levels a side, %zu bytes:\n", levels, message.size());
+
+    OrderBookUpdate update;
+    DepthMessage depth;
+    FixedDepthMessage fixed;
+    SymbolPrecision precision;
+    Json::CharReaderBuilder builder;
+
+    time_parser("parse_orderbook_json_into", iterations, [&] {
+        parse_orderbook_json_into(message, update);
+    });
+    time_parser("jsoncpp + std::stod", iterations, [&] {
+        Json::Value root;
+        std::string errors;
+        std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+        reader->parse(message.data(), message.data() + message.size(), &root, &errors);
+        double sum = 0.0;
+        for (const char* side : {"b", "a"}) {
+            for (const Json::Value& level : root[side]) {
+                sum += std::stod(level[0].asString()) + std::stod(level[1].asString());
+            }
+        }
+        asm volatile("" : : "m"(sum));
+    });
+    time_parser("parse_depth_message (update)", iterations, [&] {
+        parse_depth_message(message.data(), message.size(), update);
+    });
+    time_parser("parse_depth_message (arrays)", iterations, [&] {
+        parse_depth_message(message.data(), message.size(), depth);
+    });
+    time_parser("parse_depth_message (fixed)", iterations, [&] {
+        parse_depth_message(message.data(), message.size(), precision, fixed);
+    });
+}
+
+int main() {
+    int mismatches = check_random(20000);
+    std::printf("equivalence: 20000 random updates, %d mismatches\n", mismatches);
+
+    for (int levels : {5, 20, 100, 1000}) {
+        time_levels(levels);
+    }
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,82 @@
+// Handoff cost of MPMCQueue against the mutex-based TSQueue, at 1, 2, 4 and 8 producers
+// feeding one consumer, the two HandoffQueue choices in handoff_queue.hpp.
+//
+// Items are 64 bytes, about the size of a TradeMessageBinary, and carry their producer
+// and a per-producer sequence number; the consumer checks that each producer's items
+// arrive complete and in order.
+//
+//   mpmc_queue_bench [items]
+//
+// Both queues are header-only, so this links against nothing else.
+
+#include "core/mpmc_queue.hpp"
+#include "core/ts_queue.hpp"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <optional>
+#include <thread>
+#include <vector>
+
+struct Item {
+    uint64_t producer;
+    uint64_t sequence;
+    uint64_t payload[6];
+};
+
+// Nanoseconds per item from the first push to the last pop, or a negative value if
+// an item was lost or reordered
+template <typename Queue>
+static double run(Queue& queue, unsigned producers, uint64_t items) {
+    const uint64_t per_producer = items / producers;
+    std::vector<uint64_t> expected(producers, 0);
+    bool ordered = true;
+
+    auto start = std::chrono::steady_clock::now();
+    std::thread consumer([&] {
+        for (uint64_t i = 0; i < per_producer * producers; ++i) {
+            std::optional<Item> item = queue.pop();
+            if (!item || item->sequence != expected[item->producer]++) {
+                ordered = false;
+                return;
+            }
+        }
+    });
+    std::vector<std::thread> threads;
+    for (unsigned p = 0; p < producers; ++p) {
+        threads.emplace_back([&, p] {
+            Item item{};
+            item.producer = p;
+            for (uint64_t i = 0; i < per_producer; ++i) {
+                item.sequence = i;
+                queue.push(item);
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    consumer.join();
+    double elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    return ordered ? elapsed / (per_producer * producers) : -1.0;
+}
+
+int main(int argc, char** argv) {
+    uint64_t items = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 2000000;
+    bool failed = false;
+
+    for (unsigned producers : {1u, 2u, 4u, 8u}) {
+        MPMCQueue<Item> mpmc(4096);
+        TSQueue<Item> mutex_queue;
+        double lock_free = run(mpmc, producers, items);
+        double locked = run(mutex_queue, producers, items);
+        std::printf("%u producers: MPMCQueue %6.1f ns/item  TSQueue %6.1f ns/item\n",
+                    producers, lock_free, locked);
+        failed |= lock_free < 0 || locked < 0;
+    }
+    if (failed) {
+        std::printf("items lost or out of order\n");
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,172 @@
+// End-to-end latency and throughput of the inline and threaded pipeline modes.
+//
+//   pipeline_mode_bench inline [gap_ns]     InlinePipeline called on the sending thread,
+//                                           as the network callback does with
+//                                           BINANCE_RUN_MODE=inline
+//   pipeline_mode_bench threaded [gap_ns]   feed ring -> consumer -> orderbook_ring and
+//                                           trade_queue -> iceberg thread and
+//                                           LiquidityFeed, as main.cpp runs it, over a
+//                                           feed ring private to this process
+//
+// Sends 200000 messages, one book in ten and the rest trades, back to back or gap_ns
+// apart. Every message is stamped as received and parsed when it is sent, so the
+// [Latency] report printed at the end covers everything after JSON decoding.
+//
+// Links against every translation unit except main.cpp, binance_connector.cpp,
+// exchange_info.cpp and binance_orderbook_w1.cpp.
+
+#include "features/IcebergDetector.hpp"
+#include "features/inline_pipeline.hpp"
+#include "features/liquidity_feed.hpp"
+#include "io/ring_buffer_consumer.hpp"
+#include "io/mmap_buffer.hpp"
+#include "core/wire_format.hpp"
+#include "core/latency_trace.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+extern std::atomic<bool> stop_flag;
+extern BroadcastRing<Traced<OrderBookUpdate>> orderbook_ring;
+extern EventCount feed_event;
+HandoffQueue<Traced<TradeMessageBinary>> trade_queue;
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int MESSAGES = 200000;
+constexpr size_t BOOK_DEPTH = 20;
+
+// Calls send(trade, book, trace) for each message, paced gap_ns apart unless zero.
+// Returns the seconds it took.
+template <typename Send>
+static double drive(Send&& send, uint64_t gap_ns) {
+    OrderBookUpdate book;
+    for (size_t k = 0; k < BOOK_DEPTH; ++k) {
+        book.bids.push_back({100.0 - 0.01 * k, 1.0 + k});
+        book.asks.push_back({100.5 + 0.01 * k, 1.0 + k});
+    }
+    TradeMessageBinary trade{};
+    trade.price = 100.2;
+    trade.quantity = 1.0;
+
+    auto start = Clock::now();
+    for (int i = 0; i < MESSAGES; ++i) {
+        if (gap_ns) {
+            auto due = start + std::chrono::nanoseconds(gap_ns * i);
+            while (Clock::now() < due) {
+                std::this_thread::yield();
+            }
+        }
+        TraceStamps trace;
+        trace.received_ns = trace_stamp();
+        trace.parsed_ns = trace.received_ns;
+        uint64_t ts = 1700000000000000000ull + uint64_t(i) * 1000;
+        if (i % 10 == 9) {
+            book.timestamp_ns = ts;
+            book.last_update_id = i;
+            send(nullptr, &book, trace);
+        } else {
+            trade.timestamp_ns = ts;
+            trade.trade_id = i;
+            trade.flags = i % 2;
+            send(&trade, nullptr, trace);
+        }
+    }
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static void report(const char* mode, uint64_t gap_ns, double seconds) {
+    std::printf("%s, gap %llu ns: %d messages, %.0f msg/s\n", mode, (unsigned long long)gap_ns,
+                MESSAGES, MESSAGES / seconds);
+    std::fflush(stdout);
+    print_latency_report(std::cout);
+}
+
+static void run_inline(uint64_t gap_ns) {
+    IcebergDetector iceberg;
+    LiquidityTracker tracker;
+    InlinePipeline pipeline(iceberg, tracker);
+    double seconds = drive([&](const TradeMessageBinary* trade, const OrderBookUpdate* book,
+                               const TraceStamps& trace) {
+        if (trade) {
+            pipeline.on_trade(0, *trade, trace);
+        } else {
+            pipeline.on_orderbook(0, *book, trace);
+        }
+    }, gap_ns);
+    report("inline", gap_ns, seconds);
+}
+
+static void run_threaded(uint64_t gap_ns) {
+    RingOptions options;
+    options.mirrored = true;
+    options.overflow = OVERFLOW_BLOCK;
+    MMapBuffer ring("/binance_pipeline_bench_" + std::to_string(getpid()), 1 << 22, options);
+
+    IcebergDetector iceberg;
+    LiquidityTracker tracker;
+    size_t iceberg_cursor = orderbook_ring.subscribe();
+    size_t liquidity_cursor = orderbook_ring.subscribe();
+    std::thread consumer([&] { consume_ring_buffer(WAIT_SPIN_PARK, options, nullptr, ring.name()); });
+    std::thread iceberg_thread([&] {
+        while (const Traced<OrderBookUpdate>* update = orderbook_ring.wait(iceberg_cursor)) {
+            iceberg.process_update(update->message);
+            orderbook_ring.advance(iceberg_cursor);
+        }
+    });
+    LiquidityFeed feed(tracker, orderbook_ring, liquidity_cursor, trade_queue, feed_event,
+                       std::chrono::milliseconds(0));
+    std::thread liquidity_thread([&] { feed.run(); });
+
+    auto start = Clock::now();
+    drive([&](const TradeMessageBinary* trade, const OrderBookUpdate* book, const TraceStamps& trace) {
+        FrameTrailer trailer{0, trace.received_ns, trace.parsed_ns, trace_stamp()};
+        if (trade) {
+            uint8_t* body = ring.reserve(TYPE_TRADE, sizeof(*trade) + FRAME_TRAILER_SIZE);
+            std::memcpy(body, trade, sizeof(*trade));
+            write_frame_trailer(body, sizeof(*trade), trailer);
+            ring.commit(trade->timestamp_ns);
+        } else {
+            size_t size = orderbook_wire_size(*book);
+            uint8_t* body = ring.reserve(TYPE_ORDERBOOK, size + FRAME_TRAILER_SIZE);
+            serialize_orderbook_into(*book, body);
+            write_frame_trailer(body, size, trailer);
+            ring.commit(book->timestamp_ns);
+        }
+    }, gap_ns);
+    while (feed.delivered_events() < static_cast<uint64_t>(MESSAGES)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    stop_flag = true;
+    consumer.join();
+    orderbook_ring.close();
+    trade_queue.close();
+    feed_event.notify();
+    iceberg_thread.join();
+    liquidity_thread.join();
+    report("threaded", gap_ns, seconds);
+}
+
+int main(int argc, char** argv) {
+    const char* mode = argc > 1 ? argv[1] : "";
+    uint64_t gap_ns = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 0;
+    latency_tracing = true;
+
+    if (!std::strcmp(mode, "inline")) {
+        run_inline(gap_ns);
+    } else if (!std::strcmp(mode, "threaded")) {
+        run_threaded(gap_ns);
+    } else {
+        std::fprintf(stderr, "usage: %s inline|threaded [gap_ns]\n", argv[0]);
+        return 2;
+    }
+    return 0;
+}
@@ -0,0 +1,217 @@
+// Framed handoff throughput and latency of MMapBuffer against the ring it replaced.
+//
+// BaselineRing below is the previous layout, reduced to the framed API: head and tail
+// share a cache line, positions wrap with % capacity, and every call reloads the
+// peer's index. MMapBuffer keeps them on separate lines, masks a power-of-two capacity
+// and only reloads the peer index when its cached copy says full or empty.
+//
+//   ring_buffer_bench [burst|threads] [frames]
+//
+//   burst    one thread writes 16 frames, then drains them (default)
+//   threads  a producer and a consumer thread; run it with the two threads on
+//            separate cores (e.g. taskset -c 2,3) to see the false-sharing cost
+//
+// Each frame is 64 bytes carrying its steady_clock write time; latency is commit to
+// peek. Links against mmap_buffer.cpp and journal.cpp.
+
+#include "io/mmap_buffer.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <optional>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t FRAME_BODY = 64;
+constexpr size_t RING_CAPACITY = 65536;
+constexpr int BURST = 16;
+
+// The previous MMapBuffer framing on a heap buffer
+class BaselineRing {
+public:
+    explicit BaselineRing(size_t capacity) : buffer_(capacity), capacity_(capacity) {}
+
+    uint8_t* try_reserve(uint8_t type, size_t len) {
+        size_t need = FRAME_HEADER_SIZE + len;
+        size_t head = head_.load(std::memory_order_relaxed);
+        size_t tail = tail_.load(std::memory_order_acquire);
+
+        size_t pos = head;
+        if (head >= tail) {
+            size_t to_end = capacity_ - head - (tail == 0 ? 1 : 0);
+            if (need > to_end) {
+                if (need >= tail) {
+                    return nullptr;
+                }
+                if (capacity_ - head >= FRAME_HEADER_SIZE) {
+                    buffer_[head] = PAD;
+                    uint32_t pad_len = static_cast<uint32_t>(capacity_ - head - FRAME_HEADER_SIZE);
+                    std::memcpy(&buffer_[head + 1], &pad_len, sizeof(uint32_t));
+                }
+                pos = 0;
+            }
+        } else if (need > tail - head - 1) {
+            return nullptr;
+        }
+
+        reserve_pos_ = pos;
+        reserve_next_ = (pos + need) % capacity_;
+        reserve_type_ = type;
+        reserve_len_ = static_cast<uint32_t>(len);
+        return &buffer_[pos + FRAME_HEADER_SIZE];
+    }
+
+    void commit() {
+        buffer_[reserve_pos_] = reserve_type_;
+        std::memcpy(&buffer_[reserve_pos_ + 1], &reserve_len_, sizeof(uint32_t));
+        head_.store(reserve_next_, std::memory_order_release);
+    }
+
+    std::optional<RingFrame> peek_frame() {
+        size_t head = head_.load(std::memory_order_acquire);
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        size_t start = tail;
+
+        while (tail != head) {
+            if (capacity_ - tail < FRAME_HEADER_SIZE) {
+                tail = 0;
+                continue;
+            }
+            uint8_t type = buffer_[tail];
+            uint32_t len;
+            std::memcpy(&len, &buffer_[tail + 1], sizeof(uint32_t));
+            if (type == PAD) {
+                tail = 0;
+                continue;
+            }
+            release_pos_ = (tail + FRAME_HEADER_SIZE + len) % capacity_;
+            if (tail != start) {
+                tail_.store(tail, std::memory_order_release);
+            }
+            return RingFrame{type, &buffer_[tail + FRAME_HEADER_SIZE], len};
+        }
+        if (tail != start) {
+            tail_.store(tail, std::memory_order_release);
+        }
+        return std::nullopt;
+    }
+
+    bool release() {
+        tail_.store(release_pos_, std::memory_order_release);
+        return true;
+    }
+
+private:
+    static constexpr uint8_t PAD = 0xFF;
+
+    std::vector<uint8_t> buffer_;
+    size_t capacity_;
+    std::atomic<size_t> head_{0};
+    std::atomic<size_t> tail_{0};
+    size_t reserve_pos_ = 0;
+    size_t reserve_next_ = 0;
+    uint8_t reserve_type_ = 0;
+    uint32_t reserve_len_ = 0;
+    size_t release_pos_ = 0;
+};
+
+static uint64_t now_ns() {
+    return static_cast<uint64_t>(Clock::now().time_since_epoch().count());
+}
+
+template <typename Ring>
+static bool produce(Ring& ring) {
+    uint8_t* body = ring.try_reserve(1, FRAME_BODY);
+    if (!body) {
+        return false;
+    }
+    uint64_t ts = now_ns();
+    std::memcpy(body, &ts, sizeof(ts));
+    ring.commit();
+    return true;
+}
+
+template <typename Ring>
+static bool consume(Ring& ring, std::vector<uint64_t>& latencies) {
+    std::optional<RingFrame> frame = ring.peek_frame();
+    if (!frame) {
+        return false;
+    }
+    uint64_t ts;
+    std::memcpy(&ts, frame->data, sizeof(ts));
+    latencies.push_back(now_ns() - ts);
+    ring.release();
+    return true;
+}
+
+template <typename Ring>
+static double run_burst(Ring& ring, int frames, std::vector<uint64_t>& latencies) {
+    auto start = Clock::now();
+    int produced = 0;
+    int consumed = 0;
+    while (consumed < frames) {
+        for (int k = 0; k < BURST && produced < frames && produce(ring); ++k) {
+            ++produced;
+        }
+        while (consume(ring, latencies)) {
+            ++consumed;
+        }
+    }
+    return frames / std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+template <typename Ring>
+static double run_threads(Ring& ring, int frames, std::vector<uint64_t>& latencies) {
+    auto start = Clock::now();
+    std::thread consumer([&] {
+        for (int consumed = 0; consumed < frames;) {
+            if (consume(ring, latencies)) {
+                ++consumed;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    });
+    for (int produced = 0; produced < frames;) {
+        if (produce(ring)) {
+            ++produced;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    consumer.join();
+    return frames / std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+template <typename Ring>
+static void report(const char* name, Ring& ring, bool threads, int frames) {
+    std::vector<uint64_t> latencies;
+    latencies.reserve(frames);
+    double rate = threads ? run_threads(ring, frames, latencies) : run_burst(ring, frames, latencies);
+    std::sort(latencies.begin(), latencies.end());
+    std::printf("%-12s %6.1f Mframes/s  p50 %6llu ns  p99 %7llu ns\n", name, rate / 1e6,
+                (unsigned long long)latencies[latencies.size() / 2],
+                (unsigned long long)latencies[latencies.size() * 99 / 100]);
+}
+
+int main(int argc, char** argv) {
+    bool threads = argc > 1 && !std::strcmp(argv[1], "threads");
+    if (argc > 1 && !threads && std::strcmp(argv[1], "burst")) {
+        std::fprintf(stderr, "usage: %s [burst|threads] [frames]\n", argv[0]);
+        return 2;
+    }
+    int frames = argc > 2 ? std::atoi(argv[2]) : 2000000;
+
+    for (int round = 0; round < 2; ++round) {
+        BaselineRing baseline(RING_CAPACITY);
+        report("baseline", baseline, threads, frames);
+        MMapBuffer ring(RING_CAPACITY);
+        report("MMapBuffer", ring, threads, frames);
+    }
+    return 0;
+}
@@ -0,0 +1,103 @@
+// Trade decoding cost: Serialization::parse_trade_json (nlohmann) against
+// parse_trade_message, to doubles and to fixed point.
+//
+// First checks that parse_trade_message matches parse_trade_json on 200000 random
+// trade messages, then times each parser on a typical message and counts its heap
+// allocations with a replaced operator new.
+//
+//   trade_parser_bench [iterations]
+//
+// Links against feed_parser.cpp and serialization.cpp. Exits non-zero on a mismatch.
+
+#include "core/feed_parser.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <string>
+
+static size_t allocations = 0;
+
+void* operator new(size_t size) {
+    ++allocations;
+    void* p = std::malloc(size ? size : 1);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+static const std::string TYPICAL_TRADE =
+    R"({"e":"trade","E":1700000000123,"s":"BTCUSDT","t":3012345678,"p":"43251.17000000",)"
+    R"("q":"0.00120000","b":22334455667,"a":22334455668,"T":1700000000120,"m":true,"M":true})";
+
+static bool same(const TradeMessageBinary& a, const TradeMessageBinary& b) {
+    return a.event_time == b.event_time && a.trade_id == b.trade_id && a.price == b.price &&
+           a.quantity == b.quantity && a.buyer_order_id == b.buyer_order_id &&
+           a.seller_order_id == b.seller_order_id && a.trade_time == b.trade_time &&
+           a.timestamp_ns == b.timestamp_ns && a.flags == b.flags;
+}
+
+static int check_random(int count) {
+    std::mt19937_64 rng(1);
+    int mismatches = 0;
+    char buffer[512];
+    for (int i = 0; i < count; ++i) {
+        double price = (rng() % 10000000) / 100.0 + (rng() % 100000000) * 1e-8;
+        double quantity = (rng() % 1000000) * 1e-8;
+        int length = std::snprintf(buffer, sizeof(buffer),
+            R"({"e":"trade","E":%llu,"s":"BTCUSDT","t":%llu,"p":"%.8f","q":"%.8f","b":%llu,"a":%llu,"T":%llu,"m":%s,"M":true})",
+            (unsigned long long)(rng() >> 20), (unsigned long long)(rng() >> 30), price, quantity,
+            (unsigned long long)(rng() >> 30), (unsigned long long)(rng() >> 30),
+            (unsigned long long)(rng() >> 24) + 1, rng() % 2 ? "true" : "false");
+        TradeMessageBinary fast;
+        TradeMessageBinary generic = Serialization::parse_trade_json(std::string(buffer, length));
+        if (!parse_trade_message(buffer, length, fast) || !same(fast, generic)) {
+            if (++mismatches <= 10) {
+                std::printf("MISMATCH %s\n", buffer);
+            }
+        }
+    }
+    return mismatches;
+}
+
+template <typename Parse>
+static void time_parser(const char* name, int iterations, Parse&& parse) {
+    size_t allocations_before = allocations;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        parse();
+    }
+    double elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    std::printf("%-28s %7.1f ns/msg  %5.1f allocations/msg\n", name, elapsed / iterations,
+                double(allocations - allocations_before) / iterations);
+}
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 1000000;
+
+    int mismatches = check_random(200000);
+    std::printf("equivalence: 200000 random trades, %d mismatches\n", mismatches);
+
+    const std::string& message = TYPICAL_TRADE;
+    volatile double sink = 0.0;
+    TradeMessageBinary trade;
+    FixedTrade fixed;
+    SymbolPrecision precision;
+    time_parser("parse_trade_json", iterations, [&] {
+        trade = Serialization::parse_trade_json(message);
+        sink = sink + trade.price;
+    });
+    time_parser("parse_trade_message", iterations, [&] {
+        parse_trade_message(message.data(), message.size(), trade);
+        sink = sink + trade.price;
+    });
+    time_parser("parse_trade_message (fixed)", iterations, [&] {
+        parse_trade_message(message.data(), message.size(), precision, fixed);
+        sink = sink + fixed.price;
+    });
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,91 @@
+// Wake-up latency against consumer CPU for each WaitStrategy.
+//
+// A producer commits one frame every interval (default 200 us), like a quiet feed;
+// the consumer drains the ring and waits with wait_for_data() between frames. The
+// frame carries its steady_clock commit time, so latency is commit to peek, and the
+// consumer's CPU time is read from CLOCK_THREAD_CPUTIME_ID.
+//
+//   wait_strategy_bench [frames] [interval_us]
+//
+// Links against mmap_buffer.cpp and journal.cpp. Run with the two threads on
+// separate cores, or busy-spin will compete with the producer for the CPU.
+
+#include "io/mmap_buffer.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+constexpr char BENCH_RING_NAME[] = "/binance_wait_bench";
+
+static uint64_t now_ns() {
+    return static_cast<uint64_t>(Clock::now().time_since_epoch().count());
+}
+
+static double thread_cpu_seconds() {
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void run(const char* name, WaitStrategy strategy, int frames, std::chrono::microseconds interval) {
+    MMapBuffer producer(BENCH_RING_NAME, 65536);
+    std::unique_ptr<MMapBuffer> consumer = MMapBuffer::attach(BENCH_RING_NAME);
+    std::vector<uint64_t> latencies;
+    latencies.reserve(frames);
+    double cpu = 0.0;
+
+    auto start = Clock::now();
+    std::thread reader([&] {
+        double cpu_start = thread_cpu_seconds();
+        while (static_cast<int>(latencies.size()) < frames) {
+            while (std::optional<RingFrame> frame = consumer->peek_frame()) {
+                uint64_t ts;
+                std::memcpy(&ts, frame->data, sizeof(ts));
+                latencies.push_back(now_ns() - ts);
+                consumer->release();
+            }
+            if (static_cast<int>(latencies.size()) < frames) {
+                consumer->wait_for_data(strategy, std::chrono::milliseconds(100));
+            }
+        }
+        cpu = thread_cpu_seconds() - cpu_start;
+    });
+
+    for (int i = 0; i < frames; ++i) {
+        std::this_thread::sleep_for(interval);
+        uint8_t* body;
+        while (!(body = producer.try_reserve(1, sizeof(uint64_t)))) {
+            std::this_thread::yield();
+        }
+        uint64_t ts = now_ns();
+        std::memcpy(body, &ts, sizeof(ts));
+        producer.commit();
+    }
+    reader.join();
+    double wall = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::sort(latencies.begin(), latencies.end());
+    std::printf("%-10s p50 %8.1f us  p99 %8.1f us  consumer CPU %5.1f%%\n", name,
+                latencies[latencies.size() / 2] / 1e3, latencies[latencies.size() * 99 / 100] / 1e3,
+                100.0 * cpu / wall);
+}
+
+int main(int argc, char** argv) {
+    int frames = argc > 1 ? std::atoi(argv[1]) : 2000;
+    std::chrono::microseconds interval(argc > 2 ? std::atoi(argv[2]) : 200);
+
+    run("busy_spin", WAIT_BUSY_SPIN, frames, interval);
+    run("spin_yield", WAIT_SPIN_YIELD, frames, interval);
+    run("spin_park", WAIT_SPIN_PARK, frames, interval);
+    run("blocking", WAIT_BLOCKING, frames, interval);
+    return 0;
+}
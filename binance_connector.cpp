@@ -2,31 +2,210 @@
 #include <libwebsockets.h>
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <cstring>
-#include <iomanip>  // For std::fixed and std::setprecision
 #include "core/serialization.hpp"
+#include "core/feed_parser.hpp"
+#include "core/wire_format.hpp"
 #include "io/mmap_buffer.hpp"
-#include "core/ts_queue.hpp"
+#include "core/symbol_table.hpp"
+#include "core/async_logger.hpp"
+#include "core/depth_book.hpp"
+#include "io/exchange_info.hpp"
 #include <vector>
 #include <memory>
 #include <algorithm>
 #include <optional>
 #include <stdexcept>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
 
-// External queue declarations
-extern TSQueue<OrderBookUpdate> liquidity_queue;
-extern TSQueue<TradeMessageBinary> trade_queue;
-extern TSQueue<OrderBookUpdate> iceberg_queue;
+// Shared-memory ring the consumer thread (and any attached process) reads the feed from.
+// Created by the BinanceConnector constructor, sized and configured from the pipeline config.
+// Stays empty in run-to-completion mode.
+static std::unique_ptr<MMapBuffer> mmap_buffer;
 
-// Memory-mapped buffer for efficient data storage
-static MMapBuffer mmap_buffer(4096); // Size in bytes, adjust to your needs
+// Subscribed symbols; maps the "s" field of each message to the SymbolId it is tagged with
+static std::unique_ptr<SymbolTable> symbol_table;
 
-// Define message type identifiers
-enum MessageType : uint8_t {
-    TYPE_TRADE = 0x01,
-    TYPE_ORDERBOOK = 0x02
+// Levels a side handed on as a symbol's book after each diff event, as deep as the
+// depth50 partial book stream the detectors were written against
+constexpr size_t PUBLISHED_DEPTH = 50;
+
+// Levels a side asked for in each REST snapshot
+constexpr size_t SNAPSHOT_DEPTH = 1000;
+
+// Wait before asking again after a failed snapshot request
+constexpr std::chrono::seconds SNAPSHOT_RETRY_DELAY(1);
+
+// Local book of one symbol. The book itself is only touched on the network thread.
+// Snapshots are fetched on the snapshot thread, so the socket keeps being read
+// meanwhile, and handed over through snapshot for the symbol's next diff event.
+struct SymbolDepth {
+    DepthBook book;
+    bool requested = false;  // Network thread only: a snapshot is on its way
+    std::atomic<bool> snapshot_ready{false};
+    std::mutex snapshot_mutex;
+    DepthMessage snapshot;   // Guarded by snapshot_mutex
 };
 
+// By SymbolId
+static std::vector<std::unique_ptr<SymbolDepth>> symbol_depth;
+
+// Symbols waiting for a snapshot, fetched in order by the snapshot thread
+static std::mutex snapshot_queue_mutex;
+static std::condition_variable snapshot_queue_cv;
+static std::deque<SymbolId> snapshot_queue;
+static bool snapshot_thread_stop = false;
+
+static void request_snapshot(SymbolId symbol) {
+    {
+        std::lock_guard<std::mutex> lock(snapshot_queue_mutex);
+        snapshot_queue.push_back(symbol);
+    }
+    snapshot_queue_cv.notify_one();
+}
+
+// Serves snapshot_queue until snapshot_thread_stop. A failed request is retried after
+// SNAPSHOT_RETRY_DELAY; the book stays requested until its snapshot arrives.
+static void run_snapshot_thread() {
+    DepthMessage snapshot;
+    std::unique_lock<std::mutex> lock(snapshot_queue_mutex);
+    while (true) {
+        snapshot_queue_cv.wait(lock, [] { return snapshot_thread_stop || !snapshot_queue.empty(); });
+        if (snapshot_thread_stop) {
+            return;
+        }
+        SymbolId symbol = snapshot_queue.front();
+        snapshot_queue.pop_front();
+        lock.unlock();
+
+        const std::string& name = symbol_table->name(symbol);
+        bool fetched = false;
+        try {
+            fetch_depth_snapshot(name, SNAPSHOT_DEPTH, snapshot);
+            fetched = true;
+        } catch (const std::exception& e) {
+            log_event(LOG_WEBSOCKET, LOG_WARN, 0, "[WebSocket] {} depth snapshot failed: {}", name, e.what());
+        }
+        if (fetched) {
+            SymbolDepth& depth = *symbol_depth[symbol];
+            std::lock_guard<std::mutex> guard(depth.snapshot_mutex);
+            std::swap(depth.snapshot, snapshot);
+            depth.snapshot_ready.store(true, std::memory_order_release);
+        }
+
+        lock.lock();
+        if (!fetched) {
+            snapshot_queue_cv.wait_for(lock, SNAPSHOT_RETRY_DELAY, [] { return snapshot_thread_stop; });
+            snapshot_queue.push_back(symbol);
+        }
+    }
+}
+
+// Apply a diff event to the symbol's local book, loading its snapshot first if one has
+// arrived, and ask for a snapshot if the book is unsynced. Returns true, with the best
+// PUBLISHED_DEPTH levels a side in book, if the book is synced and changed.
+static bool update_depth_book(SymbolId symbol, const DepthMessage& diff, OrderBookUpdate& book) {
+    SymbolDepth& depth = *symbol_depth[symbol];
+    bool loaded = false;
+    if (depth.snapshot_ready.load(std::memory_order_acquire)) {
+        std::lock_guard<std::mutex> guard(depth.snapshot_mutex);
+        depth.snapshot_ready.store(false, std::memory_order_relaxed);
+        depth.requested = false;
+        loaded = depth.book.load_snapshot(depth.snapshot);
+        if (!loaded) {
+            log_event(LOG_WEBSOCKET, LOG_WARN, 0, "[WebSocket] {} snapshot at update {} is older than the buffered diffs",
+                      symbol_table->name(symbol), depth.snapshot.final_update_id);
+        }
+    }
+
+    DepthBook::Result result = depth.book.apply(diff);
+    if (result == DepthBook::GAP) {
+        log_event(LOG_WEBSOCKET, LOG_WARN, 0, "[WebSocket] {} depth diff {}-{} skips updates after {}, resyncing",
+                  symbol_table->name(symbol), diff.first_update_id, diff.final_update_id,
+                  depth.book.last_update_id());
+    }
+    if (!depth.book.synced()) {
+        if (!depth.requested) {
+            depth.requested = true;
+            request_snapshot(symbol);
+        }
+        return false;
+    }
+    if (result != DepthBook::APPLIED && !loaded) {
+        return false;
+    }
+
+    depth.book.top_levels(PUBLISHED_DEPTH, book);
+    book.timestamp_ns = diff.event_time * 1000000;  // ms to ns
+    if (book.timestamp_ns == 0) {
+        auto now = std::chrono::high_resolution_clock::now();
+        book.timestamp_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count();
+    }
+    return true;
+}
+
+// Publish a trade straight into a ring reservation, applying the ring's overflow policy.
+// A dropped frame is dropped whole, so the consumer never sees a torn frame.
+static bool publish_trade(SymbolId symbol, const TradeMessageBinary& trade, const TraceStamps& trace) {
+    uint8_t* body = mmap_buffer->reserve(TYPE_TRADE, sizeof(TradeMessageBinary) + FRAME_TRAILER_SIZE);
+    if (!body) {
+        log_event(LOG_WEBSOCKET, LOG_WARN, 0, "[WebSocket] Ring buffer full, dropping trade {} ({} frames dropped)",
+                  trade.trade_id, mmap_buffer->stats().dropped_frames);
+        return false;
+    }
+    std::memcpy(body, &trade, sizeof(TradeMessageBinary));
+    write_frame_trailer(body, sizeof(TradeMessageBinary),
+                        {symbol, trace.received_ns, trace.parsed_ns, trace_stamp()});
+    mmap_buffer->commit(trade.timestamp_ns);
+    return true;
+}
+
+static bool publish_orderbook(SymbolId symbol, const OrderBookUpdate& book, const TraceStamps& trace) {
+    size_t len = orderbook_wire_size(book);
+    uint8_t* body = mmap_buffer->reserve(TYPE_ORDERBOOK, len + FRAME_TRAILER_SIZE);
+    if (!body) {
+        log_event(LOG_WEBSOCKET, LOG_WARN, 0, "[WebSocket] Ring buffer full, dropping {} byte depth update ({} frames dropped)",
+                  len, mmap_buffer->stats().dropped_frames);
+        return false;
+    }
+    serialize_orderbook_into(book, body);
+    write_frame_trailer(body, len, {symbol, trace.received_ns, trace.parsed_ns, trace_stamp()});
+    mmap_buffer->commit(book.timestamp_ns);
+    return true;
+}
+
+// Default handler: frames every message into the feed ring
+class RingPublisher : public FeedHandler {
+public:
+    void on_trade(SymbolId symbol, const TradeMessageBinary& trade, const TraceStamps& trace) override {
+        publish_trade(symbol, trade, trace);
+    }
+    void on_orderbook(SymbolId symbol, const OrderBookUpdate& book, const TraceStamps& trace) override {
+        publish_orderbook(symbol, book, trace);
+    }
+};
+
+static RingPublisher ring_publisher;
+
+// Where callback_ws sends parsed messages; set by the BinanceConnector constructor
+static FeedHandler* feed_handler = &ring_publisher;
+
+// Symbol named by the message's "s" field. A single-symbol feed does not need one.
+static std::optional<SymbolId> message_symbol(std::string_view name) {
+    if (name.empty()) {
+        if (symbol_table->size() == 1) {
+            return SymbolId(0);
+        }
+        return std::nullopt;
+    }
+    return symbol_table->find(name);
+}
+
 // WebSocket callback function
 static int callback_ws(struct lws *wsi, enum lws_callback_reasons reason,
                        void *user, void *in, size_t len) {
@@ -36,33 +215,62 @@ static int callback_ws(struct lws *wsi, enum lws_callback_reasons reason,
             break;
 
         case LWS_CALLBACK_CLIENT_RECEIVE: {
-            std::string json_str(reinterpret_cast<char*>(in), len);
+            TraceStamps trace;
+            trace.received_ns = trace_stamp();
+
+            // The payload is read in place: the header gives the event type and symbol,
+            // then exactly one parser runs over it. Only the generic trade parser gets a
+            // copy. The decoded diff and the book handed on are reused across messages
+            // (the callback only runs on the network thread), so they stop allocating
+            // once warmed up.
+            static DepthMessage depth_diff;
+            static OrderBookUpdate depth_update;
+            const char* data = static_cast<const char*>(in);
+            std::string_view payload(data, len);
 
             try {
-                // Check if this is a trade message
-                if (json_str.find("\"e\":\"trade\"") != std::string::npos) {
-                    TradeMessageBinary trade_msg = Serialization::parse_trade_json(json_str);
-                    trade_queue.push(trade_msg);
-                    std::cout << "[DEBUG] Trade message received: Price = " << trade_msg.price
-                              << ", Quantity = " << trade_msg.quantity
-                              << ", IsBuy = " << trade_msg.is_buy() << std::endl;
+                EventHeader header = read_event_header(data, len);
+                std::optional<SymbolId> symbol = message_symbol(header.symbol);
+                if (!symbol.has_value()) {
+                    log_event(LOG_WEBSOCKET, LOG_WARN, 0, "[WebSocket] Message for an unsubscribed symbol: {}", payload);
+                    break;
                 }
-                // Check if this is an order book update
-                else if (json_str.find("\"e\":\"depthUpdate\"") != std::string::npos) {
-                    std::cout << "[DEBUG] Received depth update JSON: " << json_str << std::endl;
-
-                    auto book_opt = Serialization::parse_orderbook_json(json_str);
-                    if (!book_opt.has_value()) {
-                        std::cerr << "[ERROR] Failed to parse depth update JSON: " << json_str << std::endl;
-                    } else {
-                        OrderBookUpdate book = book_opt.value();
-                        liquidity_queue.push(book);
-                        iceberg_queue.push(book);
-                        std::cout << "[DEBUG] Parsed depth update and pushed to queues." << std::endl;
+
+                switch (header.type) {
+                    case FeedEvent::TRADE: {
+                        // Single pass over the raw payload; layouts it does not expect go
+                        // through the generic parser instead
+                        TradeMessageBinary trade_msg;
+                        if (!parse_trade_message(data, len, trade_msg)) {
+                            trade_msg = Serialization::parse_trade_json(std::string(payload));
+                        }
+                        trace.parsed_ns = trace_stamp();
+                        feed_handler->on_trade(*symbol, trade_msg, trace);
+                        log_event(LOG_WEBSOCKET, LOG_DEBUG, 0, "[DEBUG] Trade message received: Price = {}, Quantity = {}, IsBuy = {}",
+                                  trade_msg.price, trade_msg.quantity, trade_msg.is_buy());
+                        break;
                     }
+
+                    case FeedEvent::DEPTH_UPDATE:
+                        log_event(LOG_WEBSOCKET, LOG_DEBUG, 0, "[DEBUG] Received depth update JSON: {}", payload);
+
+                        // A diff, zero-quantity removals included, so no generic fallback:
+                        // parse_orderbook_json_into drops those. The detectors get the
+                        // symbol's local book instead, once it is synced.
+                        if (!parse_depth_message(data, len, depth_diff)) {
+                            log_event(LOG_WEBSOCKET, LOG_ERROR, 0, "[ERROR] Failed to parse depth update JSON: {}", payload);
+                        } else if (update_depth_book(*symbol, depth_diff, depth_update)) {
+                            trace.parsed_ns = trace_stamp();
+                            feed_handler->on_orderbook(*symbol, depth_update, trace);
+                            log_event(LOG_WEBSOCKET, LOG_DEBUG, 0, "[DEBUG] Applied depth update and handed the book on.");
+                        }
+                        break;
+
+                    case FeedEvent::UNKNOWN:
+                        break;
                 }
             } catch (const std::exception& e) {
-                std::cerr << "[Error] Failed to process WebSocket message: " << e.what() << std::endl;
+                log_event(LOG_WEBSOCKET, LOG_ERROR, 0, "[Error] Failed to process WebSocket message: {}", e.what());
             }
 
             break;
@@ -109,7 +317,7 @@ void BinanceConnector::run() {
     ccinfo.context = context;
     ccinfo.address = "stream.binance.us";
     ccinfo.port = 9443;
-    ccinfo.path = "/ws/btcusdt@trade/btcusdt@depth50@100ms"; // Combined trade and depth streams
+    ccinfo.path = stream_path.c_str(); // Combined trade and depth streams
     ccinfo.host = ccinfo.address;
     ccinfo.origin = "origin";
     ccinfo.protocol = protocols[0].name;
@@ -123,19 +331,75 @@ void BinanceConnector::run() {
 
     running = true;
 
+    {
+        std::lock_guard<std::mutex> lock(snapshot_queue_mutex);
+        snapshot_thread_stop = false;
+    }
+    std::thread snapshot_thread(run_snapshot_thread);
+
     while (running) {
         lws_service(context, 100);
     }
 
+    {
+        std::lock_guard<std::mutex> lock(snapshot_queue_mutex);
+        snapshot_thread_stop = true;
+    }
+    snapshot_queue_cv.notify_one();
+    snapshot_thread.join();
+
     lws_context_destroy(context);
 }
 
-BinanceConnector::BinanceConnector() {
+// Mirrored so frames never need wrap padding and can be parsed in place at any offset
+static RingOptions default_ring_options() {
+    RingOptions options;
+    options.mirrored = true;
+    return options;
+}
+
+BinanceConnector::BinanceConnector()
+    : BinanceConnector(DEFAULT_FEED_RING_CAPACITY, default_ring_options()) {
+}
+
+BinanceConnector::BinanceConnector(size_t ring_capacity, const RingOptions& ring_options,
+                                   const std::vector<std::string>& symbols) {
+    running = false;
+    set_symbols(symbols);
+    mmap_buffer = std::make_unique<MMapBuffer>(FEED_RING_NAME, ring_capacity, ring_options);
+    feed_handler = &ring_publisher;
+}
+
+BinanceConnector::BinanceConnector(FeedHandler& handler, const std::vector<std::string>& symbols) {
     running = false;
+    set_symbols(symbols);
+    feed_handler = &handler;
+}
+
+void BinanceConnector::set_symbols(const std::vector<std::string>& symbols) {
+    symbol_table = std::make_unique<SymbolTable>(symbols);
+    symbol_depth.clear();
+    for (size_t i = 0; i < symbol_table->size(); ++i) {
+        symbol_depth.push_back(std::make_unique<SymbolDepth>());
+    }
+
+    // Stream names are lower case: /ws/btcusdt@trade/btcusdt@depth@100ms/...
+    // The diff depth stream is used because its events name their symbol ("s") and
+    // type ("e"); partial book depth payloads carry neither, so on a raw stream with
+    // several symbols they could not be routed. Each symbol's DepthBook turns the
+    // diffs back into full books for the detectors.
+    stream_path = "/ws";
+    for (const std::string& symbol : symbols) {
+        std::string name = symbol;
+        std::transform(name.begin(), name.end(), name.begin(),
+                       [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        stream_path += "/" + name + "@trade/" + name + "@depth@100ms";
+    }
 }
 
 BinanceConnector::~BinanceConnector() {
     stop();
+    feed_handler = &ring_publisher;
 }
 
 void BinanceConnector::start() {
@@ -146,3 +410,7 @@ void BinanceConnector::start() {
 void BinanceConnector::stop() {
     running = false;
 }
+
+RingStats BinanceConnector::ring_stats() const {
+    return mmap_buffer ? mmap_buffer->stats() : RingStats();
+}
@@ -6,6 +6,14 @@
 #include <atomic>
 #include <functional>
 #include <vector>
+#include <cstddef>
+#include "io/mmap_buffer.hpp"
+#include "core/serialization.hpp"
+#include "core/wire_format.hpp"
+#include "core/latency_trace.hpp"
+
+// Symbol subscribed to when none is configured
+constexpr char DEFAULT_SYMBOL[] = "btcusdt";
 
 struct BinanceTrade {
     double price;
@@ -25,9 +33,29 @@ struct BinanceDepthUpdate {
     uint64_t timestamp;
 };
 
+// Receives every parsed message on the network thread, inside the libwebsockets
+// receive callback. Implementations must not block: the socket is not read meanwhile.
+// trace carries the stamps taken so far (see latency_trace.hpp). on_orderbook gets the
+// best levels of the symbol's full book, kept from its diff stream, after each diff.
+class FeedHandler {
+public:
+    virtual ~FeedHandler() = default;
+    virtual void on_trade(SymbolId symbol, const TradeMessageBinary& trade, const TraceStamps& trace) = 0;
+    virtual void on_orderbook(SymbolId symbol, const OrderBookUpdate& book, const TraceStamps& trace) = 0;
+};
+
 class BinanceConnector {
 public:
     BinanceConnector();
+    // Creates the shared feed ring with the given size and overflow behaviour and
+    // publishes every message into it for the consumer thread. Subscribes to the trade
+    // and depth streams of every symbol; SymbolIds follow the order of symbols.
+    BinanceConnector(size_t ring_capacity, const RingOptions& ring_options,
+                     const std::vector<std::string>& symbols = {DEFAULT_SYMBOL});
+    // Run-to-completion: hands every message straight to handler, no ring or queues.
+    // handler must outlive the connector.
+    explicit BinanceConnector(FeedHandler& handler,
+                              const std::vector<std::string>& symbols = {DEFAULT_SYMBOL});
     ~BinanceConnector();
 
     void start();
@@ -36,14 +64,19 @@ public:
     void set_trade_callback(std::function<void(const BinanceTrade&)> cb);
     void set_depth_callback(std::function<void(const BinanceDepthUpdate&)> cb);
 
+    // Overflow counters of the feed ring; all zero in run-to-completion mode
+    RingStats ring_stats() const;
+
 private:
     std::thread ws_thread;
     std::atomic<bool> running;
+    std::string stream_path;
 
     std::function<void(const BinanceTrade&)> trade_cb;
     std::function<void(const BinanceDepthUpdate&)> depth_cb;
 
     void run();
+    void set_symbols(const std::vector<std::string>& symbols);
 };
 
 #endif // BINANCE_CONNECTOR_HPP
@@ -2,6 +2,7 @@
 #include <map>
 #include <vector>
 #include <string>
+#include <string_view>
 #include <jsoncpp/json/json.h>
 #include <thread>
 #include <mutex>
@@ -17,6 +18,9 @@
 #include <chrono>
 #include <ctime>
 #include <deque>
+#include "core/feed_parser.hpp"
+#include "core/pipeline_config.hpp"
+#include "io/exchange_info.hpp"
 
 // Helper function for libcurl to write response data to a string
 size_t WriteCallback(void* contents, size_t size, size_t nmemb, std::string* s) {
@@ -33,8 +37,11 @@ size_t WriteCallback(void* contents, size_t size, size_t nmemb, std::string* s)
 class BinanceOrderBook {
 private:
     // Order book data
-    std::map<double, std::pair<double, std::string>> bids;  // price -> {quantity, source}
-    std::map<double, std::pair<double, std::string>> asks;  // price -> {quantity, source}
+    // Levels are keyed by tick index (see price_tick), so equal prices always share a key,
+    // and hold their quantity in lots, exactly as decoded
+    using BookSide = std::map<int64_t, std::pair<int64_t, std::string>>;
+    BookSide bids;  // tick -> {quantity lots, source}
+    BookSide asks;  // tick -> {quantity lots, source}
     std::mutex orderbook_mutex;
     std::string user_login = "trader857ok";
 
@@ -54,8 +61,8 @@ private:
     const size_t max_trades_to_store = 20;
     
     // Volume tracking
-    double cumulative_buy_volume_btc = 0.0;    // BTC volume
-    double cumulative_sell_volume_btc = 0.0;   // BTC volume
+    int64_t cumulative_buy_lots = 0;           // BTC volume, in lots
+    int64_t cumulative_sell_lots = 0;          // BTC volume, in lots
     double cumulative_buy_volume_usd = 0.0;    // USD volume (price * quantity)
     double cumulative_sell_volume_usd = 0.0;   // USD volume (price * quantity)
     
@@ -91,14 +98,14 @@ private:
         // Sum up USD values on ask side (limited to specified levels)
         int count = 0;
         for (auto it = asks.begin(); it != asks.end() && count < levels; ++it, ++count) {
-            double usd_value = it->first * it->second.first;  // price * quantity
+            double usd_value = tick_price(it->first) * lots_quantity(it->second.first);  // price * quantity
             total_ask_volume_usd += usd_value;
         }
         
         // Sum up USD values on bid side (limited to specified levels)
         count = 0;
         for (auto it = bids.rbegin(); it != bids.rend() && count < levels; ++it, ++count) {
-            double usd_value = it->first * it->second.first;  // price * quantity
+            double usd_value = tick_price(it->first) * lots_quantity(it->second.first);  // price * quantity
             total_bid_volume_usd += usd_value;
         }
         
@@ -135,10 +142,10 @@ private:
         
         // Calculate basic metrics
         if (!bids.empty()) {
-            cached_metrics.best_bid = bids.rbegin()->first;
+            cached_metrics.best_bid = tick_price(bids.rbegin()->first);
         }
         if (!asks.empty()) {
-            cached_metrics.best_ask = asks.begin()->first;
+            cached_metrics.best_ask = tick_price(asks.begin()->first);
         }
         
         if (cached_metrics.best_bid > 0 && cached_metrics.best_ask > 0) {
@@ -157,10 +164,10 @@ private:
             std::vector<std::pair<double, double>> ask_copy, bid_copy;
             
             for (auto it = asks.begin(); it != asks.end(); ++it)
-                ask_copy.emplace_back(it->first, it->second.first);
+                ask_copy.emplace_back(tick_price(it->first), lots_quantity(it->second.first));
                 
             for (auto it = bids.begin(); it != bids.end(); ++it)
-                bid_copy.emplace_back(it->first, it->second.first);
+                bid_copy.emplace_back(tick_price(it->first), lots_quantity(it->second.first));
             
             // Calculate metrics from copied data
             double ask_volume_2 = 0.0, bid_volume_2 = 0.0;
@@ -228,6 +235,7 @@ private:
 
     // Configuration
     double tick_size = 0.0100;
+    int64_t tick_units = 1;  // tick_size in price units of precision
     std::vector<double> available_tick_sizes = {0.001, 0.01, 0.1, 1.0, 10.0, 100.0};
     const std::string symbol = "btcusdt";
     
@@ -236,6 +244,7 @@ private:
     struct lws *wsi = nullptr;
     std::string ws_buffer;
     std::atomic<uint64_t> last_update_id{0};
+    FixedDepthMessage depth_message;  // Last diff update, reused so its level arrays stay allocated
     
     // Threading
     std::atomic<bool> is_running{false};
@@ -246,10 +255,31 @@ private:
     static BinanceOrderBook* instance;
     static struct lws_protocols protocols[];
 
-    // Round price to current tick size
-    double round_to_tick_size(double price) {
-        if (std::abs(tick_size) < 1e-9) return price;
-        return std::round(price / tick_size) * tick_size;
+    // Decimals prices and quantities are decoded at, from BINANCE_PRECISION or the
+    // exchange's tick and step sizes. Every price and quantity is converted exactly;
+    // one with more decimals is rejected.
+    SymbolPrecision precision;
+    uint64_t skipped_levels = 0;  // Websocket levels out of fixed-point range at precision
+
+    // Index of the tick nearest to a price in units: the integer form of
+    // round(price / tick_size)
+    int64_t price_tick(int64_t price_units) const {
+        return nearest_step(price_units, tick_units);
+    }
+
+    // Ticks only come from price_tick on in-range units, so the product cannot overflow
+    double tick_price(int64_t tick) const {
+        return fixed_to_double(tick * tick_units, precision.price_decimals);
+    }
+
+    double lots_quantity(int64_t lots) const {
+        return fixed_to_double(lots, precision.quantity_decimals);
+    }
+
+    // A decimal string from the REST API or jsoncpp, converted as the websocket parsers do,
+    // and within MAX_FIXED_UNITS so the tick arithmetic cannot overflow
+    static bool parse_units(const std::string& text, unsigned decimals, int64_t& units) {
+        return parse_fixed_point(text.data(), text.size(), decimals, units) && in_fixed_range(units);
     }
     
     // Update time-windowed volume data
@@ -340,21 +370,36 @@ private:
                     asks.clear();
 
                     // Process bids
+                    size_t rejected = 0;
                     const Json::Value& bids_json = root["bids"];
                     for (const auto& bid : bids_json) {
-                        double price = std::stod(bid[0].asString());
-                        double quantity = std::stod(bid[1].asString());
-                        price = round_to_tick_size(price);
-                        if (quantity > 0) bids[price] = std::make_pair(quantity, "API");
+                        int64_t price;
+                        int64_t quantity;
+                        if (!parse_units(bid[0].asString(), precision.price_decimals, price) ||
+                            !parse_units(bid[1].asString(), precision.quantity_decimals, quantity)) {
+                            ++rejected;
+                            continue;
+                        }
+                        if (quantity > 0) bids[price_tick(price)] = std::make_pair(quantity, "API");
                     }
 
                     // Process asks
                     const Json::Value& asks_json = root["asks"];
                     for (const auto& ask : asks_json) {
-                        double price = std::stod(ask[0].asString());
-                        double quantity = std::stod(ask[1].asString());
-                        price = round_to_tick_size(price);
-                        if (quantity > 0) asks[price] = std::make_pair(quantity, "API");
+                        int64_t price;
+                        int64_t quantity;
+                        if (!parse_units(ask[0].asString(), precision.price_decimals, price) ||
+                            !parse_units(ask[1].asString(), precision.quantity_decimals, quantity)) {
+                            ++rejected;
+                            continue;
+                        }
+                        if (quantity > 0) asks[price_tick(price)] = std::make_pair(quantity, "API");
+                    }
+
+                    if (rejected > 0) {
+                        std::cerr << "Skipped " << rejected << " snapshot levels with more decimals than "
+                                  << unsigned(precision.price_decimals) << ":" << unsigned(precision.quantity_decimals)
+                                  << " (BINANCE_PRECISION) or out of range" << std::endl;
                     }
                 } // Lock is released here!
                 
@@ -366,173 +411,231 @@ private:
         }
     }
 
-    // Message router to handle different types of WebSocket messages
-    void process_ws_message(const std::string& message) {
+    // Message router to handle different types of WebSocket messages. The event type
+    // is read off the front of the payload, so each message is parsed once, by its
+    // own handler.
+    void process_ws_message(std::string_view message) {
         try {
-            Json::Value root;
-            Json::CharReaderBuilder readerBuilder;
-            std::unique_ptr<Json::CharReader> const jsonReader(readerBuilder.newCharReader());
-            std::string errs;
+            EventHeader header = read_event_header(message.data(), message.size());
 
-            if (!jsonReader->parse(message.c_str(), message.c_str() + message.length(), &root, &errs)) {
-                std::cerr << "Failed to parse WebSocket JSON: " << errs << std::endl;
-                return;
-            }
-
-            // Route message based on event type
-            if (root.isMember("e")) {
-                std::string event_type = root["e"].asString();
-                
-                if (event_type == "depthUpdate") {
+            switch (header.type) {
+                case FeedEvent::DEPTH_UPDATE:
                     process_ws_update(message);
-                } else if (event_type == "trade") {
+                    break;
+                case FeedEvent::TRADE:
                     process_trade_message(message);
-                } else {
-                    std::cerr << "Unknown event type: " << event_type << std::endl;
-                }
-            } else {
-                std::cerr << "Message missing event type field" << std::endl;
+                    break;
+                case FeedEvent::UNKNOWN:
+                    if (header.name.empty()) {
+                        std::cerr << "Message missing event type field" << std::endl;
+                    } else {
+                        std::cerr << "Unknown event type: " << header.name << std::endl;
+                    }
+                    break;
             }
         } catch (const std::exception& e) {
             std::cerr << "Error in message router: " << e.what() << std::endl;
         }
     }
 
+    // Generic jsoncpp decoding of a depth update, for layouts parse_depth_message rejects
+    bool parse_depth_json(std::string_view message, FixedDepthMessage& depth) {
+        Json::Value root;
+        Json::CharReaderBuilder readerBuilder;
+        std::unique_ptr<Json::CharReader> const jsonReader(readerBuilder.newCharReader());
+        std::string errs;
+
+        if (!jsonReader->parse(message.data(), message.data() + message.size(), &root, &errs)) {
+            std::cerr << "Failed to parse WebSocket JSON: " << errs << std::endl;
+            return false;
+        }
+
+        // Ensure this is a depth update message with the right fields
+        if (!(root.isMember("e") && root["e"].asString() == "depthUpdate" &&
+              root.isMember("u") && root.isMember("b") && root.isMember("a"))) {
+            return false;
+        }
+
+        depth.event_time = root["E"].asUInt64();
+        depth.first_update_id = root["U"].asUInt64();
+        depth.final_update_id = root["u"].asUInt64();
+        return parse_levels_json(root["b"], depth.bids) && parse_levels_json(root["a"], depth.asks);
+    }
+
+    bool parse_levels_json(const Json::Value& levels_json, FixedDepthLevels& levels) {
+        levels.clear();
+        for (const auto& level : levels_json) {
+            int64_t price;
+            int64_t quantity;
+            if (!parse_units(level[0].asString(), precision.price_decimals, price) ||
+                !parse_units(level[1].asString(), precision.quantity_decimals, quantity)) {
+                std::cerr << "Depth level " << level[0].asString() << " " << level[1].asString()
+                          << " has more decimals than BINANCE_PRECISION allows or is out of range" << std::endl;
+                return false;
+            }
+            levels.prices.push_back(price);
+            levels.quantities.push_back(quantity);
+        }
+        return true;
+    }
+
+    // Apply one side of a diff update: a zero quantity removes the level. Levels beyond
+    // MAX_FIXED_UNITS, which the websocket parser lets through, are skipped and counted;
+    // the first one is reported.
+    void apply_depth_levels(const FixedDepthLevels& levels, BookSide& side) {
+        for (size_t i = 0; i < levels.size(); ++i) {
+            if (!in_fixed_range(levels.prices[i]) || !in_fixed_range(levels.quantities[i])) {
+                if (skipped_levels++ == 0) {
+                    std::cerr << "Skipping depth levels out of range at " << unsigned(precision.price_decimals)
+                              << ":" << unsigned(precision.quantity_decimals)
+                              << " decimals; give the symbol a coarser BINANCE_PRECISION" << std::endl;
+                }
+                continue;
+            }
+            int64_t tick = price_tick(levels.prices[i]);
+            int64_t quantity = levels.quantities[i];
+
+            if (quantity > 0) {
+                side[tick] = std::make_pair(quantity, "WS");
+            } else {
+                side.erase(tick);
+            }
+        }
+    }
+
     // FIXED: Process WebSocket diff updates - NO MORE DEADLOCK
-    void process_ws_update(const std::string& message) {
+    void process_ws_update(std::string_view message) {
         try {
             if (message.length() < 2) {
                 return;
             }
-            
-            Json::Value root;
-            Json::CharReaderBuilder readerBuilder;
-            std::unique_ptr<Json::CharReader> const jsonReader(readerBuilder.newCharReader());
-            std::string errs;
 
-            if (!jsonReader->parse(message.c_str(), message.c_str() + message.length(), &root, &errs)) {
-                std::cerr << "Failed to parse WebSocket JSON: " << errs << std::endl;
+            // Levels decode straight into the reused arrays of depth_message; the
+            // jsoncpp path only sees layouts the fast parser does not expect
+            if (!parse_depth_message(message.data(), message.size(), precision, depth_message) &&
+                !parse_depth_json(message, depth_message)) {
                 return;
             }
 
-            // Ensure this is a depth update message with the right fields
-            if (root.isMember("e") && root["e"].asString() == "depthUpdate" && 
-                root.isMember("u") && root.isMember("b") && root.isMember("a")) {
-                
-                // Get the update ID and first/last update IDs
-                uint64_t update_id = root["u"].asUInt64();
-                uint64_t first_update_id = root["U"].asUInt64();
-                
-                // Check if this update is valid for our current state
-                uint64_t current_last_id = last_update_id.load();
-                
-                if (update_id <= current_last_id) {
-                    // This is an old update, skip it
-                    return;
-                }
-                
-                if (first_update_id <= current_last_id + 1) {
-                    // FIXED: Scope the lock properly to avoid deadlock
-                    {
-                        std::lock_guard<std::mutex> lock(orderbook_mutex);
-                        
-                        // Process bids updates
-                        const Json::Value& bids_json = root["b"];
-                        for (const auto& bid : bids_json) {
-                            double price = std::stod(bid[0].asString());
-                            double quantity = std::stod(bid[1].asString());
-                            price = round_to_tick_size(price);
-                            
-                            if (quantity > 0) {
-                                bids[price] = std::make_pair(quantity, "WS");
-                            } else {
-                                bids.erase(price);
-                            }
-                        }
-                        
-                        // Process asks updates
-                        const Json::Value& asks_json = root["a"];
-                        for (const auto& ask : asks_json) {
-                            double price = std::stod(ask[0].asString());
-                            double quantity = std::stod(ask[1].asString());
-                            price = round_to_tick_size(price);
-                            
-                            if (quantity > 0) {
-                                asks[price] = std::make_pair(quantity, "WS");
-                            } else {
-                                asks.erase(price);
-                            }
-                        }
-                        
-                        // Update our last update ID
-                        last_update_id.store(update_id);
-                    } // Lock is released here!
-                    
-                    // Print the updated order book AFTER releasing the lock
-                    print_orderbook();
-                } else {
-                    // Out of sync, need to re-fetch the snapshot
-                    std::cout << "Order book out of sync. Fetching new snapshot..." << std::endl;
-                    fetch_api_snapshot();
-                }
+            // Get the update ID and first/last update IDs
+            uint64_t update_id = depth_message.final_update_id;
+            uint64_t first_update_id = depth_message.first_update_id;
+
+            // Check if this update is valid for our current state
+            uint64_t current_last_id = last_update_id.load();
+
+            if (update_id <= current_last_id) {
+                // This is an old update, skip it
+                return;
+            }
+
+            if (first_update_id <= current_last_id + 1) {
+                // FIXED: Scope the lock properly to avoid deadlock
+                {
+                    std::lock_guard<std::mutex> lock(orderbook_mutex);
+
+                    apply_depth_levels(depth_message.bids, bids);
+                    apply_depth_levels(depth_message.asks, asks);
+
+                    // Update our last update ID
+                    last_update_id.store(update_id);
+                } // Lock is released here!
+
+                // Print the updated order book AFTER releasing the lock
+                print_orderbook();
+            } else {
+                // Out of sync, need to re-fetch the snapshot
+                std::cout << "Order book out of sync. Fetching new snapshot..." << std::endl;
+                fetch_api_snapshot();
             }
         } catch (const std::exception& e) {
             std::cerr << "Error processing WebSocket update: " << e.what() << std::endl;
         }
     }
     
+    // Generic jsoncpp decoding of a trade, for layouts parse_trade_message rejects
+    bool parse_trade_json(std::string_view message, FixedTrade& fixed) {
+        Json::Value root;
+        Json::CharReaderBuilder readerBuilder;
+        std::unique_ptr<Json::CharReader> const jsonReader(readerBuilder.newCharReader());
+        std::string errs;
+
+        if (!jsonReader->parse(message.data(), message.data() + message.size(), &root, &errs)) {
+            std::cerr << "Failed to parse trade JSON: " << errs << std::endl;
+            return false;
+        }
+
+        // Ensure this is a trade message
+        if (!(root.isMember("e") && root["e"].asString() == "trade")) {
+            return false;
+        }
+
+        if (!parse_units(root["p"].asString(), precision.price_decimals, fixed.price) ||
+            !parse_units(root["q"].asString(), precision.quantity_decimals, fixed.quantity)) {
+            std::cerr << "Trade price or quantity has more decimals than BINANCE_PRECISION allows or is out of range" << std::endl;
+            return false;
+        }
+        TradeMessageBinary& trade = fixed.trade;
+        trade = TradeMessageBinary{};
+        trade.trade_id = root["t"].asUInt64();
+        trade.price = fixed_to_double(fixed.price, precision.price_decimals);
+        trade.quantity = lots_quantity(fixed.quantity);
+        trade.trade_time = root["T"].asUInt64();
+        bool is_buyer_maker = root["m"].asBool();
+        trade.set_is_buyer_maker(is_buyer_maker);
+        trade.set_is_buy(!is_buyer_maker);
+        return true;
+    }
+
     // Process trade message from WebSocket
-    void process_trade_message(const std::string& message) {
+    void process_trade_message(std::string_view message) {
         try {
-            Json::Value root;
-            Json::CharReaderBuilder readerBuilder;
-            std::unique_ptr<Json::CharReader> const jsonReader(readerBuilder.newCharReader());
-            std::string errs;
-
-            if (!jsonReader->parse(message.c_str(), message.c_str() + message.length(), &root, &errs)) {
-                std::cerr << "Failed to parse trade JSON: " << errs << std::endl;
+            FixedTrade fixed;
+            if (!parse_trade_message(message.data(), message.size(), precision, fixed) &&
+                !parse_trade_json(message, fixed)) {
                 return;
             }
+            if (!in_fixed_range(fixed.price) || !in_fixed_range(fixed.quantity)) {
+                return;  // Beyond MAX_FIXED_UNITS the lot totals could overflow
+            }
+            const TradeMessageBinary& trade = fixed.trade;
+
+            std::lock_guard<std::mutex> lock(trades_mutex);
             
-            // Ensure this is a trade message
-            if (root.isMember("e") && root["e"].asString() == "trade") {
-                std::lock_guard<std::mutex> lock(trades_mutex);
-                
-                // Extract trade data
-                uint64_t trade_id = root["t"].asUInt64();  // Trade ID
-                double price = std::stod(root["p"].asString());  // Price
-                double quantity = std::stod(root["q"].asString());  // Quantity
-                bool is_buyer_maker = root["m"].asBool();  // Is buyer maker
-                
-                // Calculate USD value
-                double usd_value = price * quantity;
-                
-                // Convert timestamp to readable time
-                uint64_t timestamp_ms = root["T"].asUInt64();
-                auto trade_time = std::chrono::system_clock::time_point(
-                    std::chrono::milliseconds(timestamp_ms));
-                    
-                auto time_t_timestamp = std::chrono::system_clock::to_time_t(trade_time);
-                std::tm* tm_time = std::localtime(&time_t_timestamp);  // Pass the time_t pointer
-                char time_buffer[32];
-                std::strftime(time_buffer, sizeof(time_buffer), "%H:%M:%S", tm_time);
-                std::string time_str = time_buffer;
-                
-                // Update volume statistics
-                if (!is_buyer_maker) {  // Market buy
-                    cumulative_buy_volume_btc += quantity;
-                    cumulative_buy_volume_usd += usd_value;
-                    update_time_windows(quantity, 0.0, usd_value, 0.0, trade_time);
-                } else {  // Market sell
-                    cumulative_sell_volume_btc += quantity;
-                    cumulative_sell_volume_usd += usd_value;
-                    update_time_windows(0.0, quantity, 0.0, usd_value, trade_time);
-                }
+            // Extract trade data
+            uint64_t trade_id = trade.trade_id;  // Trade ID
+            double price = trade.price;  // Price
+            double quantity = trade.quantity;  // Quantity
+            bool is_buyer_maker = !trade.is_buy();  // Is buyer maker
+            
+            // Calculate USD value
+            double usd_value = price * quantity;
+            
+            // Convert timestamp to readable time
+            uint64_t timestamp_ms = trade.trade_time;
+            auto trade_time = std::chrono::system_clock::time_point(
+                std::chrono::milliseconds(timestamp_ms));
                 
-                // Add to recent trades using the ring buffer
-                recent_trades[trade_head] = Trade{trade_id, price, quantity, is_buyer_maker, trade_time, time_str};
-                trade_head = (trade_head + 1) % max_trades_to_store;
+            auto time_t_timestamp = std::chrono::system_clock::to_time_t(trade_time);
+            std::tm* tm_time = std::localtime(&time_t_timestamp);  // Pass the time_t pointer
+            char time_buffer[32];
+            std::strftime(time_buffer, sizeof(time_buffer), "%H:%M:%S", tm_time);
+            std::string time_str = time_buffer;
+            
+            // Update volume statistics
+            if (!is_buyer_maker) {  // Market buy
+                cumulative_buy_lots += fixed.quantity;
+                cumulative_buy_volume_usd += usd_value;
+                update_time_windows(quantity, 0.0, usd_value, 0.0, trade_time);
+            } else {  // Market sell
+                cumulative_sell_lots += fixed.quantity;
+                cumulative_sell_volume_usd += usd_value;
+                update_time_windows(0.0, quantity, 0.0, usd_value, trade_time);
             }
+            
+            // Add to recent trades using the ring buffer
+            recent_trades[trade_head] = Trade{trade_id, price, quantity, is_buyer_maker, trade_time, time_str};
+            trade_head = (trade_head + 1) % max_trades_to_store;
         } catch (const std::exception& e) {
             std::cerr << "Error processing trade message: " << e.what() << std::endl;
         }
@@ -575,9 +678,9 @@ private:
         std::cout << "\n--- VOLUME METRICS ---" << std::endl;
         // BTC volume display
         std::cout << "Total Buy Volume (BTC): " << std::fixed << std::setprecision(5) 
-                  << cumulative_buy_volume_btc << " BTC" << std::endl;
+                  << lots_quantity(cumulative_buy_lots) << " BTC" << std::endl;
         std::cout << "Total Sell Volume (BTC): " << std::fixed << std::setprecision(5) 
-                  << cumulative_sell_volume_btc << " BTC" << std::endl;
+                  << lots_quantity(cumulative_sell_lots) << " BTC" << std::endl;
         
         // USD volume display - prominently shown 
         std::cout << "\n--- USD TRADING VOLUME ---" << std::endl;
@@ -620,18 +723,18 @@ private:
         double best_bid = 0, best_ask = 0;
         
         if (!bids.empty()) {
-            best_bid = bids.rbegin()->first; // Highest bid price
+            best_bid = tick_price(bids.rbegin()->first); // Highest bid price
         }
         
         if (!asks.empty()) {
-            best_ask = asks.begin()->first; // Lowest ask price
+            best_ask = tick_price(asks.begin()->first); // Lowest ask price
         }
         
         // Remove obviously wrong bid prices (more than 5% away from best bid)
         if (best_bid > 0) {
             auto it = bids.begin();
             while (it != bids.end()) {
-                if (it->first < best_bid * 0.95) {
+                if (tick_price(it->first) < best_bid * 0.95) {
                     it = bids.erase(it);
                 } else {
                     ++it;
@@ -685,10 +788,12 @@ private:
         
         int ask_count = 0;
         for (auto it = asks.begin(); it != asks.end() && ask_count < max_levels_to_print; ++it) {
-            double usd_value = it->first * it->second.first; // Price * Quantity = USD Value
-            std::cout << std::setprecision(get_precision_for_tick_size()) << std::setw(15) << it->first
+            double price = tick_price(it->first);
+            double quantity = lots_quantity(it->second.first);
+            double usd_value = price * quantity; // Price * Quantity = USD Value
+            std::cout << std::setprecision(get_precision_for_tick_size()) << std::setw(15) << price
                     << " | "
-                    << std::setprecision(5) << std::setw(15) << it->second.first
+                    << std::setprecision(5) << std::setw(15) << quantity
                     << " | "
                     << std::fixed << std::setprecision(2) << std::setw(15) << usd_value
                     << " | " << it->second.second << std::endl;
@@ -706,10 +811,12 @@ private:
         int bid_count = 0;
         // Using REVERSE iterator to show from highest to lowest
         for (auto it = bids.rbegin(); it != bids.rend() && bid_count < max_levels_to_print; ++it) {
-            double usd_value = it->first * it->second.first; // Price * Quantity = USD Value
-            std::cout << std::setprecision(get_precision_for_tick_size()) << std::setw(15) << it->first
+            double price = tick_price(it->first);
+            double quantity = lots_quantity(it->second.first);
+            double usd_value = price * quantity; // Price * Quantity = USD Value
+            std::cout << std::setprecision(get_precision_for_tick_size()) << std::setw(15) << price
                     << " | "
-                    << std::setprecision(5) << std::setw(15) << it->second.first
+                    << std::setprecision(5) << std::setw(15) << quantity
                     << " | "
                     << std::fixed << std::setprecision(2) << std::setw(15) << usd_value
                     << " | " << it->second.second << std::endl;
@@ -784,8 +891,13 @@ public:
         return {metrics.best_bid, metrics.best_ask};
     }
 
-    BinanceOrderBook() {
+    explicit BinanceOrderBook(const SymbolPrecision& symbol_precision = {}) : precision(symbol_precision) {
         instance = this;
+        // The default tick, or the finest one this price precision has
+        tick_units = 0;
+        to_fixed_point(tick_size, precision.price_decimals, tick_units);
+        tick_units = std::max<int64_t>(1, tick_units);
+        tick_size = fixed_to_double(tick_units, precision.price_decimals);
         curl_global_init(CURL_GLOBAL_DEFAULT);
         recent_trades.resize(max_trades_to_store); // Pre-allocate the ring buffer
     }
@@ -819,31 +931,42 @@ public:
             }
         }
         
+        int64_t new_tick_units = 0;
+        to_fixed_point(new_tick_size, precision.price_decimals, new_tick_units);
+        if (valid && new_tick_units < 1) {
+            std::cout << "Tick size " << new_tick_size << " is finer than the price precision ("
+                      << unsigned(precision.price_decimals) << " decimals)" << std::endl;
+            return;
+        }
+
         if (valid) {
+            int64_t old_tick_units = tick_units;
             tick_size = new_tick_size;
+            tick_units = new_tick_units;
             std::cout << "Tick size set to: " << std::fixed 
                       << std::setprecision(get_precision_for_tick_size()) << tick_size << std::endl;
             
-            // Re-aggregate the order book with the new tick size
-            std::map<double, std::pair<double, std::string>> new_bids, new_asks;
+            // Re-aggregate the order book with the new tick size. Every tick came from
+            // in-range units, so tick * old_tick_units is within MAX_FIXED_UNITS + old_tick_units.
+            BookSide new_bids, new_asks;
             
-            for (const auto& [price, qty_source] : bids) {
-                double rounded_price = round_to_tick_size(price);
+            for (const auto& [tick, qty_source] : bids) {
+                int64_t rounded_tick = nearest_step(tick * old_tick_units, tick_units);
                 // If a price level already exists, we add the quantity and keep the new source
-                if (new_bids.count(rounded_price) > 0) {
-                    new_bids[rounded_price].first += qty_source.first;
+                if (new_bids.count(rounded_tick) > 0) {
+                    new_bids[rounded_tick].first += qty_source.first;
                 } else {
-                    new_bids[rounded_price] = qty_source;
+                    new_bids[rounded_tick] = qty_source;
                 }
             }
             
-            for (const auto& [price, qty_source] : asks) {
-                double rounded_price = round_to_tick_size(price);
+            for (const auto& [tick, qty_source] : asks) {
+                int64_t rounded_tick = nearest_step(tick * old_tick_units, tick_units);
                 // If a price level already exists, we add the quantity and keep the new source
-                if (new_asks.count(rounded_price) > 0) {
-                    new_asks[rounded_price].first += qty_source.first;
+                if (new_asks.count(rounded_tick) > 0) {
+                    new_asks[rounded_tick].first += qty_source.first;
                 } else {
-                    new_asks[rounded_price] = qty_source;
+                    new_asks[rounded_tick] = qty_source;
                 }
             }
             
@@ -892,14 +1015,19 @@ public:
                         return 0;
                     }
                     
+                    // A message in a single frame is routed straight from the receive
+                    // buffer; only fragmented ones are gathered into ws_buffer first
+                    if (lws_is_final_fragment(wsi_in) && instance->ws_buffer.empty()) {
+                        instance->process_ws_message(std::string_view(static_cast<char*>(in), len));
+                        break;
+                    }
+
                     instance->ws_buffer.append(static_cast<char*>(in), len);
                     
                     if (lws_is_final_fragment(wsi_in)) {
-                        if (!instance->ws_buffer.empty()) {
-                            // Use the message router instead of directly calling process_ws_update
-                            instance->process_ws_message(instance->ws_buffer);
-                            instance->ws_buffer.clear();
-                        }
+                        // Use the message router instead of directly calling process_ws_update
+                        instance->process_ws_message(instance->ws_buffer);
+                        instance->ws_buffer.clear();
                     }
                 } catch (const std::exception& e) {
                     std::cerr << "Exception in CLIENT_RECEIVE: " << e.what() << std::endl;
@@ -1055,7 +1183,11 @@ struct lws_protocols BinanceOrderBook::protocols[] = {
 
 int main() {
     try {
-        BinanceOrderBook orderbook;
+        // Prices and quantities decode at BTCUSDC's BINANCE_PRECISION entry, or else at the
+        // decimals of its exchange tick and step sizes
+        PipelineConfig config = load_pipeline_config();
+        fill_symbol_precision({"BTCUSDC"}, config.symbol_precision);
+        BinanceOrderBook orderbook(precision_for(config.symbol_precision, "BTCUSDC"));
 		orderbook.enable_imbalance_calculation();
         
         std::cout << "Starting BTC/USDC OrderBook with API and WebSocket integration." << std::endl;
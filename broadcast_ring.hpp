@@ -0,0 +1,166 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+// Disruptor-style single-producer broadcast ring.
+//
+// The producer fills preallocated slots in sequence; every subscriber holds its own
+// read cursor on that one sequence and reads slots in place by const reference, so
+// attaching another consumer costs no extra copies. The producer is gated by the
+// slowest subscriber and never overwrites a slot someone has not read yet.
+template <typename T>
+class BroadcastRing {
+public:
+    static constexpr size_t MAX_SUBSCRIBERS = 16;
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+
+    explicit BroadcastRing(size_t capacity) {
+        size_t rounded = 1;
+        while (rounded < capacity) rounded <<= 1;
+        slots_.resize(rounded);
+        mask_ = rounded - 1;
+    }
+
+    BroadcastRing(const BroadcastRing&) = delete;
+    BroadcastRing& operator=(const BroadcastRing&) = delete;
+
+    // Register a consumer; it sees every item published from now on.
+    // Returns the cursor id to pass to the consumer calls below.
+    size_t subscribe() {
+        for (size_t id = 0; id < MAX_SUBSCRIBERS; ++id) {
+            bool expected = false;
+            if (cursors_[id].active.compare_exchange_strong(expected, true)) {
+                // Joining at the current head is safe against a producer whose cached
+                // gate predates us: that gate can only be behind the head we start at
+                uint64_t start = head_.load(std::memory_order_acquire);
+                cursors_[id].cached_head = start;
+                cursors_[id].sequence.store(start, std::memory_order_release);
+                cursors_[id].gating.store(true, std::memory_order_seq_cst);
+                return id;
+            }
+        }
+        throw std::runtime_error("BroadcastRing has no free subscriber slots");
+    }
+
+    void unsubscribe(size_t id) {
+        cursors_[id].gating.store(false, std::memory_order_release);
+        cursors_[id].active.store(false, std::memory_order_release);
+    }
+
+    // Producer: slot for the next item, or nullptr if the slowest subscriber is a full
+    // ring behind. The slot keeps whatever it held last time, so containers in T can
+    // reuse their capacity. Nothing is visible to subscribers until publish().
+    T* try_claim() {
+        uint64_t head = head_.load(std::memory_order_relaxed);
+        if (head - gate_ >= slots_.size()) {
+            gate_ = slowest(head);
+            if (head - gate_ >= slots_.size()) {
+                return nullptr;
+            }
+        }
+        return &slots_[head & mask_];
+    }
+
+    void publish() {
+        head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_seq_cst);
+        if (waiters_.load(std::memory_order_seq_cst) > 0) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            cond_.notify_all();
+        }
+    }
+
+    // Consumer: next unread item for this cursor, or nullptr if caught up.
+    // The item stays valid until advance().
+    const T* peek(size_t id) {
+        Cursor& cursor = cursors_[id];
+        uint64_t seq = cursor.sequence.load(std::memory_order_relaxed);
+        if (seq == cursor.cached_head) {
+            cursor.cached_head = head_.load(std::memory_order_acquire);
+            if (seq == cursor.cached_head) {
+                return nullptr;
+            }
+        }
+        return &slots_[seq & mask_];
+    }
+
+    void advance(size_t id) {
+        Cursor& cursor = cursors_[id];
+        cursor.sequence.store(cursor.sequence.load(std::memory_order_relaxed) + 1,
+                              std::memory_order_release);
+    }
+
+    // Consumer: block until an item is available (returned as with peek())
+    // or the ring is closed and this cursor has drained it (returns nullptr).
+    const T* wait(size_t id) {
+        for (;;) {
+            if (const T* item = peek(id)) {
+                return item;
+            }
+            if (closed_.load(std::memory_order_acquire)) {
+                return peek(id);
+            }
+
+            std::unique_lock<std::mutex> lock(mutex_);
+            waiters_.fetch_add(1, std::memory_order_seq_cst);
+            uint64_t seq = cursors_[id].sequence.load(std::memory_order_relaxed);
+            cond_.wait(lock, [&] {
+                return head_.load(std::memory_order_seq_cst) != seq ||
+                       closed_.load(std::memory_order_acquire);
+            });
+            waiters_.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closed_.store(true, std::memory_order_release);
+        }
+        cond_.notify_all();
+    }
+
+    bool is_closed() const {
+        return closed_.load(std::memory_order_acquire);
+    }
+
+    size_t capacity() const { return slots_.size(); }
+
+private:
+    struct alignas(CACHE_LINE_SIZE) Cursor {
+        std::atomic<uint64_t> sequence{0};  // Next sequence this subscriber will read
+        std::atomic<bool> active{false};    // Slot claimed by a subscriber
+        std::atomic<bool> gating{false};    // Producer must wait for this cursor
+        uint64_t cached_head = 0;           // Subscriber-local copy of head_
+    };
+
+    // Sequence of the slowest gating subscriber; head when there are none
+    uint64_t slowest(uint64_t head) const {
+        uint64_t min_seq = head;
+        for (const Cursor& cursor : cursors_) {
+            if (cursor.gating.load(std::memory_order_acquire)) {
+                uint64_t seq = cursor.sequence.load(std::memory_order_acquire);
+                if (seq < min_seq) min_seq = seq;
+            }
+        }
+        return min_seq;
+    }
+
+    std::vector<T> slots_;
+    size_t mask_ = 0;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> head_{0};  // Next sequence to publish
+    uint64_t gate_ = 0;  // Producer-local copy of the slowest cursor
+
+    Cursor cursors_[MAX_SUBSCRIBERS];
+
+    alignas(CACHE_LINE_SIZE) std::atomic<int> waiters_{0};
+    std::atomic<bool> closed_{false};
+    std::mutex mutex_;
+    std::condition_variable cond_;
+};
@@ -0,0 +1,120 @@
+#include "core/coro_scheduler.hpp"
+
+#if BINANCE_COROUTINES
+
+#include <chrono>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+// How long an idle executor sleeps before re-checking for shutdown
+constexpr auto EXECUTOR_IDLE_WAIT = std::chrono::milliseconds(100);
+
+void StageTask::FinalAwaiter::await_suspend(Handle handle) noexcept {
+    CoroScheduler* scheduler = handle.promise().scheduler;
+    handle.destroy();
+    scheduler->stage_finished();
+}
+
+void StageTask::promise_type::unhandled_exception() {
+    try {
+        throw;
+    } catch (const std::exception& e) {
+        std::cerr << "[Coroutines] Stage failed: " << e.what() << std::endl;
+    } catch (...) {
+        std::cerr << "[Coroutines] Stage failed with an unknown exception" << std::endl;
+    }
+    std::terminate();
+}
+
+CoroScheduler::CoroScheduler(size_t threads, size_t max_stages, const ThreadPlacement& placement)
+    : ready_(max_stages), thread_count_(threads), placement_(placement) {
+    if (threads == 0) {
+        throw std::runtime_error("CoroScheduler needs at least one executor thread");
+    }
+}
+
+CoroScheduler::~CoroScheduler() {
+    stop();
+}
+
+void CoroScheduler::spawn(StageTask task) {
+    StageTask::Handle handle = std::exchange(task.handle_, nullptr);
+    handle.promise().scheduler = this;
+    live_stages_.fetch_add(1, std::memory_order_relaxed);
+    schedule(handle);
+}
+
+void CoroScheduler::start() {
+    stopping_.store(false, std::memory_order_release);
+    for (size_t i = 0; i < thread_count_; ++i) {
+        threads_.emplace_back([this, i]() {
+            ThreadPlacement placement = placement_;
+            placement.name += "-" + std::to_string(i);
+            if (placement.cpu >= 0) {
+                placement.cpu += static_cast<int>(i);
+            }
+            apply_thread_placement(placement);
+            run();
+        });
+    }
+}
+
+void CoroScheduler::stop() {
+    stopping_.store(true, std::memory_order_release);
+    wakeup_.notify();
+    for (auto& thread : threads_) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+    threads_.clear();
+}
+
+void CoroScheduler::schedule(std::coroutine_handle<> handle) {
+    // Room for every live stage, so this only waits if more stages were spawned than
+    // the scheduler was sized for
+    while (!ready_.try_push(handle)) {
+        std::this_thread::yield();
+    }
+    wakeup_.notify();
+}
+
+void CoroScheduler::stage_finished() {
+    if (live_stages_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        // Last stage gone: let the other executors see it and exit
+        wakeup_.notify();
+    }
+}
+
+void CoroScheduler::run() {
+    for (;;) {
+        if (std::optional<std::coroutine_handle<>> handle = ready_.try_pop()) {
+            resumes_.fetch_add(1, std::memory_order_relaxed);
+            handle->resume();
+            continue;
+        }
+
+        // A live stage is either on the ready queue, running, or parked on an input
+        // that stop()'s caller has closed, which puts it back on the queue
+        auto finished = [this] {
+            return stopping_.load(std::memory_order_acquire) &&
+                   live_stages_.load(std::memory_order_acquire) == 0;
+        };
+        if (finished()) {
+            break;
+        }
+
+        uint64_t key = wakeup_.prepare_wait();
+        if (!ready_.empty() || finished()) {
+            wakeup_.cancel_wait();
+            continue;
+        }
+        wakeup_.wait(key, EXECUTOR_IDLE_WAIT);
+    }
+}
+
+#endif  // BINANCE_COROUTINES
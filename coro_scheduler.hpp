@@ -0,0 +1,228 @@
+#pragma once
+
+// Coroutine stages need C++20 (-std=c++20 or later); the rest of the pipeline still
+// builds as C++17, and without coroutine support this header declares nothing.
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#define BINANCE_COROUTINES 1
+#else
+#define BINANCE_COROUTINES 0
+#endif
+
+#if BINANCE_COROUTINES
+
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include "core/event_count.hpp"
+#include "core/mpmc_queue.hpp"
+#include "core/spsc_queue.hpp"
+#include "core/thread_placement.hpp"
+
+class CoroScheduler;
+
+// Return type of a pipeline stage coroutine. The stage is created suspended and does
+// nothing until handed to CoroScheduler::spawn(), which runs it on the executor
+// threads until it returns and then frees its frame. A task that was never spawned
+// frees its frame on destruction.
+//
+//     StageTask stage(StageInbox<Message>& inbox) {
+//         while (co_await inbox.wait()) {
+//             while (Message* message = inbox.peek()) { ...; inbox.advance(); }
+//         }
+//     }
+class StageTask {
+public:
+    struct promise_type;
+    using Handle = std::coroutine_handle<promise_type>;
+
+    StageTask(StageTask&& other) noexcept : handle_(other.handle_) { other.handle_ = nullptr; }
+    StageTask& operator=(StageTask&&) = delete;
+    ~StageTask() {
+        if (handle_) {
+            handle_.destroy();
+        }
+    }
+
+private:
+    friend class CoroScheduler;
+
+    explicit StageTask(Handle handle) : handle_(handle) {}
+
+    // Frees the frame, then tells the scheduler the stage is gone
+    struct FinalAwaiter {
+        bool await_ready() noexcept { return false; }
+        void await_suspend(Handle handle) noexcept;
+        void await_resume() noexcept {}
+    };
+
+    Handle handle_;
+
+public:
+    struct promise_type {
+        CoroScheduler* scheduler = nullptr;
+
+        StageTask get_return_object() { return StageTask(Handle::from_promise(*this)); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        FinalAwaiter final_suspend() noexcept { return {}; }
+        void return_void() {}
+        // A stage that throws takes the process down, as it would on its own thread,
+        // but says which exception did it first
+        void unhandled_exception();
+    };
+};
+
+// Runs stage coroutines on a small, fixed set of executor threads.
+//
+// A ready stage sits on one shared lock-free queue until an executor thread resumes
+// it. A stage that finds its input empty suspends and is put back on the queue by
+// whoever publishes to that input, so an idle stage costs no thread and no polling;
+// executor threads with nothing to resume sleep on an EventCount. A stage is on the
+// ready queue at most once, so the queue never fills if it has room for every stage.
+class CoroScheduler {
+public:
+    // Executor n runs with placement, named "<name>-n" and pinned to placement.cpu + n
+    // when a cpu is set. max_stages bounds how many stages may be alive at once.
+    CoroScheduler(size_t threads, size_t max_stages, const ThreadPlacement& placement);
+    ~CoroScheduler();
+
+    CoroScheduler(const CoroScheduler&) = delete;
+    CoroScheduler& operator=(const CoroScheduler&) = delete;
+
+    // Queue a stage to run; before or after start()
+    void spawn(StageTask task);
+    void start();
+    // Wait for every stage to return, then join the executors. Close the stages'
+    // inputs first, or this waits forever.
+    void stop();
+
+    // Put a suspended coroutine on the ready queue; any thread
+    void schedule(std::coroutine_handle<> handle);
+
+    // co_await scheduler.yield() to let the other ready stages run first
+    auto yield() {
+        struct YieldAwaiter {
+            CoroScheduler& scheduler;
+            bool await_ready() noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> handle) { scheduler.schedule(handle); }
+            void await_resume() noexcept {}
+        };
+        return YieldAwaiter{*this};
+    }
+
+    size_t thread_count() const { return thread_count_; }
+    // Times a stage was resumed, counting every wait and yield it came back from
+    uint64_t resumes() const { return resumes_.load(std::memory_order_relaxed); }
+
+private:
+    friend class StageTask;
+
+    void run();
+    void stage_finished();
+
+    MPMCQueue<std::coroutine_handle<>> ready_;
+    size_t thread_count_;
+    ThreadPlacement placement_;
+    std::vector<std::thread> threads_;
+    EventCount wakeup_;
+    std::atomic<size_t> live_stages_{0};
+    std::atomic<bool> stopping_{false};
+    std::atomic<uint64_t> resumes_{0};
+};
+
+// Bounded single-producer, single-consumer queue whose consumer is a stage coroutine.
+//
+// The producer, on any thread, fills slots in place with try_claim()/publish() exactly
+// as on an SPSCQueue. The consumer stage co_awaits wait() when it runs dry: instead
+// of sleeping, it suspends, and the next publish() or close() puts it back on the
+// scheduler's ready queue. A publish() while the stage is busy costs a fence and a load.
+template <typename T>
+class StageInbox {
+public:
+    StageInbox(CoroScheduler& scheduler, size_t capacity)
+        : queue_(capacity), scheduler_(scheduler) {}
+
+    StageInbox(const StageInbox&) = delete;
+    StageInbox& operator=(const StageInbox&) = delete;
+
+    // Producer: slot to fill, or nullptr while the inbox is full
+    T* try_claim() { return queue_.try_claim(); }
+
+    // Producer: make the claimed slot visible and wake the stage if it is waiting
+    void publish() {
+        queue_.publish();
+        wake();
+    }
+
+    // Producer: no more messages; the stage's wait() returns false once it has drained
+    void close() {
+        queue_.close();
+        wake();
+    }
+
+    // Consumer: co_await until there is a message, or false once the inbox is closed
+    // and drained. May also return true with nothing queued, after a wake-up meant for
+    // a message already taken, so always drain with peek().
+    auto wait() {
+        struct WaitAwaiter {
+            StageInbox& inbox;
+
+            bool await_ready() {
+                // Consume the pending wake-up before checking, so a publish() after this
+                // point flags it again and the check below cannot miss it. The fence
+                // pairs with the one in wake().
+                if (inbox.waiter_.load(std::memory_order_relaxed) == notified()) {
+                    inbox.waiter_.store(nullptr, std::memory_order_relaxed);
+                }
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                return !inbox.queue_.empty() || inbox.queue_.is_closed();
+            }
+
+            // Park the stage unless a publish() flagged the inbox after await_ready();
+            // then resume at once and let the caller drain. Once the handle is stored the
+            // producer may resume the stage on another thread at any moment, so nothing
+            // is touched after a successful exchange.
+            bool await_suspend(std::coroutine_handle<> handle) {
+                void* expected = nullptr;
+                return inbox.waiter_.compare_exchange_strong(expected, handle.address(),
+                                                             std::memory_order_seq_cst);
+            }
+
+            bool await_resume() {
+                return !inbox.queue_.empty() || !inbox.queue_.is_closed();
+            }
+        };
+        return WaitAwaiter{*this};
+    }
+
+    // Consumer: oldest message, read in place until advance(), or nullptr if empty
+    T* peek() { return queue_.peek(); }
+    void advance() { queue_.advance(); }
+
+    bool empty() const { return queue_.empty(); }
+
+private:
+    // waiter_ holds nothing, a parked stage's handle, or this marker for a publish()
+    // the stage has not checked for yet
+    static void* notified() { return reinterpret_cast<void*>(uintptr_t(1)); }
+
+    void wake() {
+        // Order the publish before reading waiter_; pairs with the fence in await_ready()
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiter_.load(std::memory_order_relaxed) == notified()) {
+            return;  // Already flagged; the stage checks the queue before it parks
+        }
+        void* waiter = waiter_.exchange(notified(), std::memory_order_seq_cst);
+        if (waiter != nullptr && waiter != notified()) {
+            scheduler_.schedule(std::coroutine_handle<>::from_address(waiter));
+        }
+    }
+
+    SPSCQueue<T> queue_;
+    CoroScheduler& scheduler_;
+    std::atomic<void*> waiter_{nullptr};
+};
+
+#endif  // BINANCE_COROUTINES
@@ -0,0 +1,164 @@
+#include "features/coroutine_pipeline.hpp"
+
+#if BINANCE_COROUTINES
+
+#include "core/async_logger.hpp"
+#include "core/symbol_table.hpp"
+#include "core/wire_format.hpp"
+#include <algorithm>
+#include <thread>
+#include <utility>
+
+CoroutinePipeline::Symbol::Symbol(const std::string& name, const SymbolPrecision& precision,
+                                  std::unique_ptr<LiquidityTracker> tracker, CoroScheduler& scheduler)
+    : iceberg(name, precision),
+      liquidity(std::move(tracker)),
+      books(STAGE_BOOK_CAPACITY),
+      iceberg_cursor(books.subscribe()),
+      liquidity_cursor(books.subscribe()),
+      book_ready(scheduler, STAGE_INBOX_CAPACITY),
+      events(scheduler, STAGE_INBOX_CAPACITY) {}
+
+CoroutinePipeline::CoroutinePipeline(const std::vector<std::string>& symbols, size_t threads,
+                                     const TrackerFactory& make_tracker, const PrecisionTable& precision,
+                                     const ThreadPlacement& placement)
+    : scheduler_(threads, symbols.size() * 2, placement) {
+    SymbolTable table(symbols);
+    for (size_t i = 0; i < table.size(); ++i) {
+        const std::string& name = table.name(static_cast<SymbolId>(i));
+        symbols_.push_back(std::make_unique<Symbol>(name, precision_for(precision, name), make_tracker(name),
+                                                    scheduler_));
+    }
+}
+
+CoroutinePipeline::~CoroutinePipeline() {
+    stop();
+}
+
+void CoroutinePipeline::start() {
+    // Stages are only created here, so a pipeline that never starts holds no frames
+    for (auto& symbol : symbols_) {
+        scheduler_.spawn(iceberg_stage(scheduler_, *symbol));
+        scheduler_.spawn(liquidity_stage(scheduler_, *symbol));
+    }
+    scheduler_.start();
+    started_ = true;
+}
+
+void CoroutinePipeline::stop() {
+    if (!started_) {
+        return;
+    }
+    started_ = false;
+    for (auto& symbol : symbols_) {
+        symbol->book_ready.close();
+        symbol->events.close();
+    }
+    scheduler_.stop();
+}
+
+void CoroutinePipeline::on_trade(SymbolId symbol, const TradeMessageBinary& trade, const TraceStamps& trace) {
+    if (symbol >= symbols_.size()) {
+        log_event(LOG_CONSUMER, LOG_WARN, 0, "[Coroutines] Message for unknown symbol id {}", symbol);
+        return;
+    }
+    StageInbox<LiquidityEvent>& events = symbols_[symbol]->events;
+    LiquidityEvent* event = claim(events);
+    event->type = TYPE_TRADE;
+    event->trade = trade;
+    event->trace = trace;
+    events.publish();
+}
+
+void CoroutinePipeline::on_orderbook(SymbolId symbol, const OrderBookUpdate& book, const TraceStamps& trace) {
+    if (symbol >= symbols_.size()) {
+        log_event(LOG_CONSUMER, LOG_WARN, 0, "[Coroutines] Message for unknown symbol id {}", symbol);
+        return;
+    }
+    Symbol& target = *symbols_[symbol];
+    target.max_levels = std::max({target.max_levels, book.bids.size(), book.asks.size()});
+
+    // One copy for both stages, in the ring before either inbox says it is there
+    copy_book(book, *claim(target.books), target.max_levels);
+    target.books.publish();
+
+    claim(target.book_ready);
+    target.book_ready.publish();
+
+    LiquidityEvent* event = claim(target.events);
+    event->type = TYPE_ORDERBOOK;
+    event->trace = trace;
+    target.events.publish();
+}
+
+// Inbox or ring slot to fill, waiting while the stages catch up
+template <typename Queue>
+auto CoroutinePipeline::claim(Queue& queue) -> decltype(queue.try_claim()) {
+    for (;;) {
+        if (auto* slot = queue.try_claim()) {
+            return slot;
+        }
+        std::this_thread::yield();
+    }
+}
+
+// Refill a recycled slot's levels in place; a slot that has to grow goes straight to
+// the deepest book its symbol has had, as in SymbolWorkerPool
+void CoroutinePipeline::copy_book(const OrderBookUpdate& from, OrderBookUpdate& to, size_t max_levels) {
+    to.timestamp_ns = from.timestamp_ns;
+    to.last_update_id = from.last_update_id;
+    if (to.bids.capacity() < from.bids.size()) {
+        reserve_levels(to.bids, max_levels);
+    }
+    to.bids.assign(from.bids.begin(), from.bids.end());
+    if (to.asks.capacity() < from.asks.size()) {
+        reserve_levels(to.asks, max_levels);
+    }
+    to.asks.assign(from.asks.begin(), from.asks.end());
+}
+
+StageTask CoroutinePipeline::iceberg_stage(CoroScheduler& scheduler, Symbol& symbol) {
+    size_t handled = 0;
+    while (co_await symbol.book_ready.wait()) {
+        while (symbol.book_ready.peek()) {
+            symbol.iceberg.process_update(*symbol.books.peek(symbol.iceberg_cursor));
+            symbol.books.advance(symbol.iceberg_cursor);
+            symbol.book_ready.advance();
+            if (++handled % STAGE_BATCH == 0) {
+                co_await scheduler.yield();
+            }
+        }
+    }
+}
+
+StageTask CoroutinePipeline::liquidity_stage(CoroScheduler& scheduler, Symbol& symbol) {
+    // Level buffers live in the coroutine frame, reused across updates
+    std::vector<OrderBookLevel> bids;
+    std::vector<OrderBookLevel> asks;
+    size_t handled = 0;
+    while (co_await symbol.events.wait()) {
+        while (const LiquidityEvent* event = symbol.events.peek()) {
+            if (event->type == TYPE_TRADE) {
+                symbol.liquidity->onTrade(event->trade);
+            } else {
+                const OrderBookUpdate& book = *symbol.books.peek(symbol.liquidity_cursor);
+                bids.clear();
+                asks.clear();
+                for (const auto& bid : book.bids)
+                    bids.push_back({bid.price, bid.quantity});
+                for (const auto& ask : book.asks)
+                    asks.push_back({ask.price, ask.quantity});
+                symbol.liquidity->onOrderBookUpdate(book.timestamp_ns, bids, asks);
+                symbol.books.advance(symbol.liquidity_cursor);
+            }
+            // Every message passes through this stage, so its trace is recorded here
+            record_trace(event->trace, trace_stamp());
+            symbol.events.advance();
+            if (++handled % STAGE_BATCH == 0) {
+                co_await scheduler.yield();
+            }
+        }
+    }
+}
+
+#endif  // BINANCE_COROUTINES
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "core/coro_scheduler.hpp"
+
+#if BINANCE_COROUTINES
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "io/binance_connector.hpp"
+#include "core/broadcast_ring.hpp"
+#include "core/latency_trace.hpp"
+#include "core/thread_placement.hpp"
+#include "features/IcebergDetector.hpp"
+#include "features/liquidity_tracker.hpp"
+
+// Messages queued per stage before the feeding thread waits for it
+constexpr size_t STAGE_INBOX_CAPACITY = 1024;
+
+// Order book updates queued per symbol, read in place by both of its stages
+constexpr size_t STAGE_BOOK_CAPACITY = 64;
+
+// Messages a stage handles before letting the other ready stages run
+constexpr size_t STAGE_BATCH = 256;
+
+// Runs every detector of every symbol as its own coroutine stage on a few executor
+// threads (requires a C++20 build).
+//
+// Each symbol has an iceberg stage fed its order book updates and a liquidity stage
+// fed its trades and updates in arrival order. A symbol's updates are copied once,
+// into a broadcast ring both stages read with their own cursor; their inboxes only
+// say when the next one is there. A stage with an empty inbox suspends
+// rather than sleeping or spinning, and the feeding thread's publish puts it straight
+// back on the ready queue, so hundreds of stages share the executors without a thread
+// each and still wake within microseconds.
+class CoroutinePipeline : public FeedHandler {
+public:
+    using TrackerFactory = std::function<std::unique_ptr<LiquidityTracker>(const std::string& symbol)>;
+
+    // Stages of symbols[i] take SymbolId i, matching the connector's SymbolIds, and run
+    // at its precision from the table. Executor n runs with placement, named "<name>-n"
+    // and pinned to placement.cpu + n when a cpu is set.
+    CoroutinePipeline(const std::vector<std::string>& symbols, size_t threads,
+                      const TrackerFactory& make_tracker, const PrecisionTable& precision,
+                      const ThreadPlacement& placement);
+    ~CoroutinePipeline();
+
+    CoroutinePipeline(const CoroutinePipeline&) = delete;
+    CoroutinePipeline& operator=(const CoroutinePipeline&) = delete;
+
+    void start();
+    // Close every inbox, let the stages finish what is queued, then join the executors.
+    // Call after the feeding thread stopped.
+    void stop();
+
+    // Feeding thread only (the ring consumer); waits while a stage's inbox is full
+    void on_trade(SymbolId symbol, const TradeMessageBinary& trade, const TraceStamps& trace) override;
+    void on_orderbook(SymbolId symbol, const OrderBookUpdate& book, const TraceStamps& trace) override;
+
+    size_t thread_count() const { return scheduler_.thread_count(); }
+    size_t stage_count() const { return symbols_.size() * 2; }
+    uint64_t resumes() const { return scheduler_.resumes(); }
+
+private:
+    // What the iceberg stage receives: the next book is in the symbol's ring
+    struct BookReady {};
+
+    // What the liquidity stage receives; an order book's levels are the next entry of
+    // the symbol's ring
+    struct LiquidityEvent {
+        MessageType type = TYPE_TRADE;
+        TradeMessageBinary trade{};
+        TraceStamps trace;
+    };
+
+    struct Symbol {
+        Symbol(const std::string& name, const SymbolPrecision& precision,
+               std::unique_ptr<LiquidityTracker> tracker, CoroScheduler& scheduler);
+
+        IcebergDetector iceberg;
+        std::unique_ptr<LiquidityTracker> liquidity;
+        BroadcastRing<OrderBookUpdate> books;       // Shared by both stages
+        size_t iceberg_cursor;
+        size_t liquidity_cursor;
+        StageInbox<BookReady> book_ready;           // Iceberg stage input
+        StageInbox<LiquidityEvent> events;          // Liquidity stage input
+        size_t max_levels = 0;                      // Deepest book side fed so far; feeding thread only
+    };
+
+    static StageTask iceberg_stage(CoroScheduler& scheduler, Symbol& symbol);
+    static StageTask liquidity_stage(CoroScheduler& scheduler, Symbol& symbol);
+
+    template <typename Queue>
+    static auto claim(Queue& queue) -> decltype(queue.try_claim());
+    static void copy_book(const OrderBookUpdate& from, OrderBookUpdate& to, size_t max_levels);
+
+    CoroScheduler scheduler_;
+    std::vector<std::unique_ptr<Symbol>> symbols_;
+    bool started_ = false;
+};
+
+#endif  // BINANCE_COROUTINES
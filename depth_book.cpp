@@ -0,0 +1,118 @@
+#include "core/depth_book.hpp"
+#include <iterator>
+#include <utility>
+
+DepthBook::Result DepthBook::apply(const DepthMessage& diff) {
+    if (!synced_) {
+        buffer(diff);
+        return BUFFERED;
+    }
+    if (diff.final_update_id <= last_update_id_) {
+        return STALE;
+    }
+    if (diff.first_update_id > last_update_id_ + 1) {
+        // Only events from this one on can follow on from the next snapshot
+        synced_ = false;
+        buffered_.clear();
+        buffer(diff);
+        return GAP;
+    }
+
+    apply_levels(bids_, diff.bids);
+    apply_levels(asks_, diff.asks);
+    trim(bids_, true);
+    trim(asks_, false);
+    last_update_id_ = diff.final_update_id;
+    return APPLIED;
+}
+
+bool DepthBook::load_snapshot(const DepthMessage& snapshot) {
+    clear_side(bids_);
+    clear_side(asks_);
+    apply_levels(bids_, snapshot.bids);
+    apply_levels(asks_, snapshot.asks);
+    trim(bids_, true);
+    trim(asks_, false);
+    last_update_id_ = snapshot.final_update_id;
+    synced_ = true;
+
+    std::deque<DepthMessage> pending;
+    pending.swap(buffered_);
+    while (!pending.empty()) {
+        if (apply(pending.front()) == GAP) {
+            // The snapshot is older than the buffer reaches back: keep what came after
+            // the gap for the next one
+            pending.pop_front();
+            for (DepthMessage& diff : pending) {
+                buffer(diff);
+            }
+            return false;
+        }
+        pending.pop_front();
+    }
+    return true;
+}
+
+void DepthBook::top_levels(size_t depth, OrderBookUpdate& out) const {
+    out.bids.clear();
+    out.asks.clear();
+    for (auto it = bids_.rbegin(); it != bids_.rend() && out.bids.size() < depth; ++it) {
+        out.bids.push_back({it->first, it->second});
+    }
+    for (auto it = asks_.begin(); it != asks_.end() && out.asks.size() < depth; ++it) {
+        out.asks.push_back({it->first, it->second});
+    }
+    out.last_update_id = last_update_id_;
+}
+
+void DepthBook::buffer(const DepthMessage& diff) {
+    if (buffered_.size() >= DEPTH_BOOK_MAX_BUFFERED) {
+        buffered_.pop_front();
+    }
+    buffered_.push_back(diff);
+}
+
+void DepthBook::apply_levels(Levels& side, const DepthLevels& levels) {
+    for (size_t i = 0; i < levels.size(); ++i) {
+        set_level(side, levels.prices[i], levels.quantities[i]);
+    }
+}
+
+// A zero quantity removes the level; its node is kept for the next new one
+void DepthBook::set_level(Levels& side, double price, double quantity) {
+    auto it = side.lower_bound(price);
+    bool found = it != side.end() && it->first == price;
+    if (quantity <= 0.0) {
+        if (found) {
+            spare_levels_.push_back(side.extract(it));
+        }
+        return;
+    }
+    if (found) {
+        it->second = quantity;
+        return;
+    }
+    if (spare_levels_.empty()) {
+        side.emplace_hint(it, price, quantity);
+        return;
+    }
+    Levels::node_type node = std::move(spare_levels_.back());
+    spare_levels_.pop_back();
+    node.key() = price;
+    node.mapped() = quantity;
+    side.insert(it, std::move(node));
+}
+
+void DepthBook::clear_side(Levels& side) {
+    while (!side.empty()) {
+        spare_levels_.push_back(side.extract(side.begin()));
+    }
+}
+
+// Drop the levels farthest from the touch beyond DEPTH_BOOK_MAX_LEVELS
+void DepthBook::trim(Levels& side, bool is_bid) {
+    while (side.size() > DEPTH_BOOK_MAX_LEVELS) {
+        auto farthest = is_bid ? side.begin() : std::prev(side.end());
+        spare_levels_.push_back(side.extract(farthest));
+    }
+}
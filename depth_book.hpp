@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <vector>
+#include "core/feed_parser.hpp"
+#include "core/serialization.hpp"  // For OrderBookUpdate
+
+// Levels a side a DepthBook keeps. A book that drifts far from where its snapshot was
+// taken drops the levels farthest from the touch, which no diff keeps current anyway.
+constexpr size_t DEPTH_BOOK_MAX_LEVELS = 5000;
+
+// Diff events held while a book waits for its snapshot; the oldest go first
+constexpr size_t DEPTH_BOOK_MAX_BUFFERED = 1000;
+
+// Full order book of one symbol, kept from its diff depth stream (<symbol>@depth) and a
+// REST snapshot as Binance prescribes: events are buffered until the snapshot is loaded,
+// those it already covers (u <= lastUpdateId) are dropped, and every event applied
+// after it must start no later than the update after the book's last one
+// (U <= last + 1). An event that leaves a gap unsyncs the book until a new snapshot.
+//
+// Prices are keyed as decoded: the stream and the snapshot send them in the same
+// decimal form, and both parsers turn that into the same double.
+class DepthBook {
+public:
+    enum Result {
+        APPLIED,   // The book now reflects the event
+        BUFFERED,  // Held until a snapshot is loaded
+        STALE,     // Already covered by the book, dropped
+        GAP        // Updates were missed: the book is unsynced and needs a new snapshot
+    };
+
+    // Apply a diff event, zero quantities removing their level, or buffer it while the
+    // book is unsynced
+    Result apply(const DepthMessage& diff);
+
+    // Replace the book with snapshot, whose final_update_id is its lastUpdateId, and
+    // replay the buffered events it does not cover. Returns false, leaving the book
+    // unsynced, if those events do not follow on from the snapshot.
+    bool load_snapshot(const DepthMessage& snapshot);
+
+    bool synced() const { return synced_; }
+    uint64_t last_update_id() const { return last_update_id_; }
+    size_t bid_levels() const { return bids_.size(); }
+    size_t ask_levels() const { return asks_.size(); }
+
+    // The best depth levels a side, best first, into out's existing vectors, with
+    // last_update_id set; timestamp_ns is left to the caller
+    void top_levels(size_t depth, OrderBookUpdate& out) const;
+
+private:
+    using Levels = std::map<double, double>;  // Price -> quantity, ascending on both sides
+
+    Levels bids_;
+    Levels asks_;
+    std::vector<Levels::node_type> spare_levels_;  // Map nodes recycled between updates
+    std::deque<DepthMessage> buffered_;
+    uint64_t last_update_id_ = 0;
+    bool synced_ = false;
+
+    void buffer(const DepthMessage& diff);
+    void apply_levels(Levels& side, const DepthLevels& levels);
+    void set_level(Levels& side, double price, double quantity);
+    void clear_side(Levels& side);
+    void trim(Levels& side, bool is_bid);
+};
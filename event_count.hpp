@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+// Wake-up channel for a thread that waits on several inputs at once.
+//
+// Producers publish to their own queue or ring as usual and then call notify(); a
+// consumer that finds all of its inputs empty brackets its re-check with
+// prepare_wait()/wait() so a notify() that lands between the check and the sleep is
+// never lost. notify() costs a fence and a load while nobody is waiting; the mutex is
+// only taken when a waiter has registered.
+//
+//     uint64_t key = event.prepare_wait();
+//     if (inputs_have_data()) event.cancel_wait();
+//     else event.wait(key, timeout);
+class EventCount {
+public:
+    EventCount() = default;
+    EventCount(const EventCount&) = delete;
+    EventCount& operator=(const EventCount&) = delete;
+
+    // Producer: call after publishing
+    void notify() {
+        // Order the publish before the waiter check; pairs with the fetch_add in prepare_wait()
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiters_.load(std::memory_order_relaxed) == 0) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            epoch_.fetch_add(1, std::memory_order_relaxed);
+        }
+        cond_.notify_all();
+    }
+
+    // Consumer: register before the final emptiness check; returns the key for wait()
+    uint64_t prepare_wait() {
+        waiters_.fetch_add(1, std::memory_order_seq_cst);
+        return epoch_.load(std::memory_order_acquire);
+    }
+
+    // Consumer: the check after prepare_wait() found data, so do not sleep
+    void cancel_wait() {
+        waiters_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    // Consumer: sleep until a notify() after prepare_wait() or the timeout.
+    // Returns false on timeout.
+    bool wait(uint64_t key, std::chrono::nanoseconds timeout) {
+        bool notified;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            notified = cond_.wait_for(lock, timeout, [&] {
+                return epoch_.load(std::memory_order_relaxed) != key;
+            });
+        }
+        waiters_.fetch_sub(1, std::memory_order_relaxed);
+        return notified;
+    }
+
+private:
+    std::atomic<uint64_t> epoch_{0};
+    std::atomic<int> waiters_{0};
+    std::mutex mutex_;
+    std::condition_variable cond_;
+};
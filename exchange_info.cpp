@@ -0,0 +1,147 @@
+#include "io/exchange_info.hpp"
+#include <algorithm>
+#include <cctype>
+#include <iostream>
+#include <stdexcept>
+#include <curl/curl.h>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+unsigned step_decimals(const std::string& step) {
+    size_t dot = step.find('.');
+    if (dot == std::string::npos) {
+        return 0;
+    }
+    size_t last = step.find_last_not_of('0');
+    return last == std::string::npos || last <= dot ? 0 : static_cast<unsigned>(last - dot);
+}
+
+static uint8_t filter_decimals(const std::string& step) {
+    return static_cast<uint8_t>(std::min(step_decimals(step), MAX_SYMBOL_DECIMALS));
+}
+
+PrecisionTable parse_exchange_info(const std::string& body) {
+    PrecisionTable table;
+    try {
+        json root = json::parse(body);
+        for (const auto& symbol : root.at("symbols")) {
+            SymbolPrecision precision;
+            for (const auto& filter : symbol.value("filters", json::array())) {
+                std::string type = filter.value("filterType", "");
+                if (type == "PRICE_FILTER" && filter.contains("tickSize")) {
+                    precision.price_decimals = filter_decimals(filter["tickSize"].get<std::string>());
+                } else if (type == "LOT_SIZE" && filter.contains("stepSize")) {
+                    precision.quantity_decimals = filter_decimals(filter["stepSize"].get<std::string>());
+                }
+            }
+            table[symbol.at("symbol").get<std::string>()] = precision;
+        }
+    } catch (const json::exception& e) {
+        throw std::runtime_error(std::string("Malformed exchangeInfo response: ") + e.what());
+    }
+    return table;
+}
+
+static size_t append_body(void* contents, size_t size, size_t nmemb, void* userp) {
+    static_cast<std::string*>(userp)->append(static_cast<char*>(contents), size * nmemb);
+    return size * nmemb;
+}
+
+// GET url, throwing on a transport error or a status other than 200
+static std::string http_get(const std::string& url) {
+    CURL* curl = curl_easy_init();
+    if (!curl) {
+        throw std::runtime_error("Failed to initialize libcurl");
+    }
+    std::string body;
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, append_body);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &body);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, 5000L);
+    CURLcode res = curl_easy_perform(curl);
+    long http_code = 0;
+    if (res == CURLE_OK) {
+        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
+    }
+    curl_easy_cleanup(curl);
+
+    if (res != CURLE_OK) {
+        throw std::runtime_error(std::string("Request failed: ") + curl_easy_strerror(res));
+    }
+    if (http_code != 200) {
+        throw std::runtime_error("Request failed with HTTP code " + std::to_string(http_code));
+    }
+    return body;
+}
+
+void parse_depth_snapshot(const std::string& body, DepthMessage& snapshot) {
+    snapshot.bids.clear();
+    snapshot.asks.clear();
+    try {
+        json root = json::parse(body);
+        snapshot.event_time = 0;
+        snapshot.first_update_id = 0;
+        snapshot.final_update_id = root.at("lastUpdateId").get<uint64_t>();
+        for (const auto& level : root.at("bids")) {
+            snapshot.bids.prices.push_back(std::stod(level.at(0).get_ref<const std::string&>()));
+            snapshot.bids.quantities.push_back(std::stod(level.at(1).get_ref<const std::string&>()));
+        }
+        for (const auto& level : root.at("asks")) {
+            snapshot.asks.prices.push_back(std::stod(level.at(0).get_ref<const std::string&>()));
+            snapshot.asks.quantities.push_back(std::stod(level.at(1).get_ref<const std::string&>()));
+        }
+    } catch (const json::exception& e) {
+        throw std::runtime_error(std::string("Malformed depth snapshot: ") + e.what());
+    } catch (const std::logic_error& e) {  // std::stod on a non-number
+        throw std::runtime_error(std::string("Malformed depth snapshot level: ") + e.what());
+    }
+}
+
+void fetch_depth_snapshot(const std::string& symbol, size_t limit, DepthMessage& snapshot) {
+    parse_depth_snapshot(http_get(std::string(DEPTH_SNAPSHOT_URL) + "?symbol=" + symbol +
+                                  "&limit=" + std::to_string(limit)),
+                         snapshot);
+}
+
+void fill_symbol_precision(const std::vector<std::string>& symbols, PrecisionTable& table) {
+    // Upper case, as SymbolTable and BINANCE_PRECISION name symbols
+    std::vector<std::string> missing;
+    for (std::string symbol : symbols) {
+        std::transform(symbol.begin(), symbol.end(), symbol.begin(),
+                       [](unsigned char c) { return static_cast<char>(std::toupper(c)); });
+        if (!table.count(symbol) && std::find(missing.begin(), missing.end(), symbol) == missing.end()) {
+            missing.push_back(symbol);
+        }
+    }
+    if (missing.empty()) {
+        return;
+    }
+
+    // symbols=["BTCUSDT","ETHUSDT"], percent-encoded
+    std::string url = std::string(EXCHANGE_INFO_URL) + "?symbols=%5B";
+    for (size_t i = 0; i < missing.size(); ++i) {
+        url += (i ? "%2C%22" : "%22") + missing[i] + "%22";
+    }
+    url += "%5D";
+
+    PrecisionTable listed;
+    try {
+        listed = parse_exchange_info(http_get(url));
+    } catch (const std::exception& e) {
+        std::cerr << "[Config] Could not fetch exchangeInfo (" << e.what()
+                  << "); symbols without a BINANCE_PRECISION entry use 8 price and quantity decimals" << std::endl;
+        return;
+    }
+    for (const std::string& symbol : missing) {
+        auto it = listed.find(symbol);
+        if (it == listed.end()) {
+            std::cerr << "[Config] exchangeInfo does not list " << symbol
+                      << ", using 8 price and quantity decimals" << std::endl;
+            continue;
+        }
+        table[symbol] = it->second;
+        std::cout << "[Config] " << symbol << " precision " << unsigned(it->second.price_decimals) << ":"
+                  << unsigned(it->second.quantity_decimals) << " from exchangeInfo" << std::endl;
+    }
+}
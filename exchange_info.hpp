@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "core/fixed_point.hpp"
+#include "core/feed_parser.hpp"
+
+// REST endpoints on the host the streams come from: each symbol's trading rules, and
+// order book snapshots
+constexpr const char* EXCHANGE_INFO_URL = "https://api.binance.us/api/v3/exchangeInfo";
+constexpr const char* DEPTH_SNAPSHOT_URL = "https://api.binance.us/api/v3/depth";
+
+// Decimals of a tickSize or stepSize string: 5 for "0.00001000", 0 for "1.00000000"
+unsigned step_decimals(const std::string& step);
+
+// Precision of every symbol in an exchangeInfo response: the decimals of its
+// PRICE_FILTER tickSize and LOT_SIZE stepSize, at most MAX_SYMBOL_DECIMALS. A symbol
+// missing either filter keeps SymbolPrecision{} for that half. Throws
+// std::runtime_error if body is not an exchangeInfo response.
+PrecisionTable parse_exchange_info(const std::string& body);
+
+// Adds an entry to table for each of symbols that lacks one, from exchangeInfo, so that
+// a symbol such as SHIBUSDT gets whole-unit quantities rather than 8 decimals that
+// overflow MAX_FIXED_UNITS. Failures are reported on stderr under [Config] and leave
+// those symbols at SymbolPrecision{}. Blocks on the request; call before streaming.
+void fill_symbol_precision(const std::vector<std::string>& symbols, PrecisionTable& table);
+
+// An order book snapshot into snapshot: lastUpdateId as final_update_id, levels as
+// sent, prices and quantities decoded with std::stod as the generic parsers do. Throws
+// std::runtime_error if body is not a depth snapshot.
+void parse_depth_snapshot(const std::string& body, DepthMessage& snapshot);
+
+// The best limit levels a side of an upper-case symbol's book, from DEPTH_SNAPSHOT_URL.
+// Throws std::runtime_error if the request or its response fails. Blocks on the request.
+void fetch_depth_snapshot(const std::string& symbol, size_t limit, DepthMessage& snapshot);
@@ -0,0 +1,666 @@
+#include "core/feed_parser.hpp"
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+// Build with FEED_PARSER_SCALAR=1 to use only the scalar code, e.g. to test it on x86
+#if defined(__x86_64__) && !FEED_PARSER_SCALAR
+#include <immintrin.h>
+#define FEED_PARSER_X86 1
+#else
+#define FEED_PARSER_X86 0
+#endif
+
+// A decimal string's digits as one integer: the value is mantissa / 10^fraction_digits
+struct DecimalDigits {
+    uint64_t mantissa;
+    size_t fraction_digits;
+};
+
+// Plain digits with at most one '.', the form Binance sends every price and quantity
+// in, and at most 19 digits so the mantissa cannot overflow. Returns false for
+// anything else.
+static bool scan_decimal_scalar(const char* text, size_t length, DecimalDigits& out) {
+    uint64_t mantissa = 0;
+    size_t digits = 0;
+    size_t dot = length;
+    for (size_t i = 0; i < length; ++i) {
+        char c = text[i];
+        if (c >= '0' && c <= '9') {
+            if (++digits > 19) {
+                return false;
+            }
+            mantissa = mantissa * 10 + static_cast<uint64_t>(c - '0');
+        } else if (c == '.' && dot == length) {
+            dot = i;
+        } else {
+            return false;
+        }
+    }
+    out.mantissa = mantissa;
+    out.fraction_digits = dot == length ? 0 : length - dot - 1;
+    return digits > 0;
+}
+
+#if FEED_PARSER_X86
+
+// scan_decimal_scalar for up to 16 characters in one register: validate every byte
+// at once, shuffle the digits right-aligned with the dot squeezed out, then fold them
+// pairwise into two 8-digit halves with multiply-adds. The register is loaded whole,
+// so text needs 16 readable bytes before end; near the end it takes the scalar loop.
+__attribute__((target("sse4.1")))
+static bool scan_decimal_sse41(const char* text, size_t length, const char* end, DecimalDigits& out) {
+    if (length > 16 || end - text < 16) {
+        return scan_decimal_scalar(text, length, out);
+    }
+    const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text));
+    const unsigned in_length = (1u << length) - 1;
+
+    const __m128i values = _mm_sub_epi8(chunk, _mm_set1_epi8('0'));
+    const __m128i is_digit = _mm_cmpeq_epi8(_mm_min_epu8(values, _mm_set1_epi8(9)), values);
+    const unsigned digit_mask = static_cast<unsigned>(_mm_movemask_epi8(is_digit)) & in_length;
+    const unsigned dot_mask =
+        static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('.')))) & in_length;
+    if ((digit_mask | dot_mask) != in_length || (dot_mask & (dot_mask - 1)) != 0 || digit_mask == 0) {
+        return false;
+    }
+    const size_t dot = dot_mask ? static_cast<size_t>(__builtin_ctz(dot_mask)) : length;
+    const size_t digits = length - (dot_mask ? 1 : 0);
+
+    // Lane i takes digit i - (16 - digits), skipping the dot; lanes before the first
+    // digit get a negative index, which the shuffle turns into zero
+    const __m128i lanes = _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    __m128i index = _mm_sub_epi8(lanes, _mm_set1_epi8(static_cast<char>(16 - digits)));
+    index = _mm_sub_epi8(index, _mm_cmpgt_epi8(index, _mm_set1_epi8(static_cast<char>(dot - 1))));
+    const __m128i aligned = _mm_shuffle_epi8(values, index);
+
+    const __m128i pairs = _mm_maddubs_epi16(aligned, _mm_setr_epi8(10, 1, 10, 1, 10, 1, 10, 1,
+                                                                   10, 1, 10, 1, 10, 1, 10, 1));
+    const __m128i quads = _mm_madd_epi16(pairs, _mm_setr_epi16(100, 1, 100, 1, 100, 1, 100, 1));
+    const __m128i packed = _mm_packus_epi32(quads, quads);
+    const __m128i halves = _mm_madd_epi16(packed, _mm_setr_epi16(10000, 1, 10000, 1, 10000, 1, 10000, 1));
+    out.mantissa = static_cast<uint64_t>(static_cast<uint32_t>(_mm_cvtsi128_si32(halves))) * 100000000 +
+                   static_cast<uint32_t>(_mm_extract_epi32(halves, 1));
+    out.fraction_digits = dot_mask ? length - dot - 1 : 0;
+    return true;
+}
+
+#if !defined(__SSE4_1__)
+static const bool cpu_has_sse41 = __builtin_cpu_supports("sse4.1");
+#endif
+
+#endif  // FEED_PARSER_X86
+
+// Closing quote of the string whose body starts at pos, or nullptr if the string is
+// unterminated or holds an escape. Compares a whole register of bytes per step.
+static const char* find_string_end(const char* pos, const char* end) {
+#if FEED_PARSER_X86
+#if defined(__AVX2__)
+    while (end - pos >= 32) {
+        const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pos));
+        const unsigned quotes = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('"'))));
+        const unsigned escapes = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\\'))));
+        if (quotes | escapes) {
+            const unsigned first = static_cast<unsigned>(__builtin_ctz(quotes | escapes));
+            return (quotes >> first) & 1 ? pos + first : nullptr;
+        }
+        pos += 32;
+    }
+#endif
+    while (end - pos >= 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+        const unsigned quotes = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('"'))));
+        const unsigned escapes = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\\'))));
+        if (quotes | escapes) {
+            const unsigned first = static_cast<unsigned>(__builtin_ctz(quotes | escapes));
+            return (quotes >> first) & 1 ? pos + first : nullptr;
+        }
+        pos += 16;
+    }
+#endif
+    for (; pos < end; ++pos) {
+        if (*pos == '"') {
+            return pos;
+        }
+        if (*pos == '\\') {
+            return nullptr;
+        }
+    }
+    return nullptr;
+}
+
+static bool scan_decimal(const char* text, size_t length, const char* end, DecimalDigits& out) {
+#if FEED_PARSER_X86 && defined(__SSE4_1__)
+    return scan_decimal_sse41(text, length, end, out);
+#elif FEED_PARSER_X86
+    return cpu_has_sse41 ? scan_decimal_sse41(text, length, end, out) : scan_decimal_scalar(text, length, out);
+#else
+    (void)end;
+    return scan_decimal_scalar(text, length, out);
+#endif
+}
+
+// Exactly representable powers of ten: a mantissa below 2^53 divided by one of these
+// is correctly rounded, so it matches strtod/stod bit for bit
+static constexpr double POW10[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+static constexpr uint64_t POW10_INT[] = {
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL,
+    100000000ULL, 1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL,
+    10000000000000ULL, 100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+    100000000000000000ULL, 1000000000000000000ULL, 10000000000000000000ULL};
+
+// Decimal string to double, exactly as stod would round it
+static bool parse_decimal(const char* text, size_t length, const char* end, double& value) {
+    DecimalDigits digits;
+    if (scan_decimal(text, length, end, digits) && digits.mantissa <= (uint64_t(1) << 53) &&
+        digits.fraction_digits < sizeof(POW10) / sizeof(POW10[0])) {
+        value = static_cast<double>(digits.mantissa) / POW10[digits.fraction_digits];
+        return true;
+    }
+    // Exponents, signs, too many digits: the general conversion, still allocation-free
+    std::from_chars_result result = std::from_chars(text, text + length, value);
+    return result.ec == std::errc() && result.ptr == text + length;
+}
+
+// Rescale digits to units of 10^-decimals. Extra fraction digits are accepted only
+// when they are zeros, so the result is always exact.
+static bool scale_decimal(const DecimalDigits& digits, unsigned decimals, int64_t& units) {
+    if (decimals > MAX_FIXED_DECIMALS) {
+        return false;
+    }
+    uint64_t scaled;
+    if (digits.fraction_digits <= decimals) {
+        if (__builtin_mul_overflow(digits.mantissa, POW10_INT[decimals - digits.fraction_digits], &scaled) ||
+            scaled > static_cast<uint64_t>(std::numeric_limits<int64_t>::max())) {
+            return false;
+        }
+    } else {
+        // At most 19 fraction digits, so the divisor is in range
+        uint64_t divisor = POW10_INT[digits.fraction_digits - decimals];
+        if (digits.mantissa % divisor != 0) {
+            return false;
+        }
+        scaled = digits.mantissa / divisor;
+    }
+    units = static_cast<int64_t>(scaled);
+    return true;
+}
+
+bool parse_fixed_point(const char* text, size_t length, unsigned decimals, int64_t& units) {
+    DecimalDigits digits;
+    return scan_decimal(text, length, text + length, digits) && scale_decimal(digits, decimals, units);
+}
+
+// Forward-only reader over a JSON payload. Every method skips leading whitespace
+// and returns false, without a meaningful position, on input it does not accept.
+class JsonCursor {
+public:
+    JsonCursor(const char* data, size_t size) : pos_(data), end_(data + size) {}
+
+    bool at_end() {
+        skip_whitespace();
+        return pos_ == end_;
+    }
+
+    // Consume c if it is the next character
+    bool consume(char c) {
+        skip_whitespace();
+        if (pos_ < end_ && *pos_ == c) {
+            ++pos_;
+            return true;
+        }
+        return false;
+    }
+
+    // Consume the literal word (true/false/null) if it comes next
+    bool consume_word(const char* word, size_t length) {
+        skip_whitespace();
+        if (static_cast<size_t>(end_ - pos_) >= length && std::memcmp(pos_, word, length) == 0) {
+            pos_ += length;
+            return true;
+        }
+        return false;
+    }
+
+    // A string without escapes, returned as a view into the payload
+    bool string(const char*& text, size_t& length) {
+        if (!consume('"')) {
+            return false;
+        }
+        const char* close = find_string_end(pos_, end_);
+        if (!close) {
+            return false;
+        }
+        text = pos_;
+        length = static_cast<size_t>(close - pos_);
+        pos_ = close + 1;
+        return true;
+    }
+
+    // A non-negative integer that fits in 64 bits
+    bool unsigned_integer(uint64_t& value) {
+        skip_whitespace();
+        const char* start = pos_;
+        uint64_t result = 0;
+        while (pos_ < end_ && *pos_ >= '0' && *pos_ <= '9') {
+            uint64_t digit = static_cast<uint64_t>(*pos_ - '0');
+            if (result > (std::numeric_limits<uint64_t>::max() - digit) / 10) {
+                return false;
+            }
+            result = result * 10 + digit;
+            ++pos_;
+        }
+        // A fraction or exponent means this is not an integer field as Binance sends it
+        if (pos_ == start || (pos_ < end_ && (*pos_ == '.' || *pos_ == 'e' || *pos_ == 'E'))) {
+            return false;
+        }
+        value = result;
+        return true;
+    }
+
+    // A decimal sent as a string, e.g. "0.00120000"
+    bool quoted_decimal(double& value) {
+        const char* text;
+        size_t length;
+        if (!string(text, length) || length == 0) {
+            return false;
+        }
+        return parse_decimal(text, length, end_, value);
+    }
+
+    // The same in fixed point, converted exactly or not at all (see parse_fixed_point)
+    bool quoted_decimal(unsigned decimals, int64_t& units) {
+        const char* text;
+        size_t length;
+        DecimalDigits digits;
+        return string(text, length) && scan_decimal(text, length, end_, digits) &&
+               scale_decimal(digits, decimals, units);
+    }
+
+    bool boolean(bool& value) {
+        if (consume_word("true", 4)) {
+            value = true;
+            return true;
+        }
+        if (consume_word("false", 5)) {
+            value = false;
+            return true;
+        }
+        return false;
+    }
+
+    // A depth side, [["price","quantity"],...], passing each level to add(price, quantity)
+    template <typename AddLevel>
+    bool levels(AddLevel&& add) {
+        return level_array([this, &add] {
+            double price;
+            double quantity;
+            if (!quoted_decimal(price) || !consume(',') || !quoted_decimal(quantity)) {
+                return false;
+            }
+            add(price, quantity);
+            return true;
+        });
+    }
+
+    // The same with each level in fixed point at precision
+    template <typename AddLevel>
+    bool levels(const SymbolPrecision& precision, AddLevel&& add) {
+        return level_array([this, &precision, &add] {
+            int64_t price;
+            int64_t quantity;
+            if (!quoted_decimal(precision.price_decimals, price) || !consume(',') ||
+                !quoted_decimal(precision.quantity_decimals, quantity)) {
+                return false;
+            }
+            add(price, quantity);
+            return true;
+        });
+    }
+
+    // Skip a string (escapes allowed), number or literal. Objects and arrays are not
+    // part of any flat event, so they are refused rather than skipped.
+    bool skip_scalar() {
+        skip_whitespace();
+        if (pos_ == end_) {
+            return false;
+        }
+        if (*pos_ == '"') {
+            for (++pos_; pos_ < end_; ++pos_) {
+                if (*pos_ == '\\') {
+                    ++pos_;
+                } else if (*pos_ == '"') {
+                    ++pos_;
+                    return true;
+                }
+            }
+            return false;
+        }
+        if (*pos_ == '{' || *pos_ == '[') {
+            return false;
+        }
+        const char* start = pos_;
+        while (pos_ < end_ && *pos_ != ',' && *pos_ != '}' && *pos_ != ']' &&
+               *pos_ != ' ' && *pos_ != '\n' && *pos_ != '\r' && *pos_ != '\t') {
+            ++pos_;
+        }
+        return pos_ != start;
+    }
+
+private:
+    // [[...],...], with the contents of each inner array consumed by read_level()
+    template <typename ReadLevel>
+    bool level_array(ReadLevel&& read_level) {
+        if (!consume('[')) {
+            return false;
+        }
+        if (consume(']')) {
+            return true;
+        }
+        do {
+            if (!consume('[') || !read_level() || !consume(']')) {
+                return false;
+            }
+        } while (consume(','));
+        return consume(']');
+    }
+
+    void skip_whitespace() {
+        while (pos_ < end_ && (*pos_ == ' ' || *pos_ == '\n' || *pos_ == '\r' || *pos_ == '\t')) {
+            ++pos_;
+        }
+    }
+
+    const char* pos_;
+    const char* end_;
+};
+
+// Value of the first "<key>":"..." in payload, or an empty view. The fallback for
+// payloads whose header read_event_header cannot walk.
+static std::string_view find_string_field(std::string_view payload, std::string_view pattern) {
+    size_t start = payload.find(pattern);
+    if (start == std::string_view::npos) {
+        return {};
+    }
+    start += pattern.size();
+    size_t end = payload.find('"', start);
+    if (end == std::string_view::npos) {
+        return {};
+    }
+    return payload.substr(start, end - start);
+}
+
+static FeedEvent event_type(std::string_view name) {
+    if (name == "trade") {
+        return FeedEvent::TRADE;
+    }
+    if (name == "depthUpdate") {
+        return FeedEvent::DEPTH_UPDATE;
+    }
+    return FeedEvent::UNKNOWN;
+}
+
+EventHeader read_event_header(const char* data, size_t size) {
+    EventHeader header;
+    bool have_name = false;
+    bool have_symbol = false;
+
+    // Walk the leading scalar fields until both are found
+    JsonCursor in(data, size);
+    if (in.consume('{')) {
+        do {
+            const char* key;
+            size_t key_length;
+            if (!in.string(key, key_length) || !in.consume(':')) {
+                break;
+            }
+            char field = key_length == 1 ? key[0] : '\0';
+            if (field == 'e' || field == 's') {
+                const char* text;
+                size_t length;
+                if (!in.string(text, length)) {
+                    break;
+                }
+                if (field == 'e') {
+                    header.name = std::string_view(text, length);
+                    have_name = true;
+                } else {
+                    header.symbol = std::string_view(text, length);
+                    have_symbol = true;
+                }
+                if (have_name && have_symbol) {
+                    break;
+                }
+            } else if (!in.skip_scalar()) {
+                break;
+            }
+        } while (in.consume(','));
+    }
+
+    // Stopped early (an array, an escape, a field missing): search the whole payload
+    std::string_view payload(data, size);
+    if (!have_name) {
+        header.name = find_string_field(payload, "\"e\":\"");
+    }
+    if (!have_symbol) {
+        header.symbol = find_string_field(payload, "\"s\":\"");
+    }
+    header.type = event_type(header.name);
+    return header;
+}
+
+// Shared by both parse_trade_message overloads: every field but the price and quantity
+// into trade, those two through read_price/read_quantity
+template <typename ReadPrice, typename ReadQuantity>
+static bool parse_trade(const char* data, size_t size, TradeMessageBinary& trade,
+                        ReadPrice&& read_price, ReadQuantity&& read_quantity) {
+    JsonCursor in(data, size);
+    if (!in.consume('{')) {
+        return false;
+    }
+
+    trade = TradeMessageBinary{};
+    bool is_trade = false;
+    bool is_buyer_maker = false;
+    if (!in.consume('}')) {
+        do {
+            const char* key;
+            size_t key_length;
+            if (!in.string(key, key_length) || !in.consume(':')) {
+                return false;
+            }
+            // null reads as a missing field, as in the generic parser
+            if (in.consume_word("null", 4)) {
+                continue;
+            }
+
+            bool ok;
+            switch (key_length == 1 ? key[0] : '\0') {
+                case 'e': {
+                    const char* type;
+                    size_t type_length;
+                    ok = in.string(type, type_length);
+                    is_trade = ok && type_length == 5 && std::memcmp(type, "trade", 5) == 0;
+                    break;
+                }
+                case 'E': ok = in.unsigned_integer(trade.event_time); break;
+                case 't': ok = in.unsigned_integer(trade.trade_id); break;
+                case 'p': ok = read_price(in); break;
+                case 'q': ok = read_quantity(in); break;
+                case 'b': ok = in.unsigned_integer(trade.buyer_order_id); break;
+                case 'a': ok = in.unsigned_integer(trade.seller_order_id); break;
+                case 'T': ok = in.unsigned_integer(trade.trade_time); break;
+                case 'm': ok = in.boolean(is_buyer_maker); break;
+                default: ok = in.skip_scalar(); break;
+            }
+            if (!ok) {
+                return false;
+            }
+        } while (in.consume(','));
+
+        if (!in.consume('}')) {
+            return false;
+        }
+    }
+    if (!is_trade || !in.at_end()) {
+        return false;
+    }
+
+    if (trade.trade_time > 0) {
+        trade.timestamp_ns = trade.trade_time * 1000000;  // ms to ns
+    } else {
+        auto now = std::chrono::high_resolution_clock::now();
+        trade.timestamp_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count();
+    }
+    trade.flags = 0;
+    trade.set_is_buyer_maker(is_buyer_maker);
+    trade.set_is_buy(!is_buyer_maker);
+    return true;
+}
+
+bool parse_trade_message(const char* data, size_t size, TradeMessageBinary& trade) {
+    return parse_trade(
+        data, size, trade,
+        [&trade](JsonCursor& in) { return in.quoted_decimal(trade.price); },
+        [&trade](JsonCursor& in) { return in.quoted_decimal(trade.quantity); });
+}
+
+bool parse_trade_message(const char* data, size_t size, const SymbolPrecision& precision,
+                         FixedTrade& trade) {
+    trade.price = 0;
+    trade.quantity = 0;
+    if (!parse_trade(
+            data, size, trade.trade,
+            [&](JsonCursor& in) { return in.quoted_decimal(precision.price_decimals, trade.price); },
+            [&](JsonCursor& in) { return in.quoted_decimal(precision.quantity_decimals, trade.quantity); })) {
+        return false;
+    }
+    trade.trade.price = fixed_to_double(trade.price, precision.price_decimals);
+    trade.trade.quantity = fixed_to_double(trade.quantity, precision.quantity_decimals);
+    return true;
+}
+
+// Shared by the parse_depth_message overloads: header fields into header, each side's
+// levels through read_bids/read_asks, so each caller decodes and stores them its own way
+template <typename ReadBids, typename ReadAsks>
+static bool parse_depth(const char* data, size_t size, DepthHeader& header,
+                        ReadBids&& read_bids, ReadAsks&& read_asks) {
+    JsonCursor in(data, size);
+    if (!in.consume('{')) {
+        return false;
+    }
+
+    header.event_time = 0;
+    header.first_update_id = 0;
+    header.final_update_id = 0;
+    bool is_depth = false;
+    if (!in.consume('}')) {
+        do {
+            const char* key;
+            size_t key_length;
+            if (!in.string(key, key_length) || !in.consume(':')) {
+                return false;
+            }
+            if (in.consume_word("null", 4)) {
+                continue;
+            }
+
+            bool ok;
+            switch (key_length == 1 ? key[0] : '\0') {
+                case 'e': {
+                    const char* type;
+                    size_t type_length;
+                    ok = in.string(type, type_length);
+                    is_depth = ok && type_length == 11 && std::memcmp(type, "depthUpdate", 11) == 0;
+                    break;
+                }
+                case 'E': ok = in.unsigned_integer(header.event_time); break;
+                case 'U': ok = in.unsigned_integer(header.first_update_id); break;
+                case 'u': ok = in.unsigned_integer(header.final_update_id); break;
+                case 'b': ok = read_bids(in); break;
+                case 'a': ok = read_asks(in); break;
+                default: ok = in.skip_scalar(); break;
+            }
+            if (!ok) {
+                return false;
+            }
+        } while (in.consume(','));
+
+        if (!in.consume('}')) {
+            return false;
+        }
+    }
+    return is_depth && in.at_end();
+}
+
+// Reader for parse_depth that appends one side's levels to levels
+static auto read_levels(DepthLevels& levels) {
+    return [&levels](JsonCursor& in) {
+        return in.levels([&levels](double price, double quantity) {
+            levels.prices.push_back(price);
+            levels.quantities.push_back(quantity);
+        });
+    };
+}
+
+static auto read_levels(FixedDepthLevels& levels, const SymbolPrecision& precision) {
+    return [&levels, &precision](JsonCursor& in) {
+        return in.levels(precision, [&levels](int64_t price, int64_t quantity) {
+            levels.prices.push_back(price);
+            levels.quantities.push_back(quantity);
+        });
+    };
+}
+
+bool parse_depth_message(const char* data, size_t size, DepthMessage& depth) {
+    depth.bids.clear();
+    depth.asks.clear();
+    return parse_depth(data, size, depth, read_levels(depth.bids), read_levels(depth.asks));
+}
+
+bool parse_depth_message(const char* data, size_t size, const SymbolPrecision& precision,
+                         FixedDepthMessage& depth) {
+    depth.bids.clear();
+    depth.asks.clear();
+    return parse_depth(data, size, depth, read_levels(depth.bids, precision),
+                       read_levels(depth.asks, precision));
+}
+
+bool parse_depth_message(const char* data, size_t size, OrderBookUpdate& update) {
+    update.bids.clear();
+    update.asks.clear();
+    DepthHeader header;
+    // Quantity of 0 means remove this price level - don't include it
+    bool parsed = parse_depth(
+        data, size, header,
+        [&update](JsonCursor& in) {
+            return in.levels([&update](double price, double quantity) {
+                if (quantity > 0) {
+                    update.bids.push_back({price, quantity});
+                }
+            });
+        },
+        [&update](JsonCursor& in) {
+            return in.levels([&update](double price, double quantity) {
+                if (quantity > 0) {
+                    update.asks.push_back({price, quantity});
+                }
+            });
+        });
+    if (!parsed) {
+        return false;
+    }
+
+    update.timestamp_ns = header.event_time * 1000000;  // ms to ns
+    if (update.timestamp_ns == 0) {
+        auto now = std::chrono::high_resolution_clock::now();
+        update.timestamp_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count();
+    }
+    update.last_update_id = header.final_update_id;
+    return true;
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "core/fixed_point.hpp"
+#include "core/serialization.hpp"
+
+// Hand-written parsers for the Binance events the connector subscribes to.
+//
+// Each works in one pass directly on the websocket payload, writes straight into the
+// caller's struct and never allocates. They only accept the layout Binance actually
+// sends: a flat object with unescaped strings. Anything else (nested values,
+// escapes, numbers where strings are expected, out-of-range integers) makes them
+// return false, and the caller falls back to the generic nlohmann-based parser,
+// which handles or rejects it as before.
+//
+// Strings are scanned for their closing quote a vector register at a time (SSE2,
+// AVX2 when the build enables it), and prices and quantities are converted with
+// SSE4.1 when the CPU has it; other targets use the scalar equivalents. Decimals are
+// rounded exactly as std::stod rounds them, or, by the overloads taking a
+// SymbolPrecision, converted to fixed point with no rounding at all.
+
+// Event types the connector routes to a parser
+enum class FeedEvent : uint8_t {
+    UNKNOWN,
+    TRADE,
+    DEPTH_UPDATE
+};
+
+// The routing fields of an event, as views into the payload
+struct EventHeader {
+    FeedEvent type = FeedEvent::UNKNOWN;
+    std::string_view name;    // "e", empty if absent
+    std::string_view symbol;  // "s", empty if absent
+};
+
+// Read the event type and symbol without parsing the rest of the payload. Binance
+// puts both in the first few fields, so this usually stops within 40 bytes; other
+// layouts are searched for the two fields instead.
+EventHeader read_event_header(const char* data, size_t size);
+
+// Convert a decimal string (digits with at most one '.') to units of 10^-decimals.
+// Returns false for any other syntax, for nonzero digits past decimals places, and
+// for values that overflow int64_t, so a successful conversion is always exact.
+bool parse_fixed_point(const char* text, size_t length, unsigned decimals, int64_t& units);
+
+// Parse a trade event ("e":"trade") into trade, with the same field mapping as
+// Serialization::parse_trade_json: missing or null fields read as 0, timestamp_ns
+// from "T" (local time if absent), is_buy the inverse of "m".
+// Returns false, leaving trade unspecified, if the payload is not a trade event in
+// the expected layout.
+bool parse_trade_message(const char* data, size_t size, TradeMessageBinary& trade);
+
+// A trade with its price and quantity decoded exactly, as by parse_fixed_point
+struct FixedTrade {
+    TradeMessageBinary trade;  // price and quantity are the units below as doubles
+    int64_t price = 0;         // Units of 10^-price_decimals
+    int64_t quantity = 0;      // Lots of 10^-quantity_decimals
+};
+
+// parse_trade_message with price and quantity at precision. Also returns false if
+// either has more decimals than precision holds, or overflows it.
+bool parse_trade_message(const char* data, size_t size, const SymbolPrecision& precision,
+                         FixedTrade& trade);
+
+// One side of a depth update as parallel arrays. The caller keeps it across messages,
+// so once it has grown to the deepest update, parsing allocates nothing.
+template <typename Value>
+struct BasicDepthLevels {
+    std::vector<Value> prices;
+    std::vector<Value> quantities;
+
+    size_t size() const { return prices.size(); }
+
+    void clear() {
+        prices.clear();
+        quantities.clear();
+    }
+
+    void reserve(size_t levels) {
+        prices.reserve(levels);
+        quantities.reserve(levels);
+    }
+};
+
+using DepthLevels = BasicDepthLevels<double>;
+// Prices in units and quantities in lots of a SymbolPrecision
+using FixedDepthLevels = BasicDepthLevels<int64_t>;
+
+// The ids and time of a diff depth event ("e":"depthUpdate")
+struct DepthHeader {
+    uint64_t event_time = 0;       // "E", ms
+    uint64_t first_update_id = 0;  // "U"
+    uint64_t final_update_id = 0;  // "u"
+};
+
+// A diff depth event as sent, zero-quantity removals included
+struct DepthMessage : DepthHeader {
+    DepthLevels bids;
+    DepthLevels asks;
+};
+
+// The same with every level decoded exactly, as by parse_fixed_point
+struct FixedDepthMessage : DepthHeader {
+    FixedDepthLevels bids;
+    FixedDepthLevels asks;
+};
+
+// Parse a depth update into depth, replacing its levels. Missing or null ids and
+// times read as 0. Returns false if the payload is not a depth update in the
+// expected layout.
+bool parse_depth_message(const char* data, size_t size, DepthMessage& depth);
+
+// parse_depth_message with levels at precision. Also returns false if any price or
+// quantity has more decimals than precision holds, or overflows it.
+bool parse_depth_message(const char* data, size_t size, const SymbolPrecision& precision,
+                         FixedDepthMessage& depth);
+
+// Parse a depth update into update with the same result as parse_orderbook_json_into:
+// zero-quantity levels dropped, timestamp_ns from "E" (local time if absent),
+// last_update_id from "u". Levels go into update's existing vectors.
+bool parse_depth_message(const char* data, size_t size, OrderBookUpdate& update);
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+// Fixed-point prices and quantities: a value is held as integer units of 10^-decimals,
+// so price levels compare and hash exactly and can serve as map keys or array indices.
+// Binance sends every price and quantity with 8 decimal places, so 8 holds any of them
+// exactly; a symbol's tick and lot size usually allow fewer, and more headroom.
+constexpr unsigned MAX_FIXED_DECIMALS = 18;
+
+// Largest |units| a price or quantity may take. Below 2^51 a double holds every unit and
+// half unit exactly, so conversions from double are exact, and tick arithmetic on such
+// units has headroom left in int64_t. Larger values are rejected, not converted.
+constexpr int64_t MAX_FIXED_UNITS = (int64_t(1) << 51) - 1;
+
+// Finest precision BINANCE_PRECISION accepts. At 8 decimals prices and quantities up to
+// MAX_FIXED_VALUE still fit in MAX_FIXED_UNITS; symbols quoted in larger quantities need
+// a coarser quantity precision, or their levels are skipped as out of range.
+constexpr unsigned MAX_SYMBOL_DECIMALS = 8;
+constexpr double MAX_FIXED_VALUE = 1e7;
+static_assert(MAX_FIXED_VALUE * 1e8 <= double(MAX_FIXED_UNITS), "8 decimals must hold MAX_FIXED_VALUE");
+
+inline bool in_fixed_range(int64_t units) {
+    return units >= -MAX_FIXED_UNITS && units <= MAX_FIXED_UNITS;
+}
+
+struct SymbolPrecision {
+    uint8_t price_decimals = 8;
+    uint8_t quantity_decimals = 8;
+};
+
+// Precision by upper-case symbol name; symbols not listed get SymbolPrecision{}, whose
+// 8 quantity decimals overflow past MAX_FIXED_VALUE, so a symbol quoted in millions of
+// units needs an entry: see fill_symbol_precision
+using PrecisionTable = std::unordered_map<std::string, SymbolPrecision>;
+
+inline SymbolPrecision precision_for(const PrecisionTable& table, const std::string& symbol) {
+    auto it = table.find(symbol);
+    return it == table.end() ? SymbolPrecision{} : it->second;
+}
+
+inline double fixed_scale(unsigned decimals) {
+    static constexpr double scale[MAX_FIXED_DECIMALS + 1] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9,
+        1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18};
+    return scale[decimals];
+}
+
+// Back to double at the output edges. For |units| up to 2^53 this is the double
+// std::stod gives for the original decimal string.
+inline double fixed_to_double(int64_t units, unsigned decimals) {
+    return static_cast<double>(units) / fixed_scale(decimals);
+}
+
+// Units of a double that came from a decimal string with at most decimals places,
+// such as a PriceLevel or TradeMessageBinary field. The product is within a fraction
+// of a unit of the exact value, so rounding recovers it exactly; values off that grid
+// go to the nearest unit. Adding the half is exact in range, so truncating gives
+// std::llround's result without the libm call. Returns false, leaving units alone,
+// for NaN, infinities and anything beyond MAX_FIXED_UNITS, whose cast would be undefined.
+inline bool to_fixed_point(double value, unsigned decimals, int64_t& units) {
+    constexpr double limit = static_cast<double>(MAX_FIXED_UNITS) + 0.5;
+    double scaled = value * fixed_scale(decimals);
+    if (!(scaled > -limit && scaled < limit)) {
+        return false;
+    }
+    units = static_cast<int64_t>(scaled >= 0.0 ? scaled + 0.5 : scaled - 0.5);
+    return true;
+}
+
+// Index of the step-sized bucket nearest to units (step > 0), halves rounded away
+// from zero as std::round does: the integer form of round(price / tick). Cannot
+// overflow while units and step are within MAX_FIXED_UNITS, and step times the result
+// is then within MAX_FIXED_UNITS + step.
+inline int64_t nearest_step(int64_t units, int64_t step) {
+    return units >= 0 ? (units + step / 2) / step : -((-units + step / 2) / step);
+}
@@ -1,7 +1,13 @@
 #include <atomic>
 #include "core/ts_queue.hpp"
+#include "core/broadcast_ring.hpp"
+#include "core/event_count.hpp"
 #include "core/serialization.hpp"
+#include "core/latency_trace.hpp"
 
 // Global variables used across multiple files
 std::atomic<bool> stop_flag(false);
-TSQueue<OrderBookUpdate> iceberg_queue;
+// Order book updates are deserialized once and read in place by every detector
+BroadcastRing<Traced<OrderBookUpdate>> orderbook_ring(1024);
+// Rung by the ring consumer after each batch it hands to orderbook_ring and trade_queue
+EventCount feed_event;
@@ -0,0 +1,32 @@
+#pragma once
+
+// Queue type used for thread-to-thread handoffs inside the pipeline, chosen at build time:
+//   -DBINANCE_HANDOFF_QUEUE=BINANCE_QUEUE_SPSC   bounded lock-free SPSCQueue (default)
+//   -DBINANCE_HANDOFF_QUEUE=BINANCE_QUEUE_MPMC   bounded lock-free MPMCQueue
+//   -DBINANCE_HANDOFF_QUEUE=BINANCE_QUEUE_MUTEX  unbounded mutex-based TSQueue
+// All expose push/pop/try_pop/empty/close/is_closed. The SPSC queue is only correct with
+// exactly one producer and one consumer thread per queue; pick MPMC when several
+// connectors feed one queue.
+#define BINANCE_QUEUE_MUTEX 0
+#define BINANCE_QUEUE_SPSC 1
+#define BINANCE_QUEUE_MPMC 2
+
+#ifndef BINANCE_HANDOFF_QUEUE
+#define BINANCE_HANDOFF_QUEUE BINANCE_QUEUE_SPSC
+#endif
+
+#if BINANCE_HANDOFF_QUEUE == BINANCE_QUEUE_SPSC
+#include "core/spsc_queue.hpp"
+template <typename T>
+using HandoffQueue = SPSCQueue<T>;
+#elif BINANCE_HANDOFF_QUEUE == BINANCE_QUEUE_MPMC
+#include "core/mpmc_queue.hpp"
+template <typename T>
+using HandoffQueue = MPMCQueue<T>;
+#elif BINANCE_HANDOFF_QUEUE == BINANCE_QUEUE_MUTEX
+#include "core/ts_queue.hpp"
+template <typename T>
+using HandoffQueue = TSQueue<T>;
+#else
+#error "Unknown BINANCE_HANDOFF_QUEUE"
+#endif
@@ -1,34 +1,74 @@
 #include "features/IcebergDetector.hpp"
-#include <iostream>
-#include <iomanip>
+#include "core/async_logger.hpp"
+#include <iterator>
+#include <utility>
 
-IcebergDetector::IcebergDetector() {}
+IcebergDetector::IcebergDetector(std::string symbol, SymbolPrecision precision)
+    : symbol_(std::move(symbol)), precision_(precision) {}
 
 IcebergDetector::~IcebergDetector() {}
 
 void IcebergDetector::process_update(const OrderBookUpdate& update) {
-    std::string symbol = "BTCUSDT"; // Default symbol since update doesn't have symbol field
-    
     // Process bids
     for (const auto& bid : update.bids) {
-        detect_iceberg(symbol, bid.price, bid.quantity, true);
+        process_level(bids_, bid, true);
     }
     
     // Process asks
     for (const auto& ask : update.asks) {
-        detect_iceberg(symbol, ask.price, ask.quantity, false);
+        process_level(asks_, ask, false);
+    }
+}
+
+void IcebergDetector::process_level(BookSide& side, const PriceLevel& level, bool is_bid) {
+    int64_t price;
+    int64_t quantity;
+    if (to_fixed_point(level.price, precision_.price_decimals, price) &&
+        to_fixed_point(level.quantity, precision_.quantity_decimals, quantity)) {
+        detect_iceberg(side, price, quantity, is_bid);
+    } else if (skipped_levels_++ == 0) {
+        log_event(LOG_ICEBERG, LOG_WARN, 0,
+                  "[Iceberg] {} level {} x {} is out of range at {}:{} decimals and skipped, as are any later ones; "
+                  "give it a coarser BINANCE_PRECISION",
+                  symbol_, level.price, level.quantity, unsigned(precision_.price_decimals),
+                  unsigned(precision_.quantity_decimals));
     }
 }
 
-void IcebergDetector::detect_iceberg(const std::string& symbol, double price, double quantity, bool is_bid) {
-    auto& level_state = book_state_[symbol][price];
+IcebergLevelState* IcebergDetector::find_level(BookSide& side, int64_t price, bool is_bid) {
+    auto it = side.lower_bound(price);
+    if (it != side.end() && it->first == price) {
+        return &it->second;
+    }
+    if (side.size() < ICEBERG_MAX_LEVELS) {
+        return &side.emplace_hint(it, price, IcebergLevelState{})->second;
+    }
+
+    // Full: recycle the node of the level farthest from the touch, unless this price
+    // is farther out still
+    auto farthest = is_bid ? side.begin() : std::prev(side.end());
+    if (is_bid ? price < farthest->first : price > farthest->first) {
+        return nullptr;
+    }
+    auto node = side.extract(farthest);
+    node.key() = price;
+    node.mapped() = IcebergLevelState{};
+    return &side.insert(std::move(node)).position->second;
+}
+
+void IcebergDetector::detect_iceberg(BookSide& side, int64_t price, int64_t quantity, bool is_bid) {
+    IcebergLevelState* state = find_level(side, price, is_bid);
+    if (!state) {
+        return;
+    }
+    auto& level_state = *state;
 
     // Simplified example logic:
     // If quantity decreased but order not fully removed, could be iceberg
     if (quantity < level_state.last_quantity && quantity > 0) {
         level_state.iceberg_counter++;
         if (level_state.iceberg_counter >= 3) {  // threshold to signal iceberg
-            emit_iceberg_event(symbol, price, is_bid);
+            emit_iceberg_event(price, is_bid);
             level_state.iceberg_counter = 0;  // reset counter after detection
         }
     } else {
@@ -38,8 +78,7 @@ void IcebergDetector::detect_iceberg(const std::string& symbol, double price, do
     level_state.last_quantity = quantity;
 }
 
-void IcebergDetector::emit_iceberg_event(const std::string& symbol, double price, bool is_bid) {
-    std::cout << "[ICEBERG DETECTED] " << symbol << " " 
-              << (is_bid ? "BID" : "ASK") << " at $" 
-              << std::fixed << std::setprecision(2) << price << std::endl;
+void IcebergDetector::emit_iceberg_event(int64_t price, bool is_bid) {
+    log_event(LOG_ICEBERG, LOG_INFO, 0, "[ICEBERG DETECTED] {} {} at ${.2}",
+              symbol_, is_bid ? "BID" : "ASK", fixed_to_double(price, precision_.price_decimals));
 }
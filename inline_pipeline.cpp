@@ -0,0 +1,23 @@
+#include "features/inline_pipeline.hpp"
+
+InlinePipeline::InlinePipeline(IcebergDetector& iceberg_detector, LiquidityTracker& liquidity_tracker)
+    : iceberg_detector_(iceberg_detector),
+      liquidity_tracker_(liquidity_tracker) {}
+
+void InlinePipeline::on_trade(SymbolId, const TradeMessageBinary& trade, const TraceStamps& trace) {
+    liquidity_tracker_.onTrade(trade);
+    record_trace(trace, trace_stamp());
+}
+
+void InlinePipeline::on_orderbook(SymbolId, const OrderBookUpdate& book, const TraceStamps& trace) {
+    iceberg_detector_.process_update(book);
+
+    bids_.clear();
+    asks_.clear();
+    for (const auto& bid : book.bids)
+        bids_.push_back({bid.price, bid.quantity});
+    for (const auto& ask : book.asks)
+        asks_.push_back({ask.price, ask.quantity});
+    liquidity_tracker_.onOrderBookUpdate(book.timestamp_ns, bids_, asks_);
+    record_trace(trace, trace_stamp());
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <vector>
+#include "io/binance_connector.hpp"
+#include "features/IcebergDetector.hpp"
+#include "features/liquidity_tracker.hpp"
+
+// Run-to-completion wiring: the detectors run synchronously inside the libwebsockets
+// receive callback, so a message goes from socket to LiquidityTracker with no queue
+// hop, copy to shared memory or thread wake-up. Everything runs on the network
+// thread, in arrival order; a slow detector delays reading the socket.
+class InlinePipeline : public FeedHandler {
+public:
+    InlinePipeline(IcebergDetector& iceberg_detector, LiquidityTracker& liquidity_tracker);
+
+    // Symbol ids are ignored: the detectors given here see every symbol's messages.
+    // The trace is recorded once both detectors are done with the message.
+    void on_trade(SymbolId symbol, const TradeMessageBinary& trade, const TraceStamps& trace) override;
+    void on_orderbook(SymbolId symbol, const OrderBookUpdate& book, const TraceStamps& trace) override;
+
+private:
+    IcebergDetector& iceberg_detector_;
+    LiquidityTracker& liquidity_tracker_;
+
+    std::vector<OrderBookLevel> bids_;  // Reused across updates
+    std::vector<OrderBookLevel> asks_;
+};
@@ -0,0 +1,454 @@
+#include "io/journal.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>       // placement new
+#include <stdexcept>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr char JOURNAL_PREFIX[] = "journal-";
+constexpr char JOURNAL_SPARE[] = "journal-spare";
+constexpr size_t SEQUENCE_DIGITS = 20;
+
+std::runtime_error sys_error(const std::string& what) {
+    return std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+struct JournalFile {
+    uint64_t first_sequence;
+    std::string stem;  // Path without the .dat/.idx extension
+};
+
+// Finished and in-progress journal files in dir, oldest first
+std::vector<JournalFile> list_journal(const std::string& dir) {
+    std::vector<JournalFile> files;
+    DIR* d = opendir(dir.c_str());
+    if (!d) {
+        return files;
+    }
+    const size_t prefix_len = sizeof(JOURNAL_PREFIX) - 1;
+    while (dirent* entry = readdir(d)) {
+        std::string name = entry->d_name;
+        if (name.size() != prefix_len + SEQUENCE_DIGITS + 4 ||
+            name.compare(0, prefix_len, JOURNAL_PREFIX) != 0 ||
+            name.compare(name.size() - 4, 4, ".dat") != 0) {
+            continue;
+        }
+        std::string digits = name.substr(prefix_len, SEQUENCE_DIGITS);
+        if (digits.find_first_not_of("0123456789") != std::string::npos) {
+            continue;
+        }
+        files.push_back({std::strtoull(digits.c_str(), nullptr, 10),
+                         dir + "/" + name.substr(0, name.size() - 4)});
+    }
+    closedir(d);
+    std::sort(files.begin(), files.end(), [](const JournalFile& a, const JournalFile& b) {
+        return a.first_sequence < b.first_sequence;
+    });
+    return files;
+}
+
+// Map a whole file read-only; returns nullptr for an empty or missing file
+const uint8_t* map_readonly(const std::string& path, size_t& size) {
+    size = 0;
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return nullptr;
+    }
+    struct stat st;
+    void* mapping = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        mapping = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        return nullptr;
+    }
+    size = static_cast<size_t>(st.st_size);
+    return static_cast<const uint8_t*>(mapping);
+}
+
+// Number of complete frames in a .dat file
+uint64_t count_frames(const std::string& path) {
+    size_t size;
+    const uint8_t* data = map_readonly(path, size);
+    uint64_t frames = 0;
+    size_t pos = 0;
+    while (data && pos + FRAME_HEADER_SIZE <= size && data[pos] != 0) {
+        uint32_t len;
+        std::memcpy(&len, data + pos + 1, sizeof(uint32_t));
+        if (pos + FRAME_HEADER_SIZE + len > size) {
+            break;  // Torn by a crash mid-write
+        }
+        pos += FRAME_HEADER_SIZE + len;
+        ++frames;
+    }
+    if (data) munmap(const_cast<uint8_t*>(data), size);
+    return frames;
+}
+
+} // namespace
+
+FrameJournal::Segment::~Segment() {
+    if (data) munmap(data, size);
+    if (index) munmap(index, sizeof(JournalIndexHeader) + index_capacity * sizeof(JournalIndexEntry));
+    if (data_fd >= 0) close(data_fd);
+    if (index_fd >= 0) close(index_fd);
+}
+
+FrameJournal::FrameJournal(const std::string& dir, size_t file_size, std::chrono::milliseconds flush_interval)
+    : dir_(dir), file_size_(file_size), flush_interval_(flush_interval) {
+    if (file_size_ < JOURNAL_INDEX_STRIDE) {
+        throw std::runtime_error("Journal file size must be at least " +
+                                 std::to_string(JOURNAL_INDEX_STRIDE) + " bytes");
+    }
+    if (mkdir(dir_.c_str(), 0755) != 0 && errno != EEXIST) {
+        throw sys_error("Failed to create journal directory " + dir_);
+    }
+
+    // Carry the sequence on from the previous run, always starting a fresh file
+    std::vector<JournalFile> files = list_journal(dir_);
+    if (!files.empty()) {
+        sequence_ = files.back().first_sequence + count_frames(files.back().stem + ".dat");
+    }
+    std::string spare = dir_ + "/" + JOURNAL_SPARE;
+    unlink((spare + ".dat").c_str());
+    unlink((spare + ".idx").c_str());
+
+    active_ = create_segment(stem_for(sequence_), file_size_);
+    flush_target_.store(active_.get(), std::memory_order_release);
+    flusher_ = std::thread(&FrameJournal::flush_loop, this);
+}
+
+FrameJournal::~FrameJournal() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cond_.notify_one();
+    if (flusher_.joinable()) flusher_.join();
+
+    sync(*active_, true);
+    if (spare_) {
+        unlink(spare_->data_path.c_str());
+        unlink(spare_->index_path.c_str());
+    }
+}
+
+std::string FrameJournal::stem_for(uint64_t sequence) const {
+    char name[sizeof(JOURNAL_PREFIX) + SEQUENCE_DIGITS];
+    std::snprintf(name, sizeof(name), "%s%020" PRIu64, JOURNAL_PREFIX, sequence);
+    return dir_ + "/" + name;
+}
+
+std::unique_ptr<FrameJournal::Segment> FrameJournal::create_segment(const std::string& stem, size_t size) {
+    std::unique_ptr<Segment> segment(new Segment);
+    segment->data_path = stem + ".dat";
+    segment->index_path = stem + ".idx";
+
+    // Both files are created sparse; unwritten space reads back as zeros, i.e. end of data
+    segment->data_fd = open(segment->data_path.c_str(), O_CREAT | O_TRUNC | O_RDWR | O_CLOEXEC, 0644);
+    if (segment->data_fd < 0 || ftruncate(segment->data_fd, static_cast<off_t>(size)) != 0) {
+        throw sys_error("Failed to create journal file " + segment->data_path);
+    }
+    void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, segment->data_fd, 0);
+    if (data == MAP_FAILED) {
+        throw sys_error("Failed to map journal file " + segment->data_path);
+    }
+    segment->data = static_cast<uint8_t*>(data);
+    segment->size = size;
+
+    size_t capacity = size / JOURNAL_INDEX_STRIDE + 2;
+    size_t index_size = sizeof(JournalIndexHeader) + capacity * sizeof(JournalIndexEntry);
+    segment->index_fd = open(segment->index_path.c_str(), O_CREAT | O_TRUNC | O_RDWR | O_CLOEXEC, 0644);
+    if (segment->index_fd < 0 || ftruncate(segment->index_fd, static_cast<off_t>(index_size)) != 0) {
+        throw sys_error("Failed to create journal index " + segment->index_path);
+    }
+    void* index = mmap(nullptr, index_size, PROT_READ | PROT_WRITE, MAP_SHARED, segment->index_fd, 0);
+    if (index == MAP_FAILED) {
+        throw sys_error("Failed to map journal index " + segment->index_path);
+    }
+    segment->index = new (index) JournalIndexHeader;
+    segment->index->count.store(0, std::memory_order_relaxed);
+    segment->index_capacity = capacity;
+    return segment;
+}
+
+void FrameJournal::append(uint8_t type, const uint8_t* body, uint32_t len, uint64_t timestamp_ns) {
+    size_t frame_bytes = FRAME_HEADER_SIZE + len;
+    if (write_pos_ + frame_bytes > active_->size) {
+        try {
+            roll(frame_bytes);
+        } catch (const std::exception& e) {
+            std::cerr << "[Journal] " << e.what() << ", frame " << sequence_ << " not journaled" << std::endl;
+            return;
+        }
+    }
+
+    Segment& segment = *active_;
+    if (write_pos_ >= next_index_pos_) {
+        uint64_t count = segment.index->count.load(std::memory_order_relaxed);
+        if (count < segment.index_capacity) {
+            segment.entries()[count] = JournalIndexEntry{sequence_, timestamp_ns, write_pos_};
+            segment.index->count.store(count + 1, std::memory_order_release);
+        }
+        next_index_pos_ = (write_pos_ / JOURNAL_INDEX_STRIDE + 1) * JOURNAL_INDEX_STRIDE;
+    }
+
+    // Type byte last: a reader of a crashed file sees either the whole frame or the end marker
+    uint8_t* out = segment.data + write_pos_;
+    std::memcpy(out + 1, &len, sizeof(uint32_t));
+    std::memcpy(out + FRAME_HEADER_SIZE, body, len);
+    out[0] = type;
+
+    write_pos_ += frame_bytes;
+    segment.written.store(write_pos_, std::memory_order_release);
+    ++sequence_;
+}
+
+// Switch to a new file starting at the current sequence. The flusher normally has a
+// spare file ready, so this is a rename rather than file creation on the producer.
+void FrameJournal::roll(size_t min_size) {
+    std::unique_ptr<Segment> next;
+    std::string stem = stem_for(sequence_);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (spare_ && spare_->size >= min_size) {
+            // Renamed under the lock so the flusher cannot recreate the spare meanwhile
+            if (rename(spare_->data_path.c_str(), (stem + ".dat").c_str()) == 0 &&
+                rename(spare_->index_path.c_str(), (stem + ".idx").c_str()) == 0) {
+                next = std::move(spare_);
+                next->data_path = stem + ".dat";
+                next->index_path = stem + ".idx";
+            }
+        }
+    }
+    if (!next) {
+        next = create_segment(stem, std::max(file_size_, min_size));
+    }
+
+    {
+        // The flusher reads flush_target_ under the lock, so it never picks up the old
+        // segment once it is on retired_ and may be freed
+        std::lock_guard<std::mutex> lock(mutex_);
+        flush_target_.store(next.get(), std::memory_order_release);
+        retired_.push_back(std::move(active_));
+        active_ = std::move(next);
+    }
+    cond_.notify_one();
+    write_pos_ = 0;
+    next_index_pos_ = 0;
+}
+
+// Push newly written bytes to disk. Retired files are also trimmed to their used length.
+void FrameJournal::sync(Segment& segment, bool final) {
+    size_t written = segment.written.load(std::memory_order_acquire);
+    if (written > segment.synced) {
+        size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        size_t start = segment.synced & ~(page_size - 1);
+        msync(segment.data + start, written - start, MS_SYNC);
+        msync(segment.index, sizeof(JournalIndexHeader) +
+              segment.index_capacity * sizeof(JournalIndexEntry), MS_SYNC);
+        segment.synced = written;
+    }
+    if (final) {
+        uint64_t entries = segment.index->count.load(std::memory_order_acquire);
+        if (ftruncate(segment.data_fd, static_cast<off_t>(written)) != 0 ||
+            ftruncate(segment.index_fd, static_cast<off_t>(sizeof(JournalIndexHeader) +
+                                                           entries * sizeof(JournalIndexEntry))) != 0) {
+            std::cerr << "[Journal] Failed to trim " << segment.data_path << ": "
+                      << std::strerror(errno) << std::endl;
+        }
+        fdatasync(segment.data_fd);
+        fdatasync(segment.index_fd);
+    }
+}
+
+// Fault pages in ahead of the producer so append() does not take the page faults
+void FrameJournal::prefault(Segment& segment) {
+    size_t target = std::min(segment.size, segment.written.load(std::memory_order_acquire) +
+                                           JOURNAL_PREFAULT_AHEAD);
+    if (target > segment.prefaulted) {
+        madvise(segment.data + segment.prefaulted, target - segment.prefaulted, MADV_POPULATE_WRITE);
+        segment.prefaulted = target;
+    }
+}
+
+void FrameJournal::flush_loop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        cond_.wait_for(lock, flush_interval_, [this] { return stopping_ || !retired_.empty(); });
+        std::vector<std::unique_ptr<Segment>> retired;
+        retired.swap(retired_);
+        bool need_spare = !spare_ && !stopping_;
+        bool stopping = stopping_;
+        Segment* target = flush_target_.load(std::memory_order_acquire);
+        lock.unlock();
+
+        // Segments are only ever freed here, so the target stays valid while we sync it
+        // even if the producer retires it in the meantime: it is freed on a later pass
+        for (auto& segment : retired) {
+            sync(*segment, true);
+        }
+        retired.clear();
+        if (!stopping) {
+            sync(*target, false);
+            prefault(*target);
+        }
+
+        std::unique_ptr<Segment> spare;
+        if (need_spare) {
+            try {
+                spare = create_segment(dir_ + "/" + JOURNAL_SPARE, file_size_);
+                prefault(*spare);
+            } catch (const std::exception& e) {
+                std::cerr << "[Journal] " << e.what() << std::endl;
+            }
+        }
+
+        lock.lock();
+        if (spare) spare_ = std::move(spare);
+        if (stopping) break;
+    }
+}
+
+JournalReader::JournalReader(const std::string& dir) {
+    for (const JournalFile& file : list_journal(dir)) {
+        files_.push_back({file.first_sequence, file.stem});
+    }
+    if (!files_.empty()) {
+        open_file(0);
+    }
+}
+
+JournalReader::~JournalReader() {
+    close_file();
+}
+
+void JournalReader::close_file() {
+    if (data_) munmap(const_cast<uint8_t*>(data_), data_size_);
+    if (index_) munmap(const_cast<uint8_t*>(index_), index_size_);
+    data_ = index_ = nullptr;
+    data_size_ = index_size_ = 0;
+}
+
+bool JournalReader::open_file(size_t index) {
+    close_file();
+    file_ = index;
+    pos_ = 0;
+    sequence_ = files_[index].first_sequence;
+    data_ = map_readonly(files_[index].stem + ".dat", data_size_);
+    index_ = map_readonly(files_[index].stem + ".idx", index_size_);
+    return data_ != nullptr;
+}
+
+uint64_t JournalReader::index_count() const {
+    if (!index_ || index_size_ < sizeof(JournalIndexHeader)) {
+        return 0;
+    }
+    uint64_t count = reinterpret_cast<const JournalIndexHeader*>(index_)->count.load(std::memory_order_acquire);
+    uint64_t fits = (index_size_ - sizeof(JournalIndexHeader)) / sizeof(JournalIndexEntry);
+    return std::min(count, fits);
+}
+
+const JournalIndexEntry* JournalReader::entries() const {
+    return reinterpret_cast<const JournalIndexEntry*>(index_ + sizeof(JournalIndexHeader));
+}
+
+std::optional<RingFrame> JournalReader::next() {
+    for (;;) {
+        if (data_ && pos_ + FRAME_HEADER_SIZE <= data_size_ && data_[pos_] != 0) {
+            uint32_t len;
+            std::memcpy(&len, data_ + pos_ + 1, sizeof(uint32_t));
+            if (pos_ + FRAME_HEADER_SIZE + len > data_size_) {
+                return std::nullopt;  // Torn by a crash mid-write
+            }
+            RingFrame frame{data_[pos_], data_ + pos_ + FRAME_HEADER_SIZE, len};
+            pos_ += FRAME_HEADER_SIZE + len;
+            ++sequence_;
+            return frame;
+        }
+        if (file_ + 1 >= files_.size()) {
+            return std::nullopt;
+        }
+        open_file(file_ + 1);
+    }
+}
+
+bool JournalReader::seek_sequence(uint64_t sequence) {
+    if (files_.empty() || sequence < files_.front().first_sequence) {
+        return false;
+    }
+    auto it = std::upper_bound(files_.begin(), files_.end(), sequence,
+                               [](uint64_t seq, const File& file) { return seq < file.first_sequence; });
+    open_file(static_cast<size_t>(it - files_.begin()) - 1);
+
+    // Jump to the last indexed frame at or before the target, then walk
+    const JournalIndexEntry* first = entries();
+    const JournalIndexEntry* last = first + index_count();
+    const JournalIndexEntry* entry = std::upper_bound(first, last, sequence,
+        [](uint64_t seq, const JournalIndexEntry& e) { return seq < e.sequence; });
+    if (entry != first) {
+        --entry;
+        pos_ = entry->offset;
+        sequence_ = entry->sequence;
+    }
+
+    while (sequence_ < sequence) {
+        if (!next()) {
+            return false;
+        }
+    }
+    // Make sure a frame actually exists at the target
+    size_t file = file_;
+    size_t pos = pos_;
+    if (!next()) {
+        return false;
+    }
+    if (file_ == file) {
+        pos_ = pos;
+        --sequence_;
+    } else {
+        open_file(file_);
+    }
+    return true;
+}
+
+bool JournalReader::seek_timestamp(uint64_t timestamp_ns) {
+    if (files_.empty()) {
+        return false;
+    }
+
+    // Last file whose first frame is stamped before the target
+    size_t target = 0;
+    for (size_t i = 0; i < files_.size(); ++i) {
+        open_file(i);
+        if (index_count() == 0 || entries()[0].timestamp_ns >= timestamp_ns) {
+            break;
+        }
+        target = i;
+    }
+    open_file(target);
+
+    // Index timestamps rise with the stream at stride granularity
+    const JournalIndexEntry* first = entries();
+    const JournalIndexEntry* last = first + index_count();
+    const JournalIndexEntry* entry = std::lower_bound(first, last, timestamp_ns,
+        [](const JournalIndexEntry& e, uint64_t ts) { return e.timestamp_ns < ts; });
+    if (entry != first) {
+        --entry;
+        pos_ = entry->offset;
+        sequence_ = entry->sequence;
+    }
+    return data_ && pos_ + FRAME_HEADER_SIZE <= data_size_ && data_[pos_] != 0;
+}
@@ -0,0 +1,143 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+#include "io/mmap_buffer.hpp"
+
+// On-disk layout
+// --------------
+// <dir>/journal-<first sequence, 20 digits>.dat holds frames back to back in the ring's
+// framing (1-byte type, 4-byte length, body), so consume_ring_buffer()-style code can
+// parse a journal directly. A type byte of 0 (or the end of the file) marks the end.
+// The matching .idx file holds a JournalIndexHeader followed by one JournalIndexEntry
+// for the first frame of the file and for the first frame in every following
+// JOURNAL_INDEX_STRIDE bytes.
+
+// Data bytes between index entries; a seek scans at most this much
+constexpr size_t JOURNAL_INDEX_STRIDE = 64 * 1024;
+
+// How far ahead of the producer the flusher faults in journal pages
+constexpr size_t JOURNAL_PREFAULT_AHEAD = 4 * 1024 * 1024;
+
+struct JournalIndexHeader {
+    std::atomic<uint64_t> count;  // Entries written so far
+};
+
+struct JournalIndexEntry {
+    uint64_t sequence;
+    uint64_t timestamp_ns;  // Exchange timestamp passed to MMapBuffer::commit()
+    uint64_t offset;        // Byte offset of the frame in the .dat file
+};
+
+// Append-only writer behind MMapBuffer's journal mode. append() is called from the
+// producer thread and only copies into a memory-mapped file; a background thread
+// msyncs/fdatasyncs new data every flush interval and prepares the next file, so the
+// hot path never waits on the disk. Each run starts a new file and carries on the
+// sequence numbers found in dir.
+class FrameJournal {
+public:
+    FrameJournal(const std::string& dir, size_t file_size, std::chrono::milliseconds flush_interval);
+    ~FrameJournal();
+
+    FrameJournal(const FrameJournal&) = delete;
+    FrameJournal& operator=(const FrameJournal&) = delete;
+
+    void append(uint8_t type, const uint8_t* body, uint32_t len, uint64_t timestamp_ns);
+
+    // Sequence number the next appended frame will get
+    uint64_t next_sequence() const { return sequence_; }
+
+private:
+    struct Segment {
+        std::string data_path;
+        std::string index_path;
+        int data_fd = -1;
+        int index_fd = -1;
+        uint8_t* data = nullptr;
+        size_t size = 0;
+        JournalIndexHeader* index = nullptr;
+        size_t index_capacity = 0;          // Entries the .idx mapping can hold
+        std::atomic<size_t> written{0};     // Published by the producer for the flusher
+        size_t synced = 0;                  // Flusher-only
+        size_t prefaulted = 0;              // Flusher-only
+        ~Segment();
+        JournalIndexEntry* entries() { return reinterpret_cast<JournalIndexEntry*>(index + 1); }
+    };
+
+    std::unique_ptr<Segment> create_segment(const std::string& stem, size_t size);
+    void roll(size_t min_size);
+    void flush_loop();
+    void sync(Segment& segment, bool final);
+    void prefault(Segment& segment);
+    std::string stem_for(uint64_t sequence) const;
+
+    std::string dir_;
+    size_t file_size_;
+    std::chrono::milliseconds flush_interval_;
+
+    // Producer-local
+    std::unique_ptr<Segment> active_;
+    uint64_t sequence_ = 0;
+    size_t write_pos_ = 0;
+    size_t next_index_pos_ = 0;
+
+    // Shared with the flusher
+    std::atomic<Segment*> flush_target_{nullptr};
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    std::vector<std::unique_ptr<Segment>> retired_;
+    std::unique_ptr<Segment> spare_;
+    bool stopping_ = false;
+    std::thread flusher_;
+};
+
+// Read side: replays a journal directory and seeks by sequence number or timestamp.
+class JournalReader {
+public:
+    explicit JournalReader(const std::string& dir);
+    ~JournalReader();
+
+    JournalReader(const JournalReader&) = delete;
+    JournalReader& operator=(const JournalReader&) = delete;
+
+    // Position on the frame with this sequence number; false if it is not in the journal
+    bool seek_sequence(uint64_t sequence);
+    // Position on the last indexed frame stamped before timestamp_ns, at most one index
+    // stride ahead of the first frame at or after it. Frames only carry timestamps in
+    // their payload, so callers skip forward from there. False if the journal is empty.
+    bool seek_timestamp(uint64_t timestamp_ns);
+
+    // Next frame, viewed in place in the mapped file; valid until the next call
+    std::optional<RingFrame> next();
+
+    // Sequence number of the frame the next call to next() returns
+    uint64_t sequence() const { return sequence_; }
+
+private:
+    struct File {
+        uint64_t first_sequence;
+        std::string stem;
+    };
+
+    bool open_file(size_t index);
+    void close_file();
+    uint64_t index_count() const;
+    const JournalIndexEntry* entries() const;
+
+    std::vector<File> files_;
+    size_t file_ = 0;
+    const uint8_t* data_ = nullptr;
+    size_t data_size_ = 0;
+    const uint8_t* index_ = nullptr;
+    size_t index_size_ = 0;
+    size_t pos_ = 0;
+    uint64_t sequence_ = 0;
+};
@@ -0,0 +1,160 @@
+#include "core/latency_trace.hpp"
+#include <algorithm>
+#include <csignal>
+#include <iomanip>
+#include <iostream>
+
+std::atomic<bool> latency_tracing(false);
+
+// How often the reporter checks for SIGUSR1 between interval reports
+constexpr auto REPORT_POLL_INTERVAL = std::chrono::milliseconds(100);
+
+static LatencyHistogram span_histograms[TRACE_SPAN_COUNT];
+
+static volatile std::sig_atomic_t report_requested = 0;
+
+static void request_report(int) {
+    report_requested = 1;
+}
+
+const char* trace_span_name(TraceSpan span) {
+    switch (span) {
+        case SPAN_PARSE: return "parse";
+        case SPAN_PUBLISH: return "publish";
+        case SPAN_RING: return "ring";
+        case SPAN_DETECT: return "detect";
+        case SPAN_END_TO_END: return "end_to_end";
+        default: return "unknown";
+    }
+}
+
+uint64_t LatencyHistogram::bucket_upper_bound(size_t index) {
+    if (index < (size_t(1) << SUB_BUCKET_BITS)) {
+        return index;
+    }
+    size_t shift = index / HALF_BUCKET - 1;
+    uint64_t sub_bucket = index - shift * HALF_BUCKET;
+    return ((sub_bucket + 1) << shift) - 1;
+}
+
+void LatencyHistogram::update_max(uint64_t value_ns) {
+    uint64_t seen = max_.load(std::memory_order_relaxed);
+    while (value_ns > seen &&
+           !max_.compare_exchange_weak(seen, value_ns, std::memory_order_relaxed)) {
+    }
+}
+
+LatencyHistogram::Summary LatencyHistogram::summary() const {
+    uint64_t counts[BUCKET_COUNT];
+    uint64_t total = 0;
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+        counts[i] = counts_[i].load(std::memory_order_relaxed);
+        total += counts[i];
+    }
+
+    Summary result{total, 0, 0, 0, max_.load(std::memory_order_relaxed)};
+    if (total == 0) {
+        return result;
+    }
+
+    // Smallest bucket whose cumulative count reaches the quantile, reported as the
+    // largest value in that bucket but never above the true max
+    auto percentile = [&](double quantile) {
+        uint64_t rank = static_cast<uint64_t>(quantile * static_cast<double>(total));
+        if (rank == 0) rank = 1;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+            seen += counts[i];
+            if (seen >= rank) {
+                return std::min(bucket_upper_bound(i), result.max_ns);
+            }
+        }
+        return result.max_ns;
+    };
+    result.p50_ns = percentile(0.50);
+    result.p99_ns = percentile(0.99);
+    result.p999_ns = percentile(0.999);
+    return result;
+}
+
+// A span whose end was stamped before its start (stamps from a clock that stepped, or
+// a corrupted frame) is dropped rather than recorded as a huge unsigned value
+static void record_span(TraceSpan span, uint64_t start_ns, uint64_t end_ns) {
+    if (end_ns >= start_ns) {
+        span_histograms[span].record(end_ns - start_ns);
+    }
+}
+
+void record_trace(const TraceStamps& trace, uint64_t done_ns) {
+    if (trace.received_ns == 0 || done_ns == 0) {
+        return;
+    }
+    if (trace.parsed_ns != 0) {
+        record_span(SPAN_PARSE, trace.received_ns, trace.parsed_ns);
+        if (trace.committed_ns != 0) {
+            record_span(SPAN_PUBLISH, trace.parsed_ns, trace.committed_ns);
+        }
+    }
+    if (trace.committed_ns != 0 && trace.dequeued_ns != 0) {
+        record_span(SPAN_RING, trace.committed_ns, trace.dequeued_ns);
+    }
+    uint64_t detect_start = trace.dequeued_ns != 0 ? trace.dequeued_ns : trace.parsed_ns;
+    if (detect_start != 0) {
+        record_span(SPAN_DETECT, detect_start, done_ns);
+    }
+    record_span(SPAN_END_TO_END, trace.received_ns, done_ns);
+}
+
+LatencyHistogram::Summary trace_summary(TraceSpan span) {
+    return span_histograms[span].summary();
+}
+
+void print_latency_report(std::ostream& out) {
+    auto micros = [](uint64_t ns) { return static_cast<double>(ns) / 1000.0; };
+    for (int span = 0; span < TRACE_SPAN_COUNT; ++span) {
+        LatencyHistogram::Summary summary = trace_summary(static_cast<TraceSpan>(span));
+        out << "[Latency] " << std::left << std::setw(10) << trace_span_name(static_cast<TraceSpan>(span))
+            << std::right << " n=" << summary.count << std::fixed << std::setprecision(2)
+            << " p50=" << micros(summary.p50_ns) << "us"
+            << " p99=" << micros(summary.p99_ns) << "us"
+            << " p99.9=" << micros(summary.p999_ns) << "us"
+            << " max=" << micros(summary.max_ns) << "us" << std::endl;
+    }
+}
+
+LatencyReporter::LatencyReporter(std::chrono::milliseconds interval)
+    : interval_(interval) {}
+
+LatencyReporter::~LatencyReporter() {
+    stop();
+}
+
+void LatencyReporter::start() {
+    std::signal(SIGUSR1, request_report);
+    stopping_ = false;
+    thread_ = std::thread([this]() { run(); });
+}
+
+void LatencyReporter::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cond_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void LatencyReporter::run() {
+    auto next_report = std::chrono::steady_clock::now() + interval_;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!cond_.wait_for(lock, REPORT_POLL_INTERVAL, [this] { return stopping_; })) {
+        bool due = interval_.count() > 0 && std::chrono::steady_clock::now() >= next_report;
+        if (report_requested || due) {
+            report_requested = 0;
+            print_latency_report(std::cout);
+            next_report = std::chrono::steady_clock::now() + interval_;
+        }
+    }
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <thread>
+
+// When each stage of the pipeline handled a message, in steady_clock nanoseconds
+// (CLOCK_MONOTONIC, so stamps taken in different processes on the host compare).
+// A stage the message did not pass through, or a stamp taken with tracing off, is 0.
+struct TraceStamps {
+    uint64_t received_ns = 0;   // Network callback entered
+    uint64_t parsed_ns = 0;     // JSON decoded
+    uint64_t committed_ns = 0;  // Frame about to be committed to the feed ring
+    uint64_t dequeued_ns = 0;   // Frame taken off the feed ring by the consumer
+};
+
+// A message travelling between threads together with its stamps
+template <typename T>
+struct Traced {
+    T message;
+    TraceStamps trace;
+};
+
+// Intervals recorded for every traced message once its detectors are done
+enum TraceSpan {
+    SPAN_PARSE,       // received -> parsed
+    SPAN_PUBLISH,     // parsed -> committed (serialization and ring reservation)
+    SPAN_RING,        // committed -> dequeued (waiting in the feed ring)
+    SPAN_DETECT,      // dequeued (or parsed, when inline) -> detectors done, including
+                      // any hand-off to a detector thread
+    SPAN_END_TO_END,  // received -> detectors done
+    TRACE_SPAN_COUNT
+};
+
+const char* trace_span_name(TraceSpan span);
+
+// Log-linear latency histogram in the style of HdrHistogram: 64 linear sub-buckets per
+// power of two, so any recorded value is reported to within 1/64 (about 1.6%), from
+// 1 ns up to LatencyHistogram::MAX_VALUE_NS. Larger values are clamped to the top bucket
+// but still counted in max. record() is two relaxed atomic operations and safe from
+// any number of threads.
+class LatencyHistogram {
+public:
+    static constexpr unsigned SUB_BUCKET_BITS = 7;
+    static constexpr unsigned MAX_VALUE_BITS = 40;  // About 18 minutes
+    static constexpr uint64_t MAX_VALUE_NS = (uint64_t(1) << MAX_VALUE_BITS) - 1;
+
+    struct Summary {
+        uint64_t count;
+        uint64_t p50_ns;
+        uint64_t p99_ns;
+        uint64_t p999_ns;
+        uint64_t max_ns;
+    };
+
+    void record(uint64_t value_ns) {
+        uint64_t clamped = value_ns < MAX_VALUE_NS ? value_ns : MAX_VALUE_NS;
+        counts_[bucket_index(clamped)].fetch_add(1, std::memory_order_relaxed);
+        if (value_ns > max_.load(std::memory_order_relaxed)) {
+            update_max(value_ns);
+        }
+    }
+
+    // Reads the counters without stopping writers; a concurrent snapshot may miss the
+    // values recorded while it runs
+    Summary summary() const;
+
+private:
+    static constexpr size_t HALF_BUCKET = size_t(1) << (SUB_BUCKET_BITS - 1);
+    static constexpr size_t BUCKET_COUNT =
+        (MAX_VALUE_BITS - SUB_BUCKET_BITS + 2) * HALF_BUCKET;
+
+    // Values below 2^SUB_BUCKET_BITS map to themselves; above that, each power of two
+    // spans HALF_BUCKET buckets, the value shifted down to its top SUB_BUCKET_BITS bits
+    static size_t bucket_index(uint64_t value) {
+        if (value < (uint64_t(1) << SUB_BUCKET_BITS)) {
+            return static_cast<size_t>(value);
+        }
+        unsigned shift = 63 - static_cast<unsigned>(__builtin_clzll(value)) - (SUB_BUCKET_BITS - 1);
+        return shift * HALF_BUCKET + static_cast<size_t>(value >> shift);
+    }
+
+    // Largest value that lands in bucket index
+    static uint64_t bucket_upper_bound(size_t index);
+
+    void update_max(uint64_t value_ns);
+
+    std::atomic<uint64_t> counts_[BUCKET_COUNT] = {};
+    std::atomic<uint64_t> max_{0};
+};
+
+// Tracing is off until enabled at startup; while off, trace_stamp() returns 0 and
+// nothing is recorded
+extern std::atomic<bool> latency_tracing;
+
+inline bool latency_tracing_enabled() {
+    return latency_tracing.load(std::memory_order_relaxed);
+}
+
+// Current time for a TraceStamps field, or 0 with tracing off
+inline uint64_t trace_stamp() {
+    if (!latency_tracing_enabled()) {
+        return 0;
+    }
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// Record every span of a message whose detectors finished at done_ns. Messages that
+// were never stamped (tracing off at the producer, or replayed frames) are skipped.
+void record_trace(const TraceStamps& trace, uint64_t done_ns);
+
+LatencyHistogram::Summary trace_summary(TraceSpan span);
+
+// One "[Latency] ..." line per span with its count, p50, p99, p99.9 and max
+void print_latency_report(std::ostream& out);
+
+// Prints the latency report every interval, and whenever the process gets SIGUSR1.
+// With a zero interval it only prints on the signal.
+class LatencyReporter {
+public:
+    explicit LatencyReporter(std::chrono::milliseconds interval);
+    ~LatencyReporter();
+
+    LatencyReporter(const LatencyReporter&) = delete;
+    LatencyReporter& operator=(const LatencyReporter&) = delete;
+
+    void start();
+    void stop();
+
+private:
+    void run();
+
+    std::chrono::milliseconds interval_;
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    bool stopping_ = false;
+};
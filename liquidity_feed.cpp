@@ -0,0 +1,176 @@
+#include "features/liquidity_feed.hpp"
+#include "core/async_logger.hpp"
+#include <algorithm>
+
+// How long an idle feed sleeps before re-checking for shutdown
+constexpr auto LIQUIDITY_IDLE_WAIT = std::chrono::milliseconds(100);
+
+// Bump a counter only this thread writes
+static void count(std::atomic<uint64_t>& counter) {
+    counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+LiquidityFeed::LiquidityFeed(LiquidityTracker& tracker,
+                             BroadcastRing<Traced<OrderBookUpdate>>& books, size_t cursor,
+                             HandoffQueue<Traced<TradeMessageBinary>>& trades,
+                             EventCount& wakeup,
+                             std::chrono::milliseconds max_hold)
+    : tracker_(tracker),
+      books_(books),
+      cursor_(cursor),
+      trades_(trades),
+      wakeup_(wakeup),
+      max_hold_(max_hold) {
+    // A couple of rounds' worth of held trades before the buffer ever has to grow
+    pending_trades_.reserve(2 * LIQUIDITY_TRADE_BATCH);
+}
+
+void LiquidityFeed::run() {
+    for (;;) {
+        // Read before draining: once both inputs are closed, whatever is left is final
+        bool closed = books_.is_closed() && trades_.is_closed();
+        Clock::time_point now = Clock::now();
+
+        pull_trades(now);
+        bool progressed = false;
+        while (deliver_next(closed, now)) {
+            progressed = true;
+        }
+        if (progressed) {
+            continue;
+        }
+
+        if (closed && !has_pending_trades() && !books_.peek(cursor_) && trades_.empty()) {
+            break;
+        }
+
+        // Nothing deliverable: sleep until the consumer publishes to either input
+        // or the oldest held event runs out of patience
+        uint64_t key = wakeup_.prepare_wait();
+        if (has_new_input() || (!closed && books_.is_closed() && trades_.is_closed())) {
+            wakeup_.cancel_wait();
+            continue;
+        }
+        wakeup_.wait(key, wait_timeout(now));
+    }
+}
+
+void LiquidityFeed::pull_trades(Clock::time_point now) {
+    // Drop the delivered prefix; the vector keeps its capacity
+    pending_trades_.erase(pending_trades_.begin(), pending_trades_.begin() + pending_head_);
+    pending_head_ = 0;
+
+    for (size_t i = 0; i < LIQUIDITY_TRADE_BATCH; ++i) {
+        auto trade = trades_.try_pop();
+        if (!trade.has_value()) {
+            break;
+        }
+        pending_trades_.push_back({trade->message, trade->trace, now});
+    }
+}
+
+// Deliver the oldest event that can no longer be overtaken; false if there is none
+bool LiquidityFeed::deliver_next(bool closed, Clock::time_point now) {
+    const Traced<OrderBookUpdate>* book = books_.peek(cursor_);
+    if (book && book != held_book_) {
+        held_book_ = book;
+        held_book_since_ = now;
+    }
+    const PendingTrade* trade = has_pending_trades() ? &pending_trades_[pending_head_] : nullptr;
+
+    if (book && trade) {
+        if (trade->trade.timestamp_ns <= book->message.timestamp_ns) {
+            deliver_trade(*trade);
+        } else {
+            deliver_book(*book);
+        }
+        return true;
+    }
+
+    // One input is empty: a later arrival on it may still belong in front. Trades
+    // sharing a millisecond go before the update, so the trade stream has to be
+    // strictly past an update to release it.
+    if (book) {
+        if (closed || book->message.timestamp_ns < last_trade_ts_ || now - held_book_since_ >= max_hold_) {
+            deliver_book(*book);
+            return true;
+        }
+        return false;
+    }
+    if (trade) {
+        if (closed || trade->trade.timestamp_ns <= last_book_ts_ || now - trade->seen_at >= max_hold_) {
+            deliver_trade(*trade);
+            return true;
+        }
+        return false;
+    }
+    return false;
+}
+
+void LiquidityFeed::deliver_book(const Traced<OrderBookUpdate>& traced) {
+    const OrderBookUpdate& book = traced.message;
+
+    if (book.timestamp_ns < last_trade_ts_ || book.timestamp_ns < last_book_ts_) {
+        count(late_);
+    }
+
+    bids_.clear();
+    asks_.clear();
+    for (const auto& bid : book.bids)
+        bids_.push_back({bid.price, bid.quantity});
+    for (const auto& ask : book.asks)
+        asks_.push_back({ask.price, ask.quantity});
+    tracker_.onOrderBookUpdate(book.timestamp_ns, bids_, asks_);
+    record_trace(traced.trace, trace_stamp());
+
+    last_book_ts_ = std::max(last_book_ts_, book.timestamp_ns);
+    count(delivered_);
+    books_.advance(cursor_);
+    held_book_ = nullptr;
+}
+
+void LiquidityFeed::deliver_trade(const PendingTrade& pending) {
+    const TradeMessageBinary& trade = pending.trade;
+
+    // A trade stamped the same millisecond as the last update is in order (see above)
+    if (trade.timestamp_ns < last_book_ts_ || trade.timestamp_ns < last_trade_ts_) {
+        count(late_);
+    }
+
+    log_event(LOG_TRADE, LOG_DEBUG, trade.timestamp_ns,
+              "[DEBUG] TradeMessage received. Price: {}, Quantity: {}, IsBuy: {}",
+              trade.price, trade.quantity, trade.is_buy());
+    tracker_.onTrade(trade);
+    record_trace(pending.trace, trace_stamp());
+
+    last_trade_ts_ = std::max(last_trade_ts_, trade.timestamp_ns);
+    count(delivered_);
+    ++pending_head_;
+}
+
+// Something arrived that the last deliver_next() round has not seen
+bool LiquidityFeed::has_new_input() {
+    if (!trades_.empty()) {
+        return true;
+    }
+    const Traced<OrderBookUpdate>* book = books_.peek(cursor_);
+    return book && book != held_book_;
+}
+
+std::chrono::nanoseconds LiquidityFeed::wait_timeout(Clock::time_point now) const {
+    bool holding = false;
+    Clock::time_point oldest = now;
+    if (held_book_) {
+        oldest = held_book_since_;
+        holding = true;
+    }
+    if (has_pending_trades()) {
+        Clock::time_point seen_at = pending_trades_[pending_head_].seen_at;
+        oldest = holding ? std::min(oldest, seen_at) : seen_at;
+        holding = true;
+    }
+    if (!holding) {
+        return LIQUIDITY_IDLE_WAIT;
+    }
+    return std::max(std::chrono::nanoseconds(0), max_hold_ - (now - oldest));
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "core/broadcast_ring.hpp"
+#include "core/event_count.hpp"
+#include "core/handoff_queue.hpp"
+#include "core/latency_trace.hpp"
+#include "core/serialization.hpp"
+#include "features/liquidity_tracker.hpp"
+
+// Most trades moved from the queue into the merge per round
+constexpr size_t LIQUIDITY_TRADE_BATCH = 1024;
+
+// Feeds LiquidityTracker a single stream merged from the order book ring and the
+// trade queue, ordered by exchange timestamp.
+//
+// The thread sleeps on an EventCount that the ring consumer rings after each batch,
+// so it wakes as soon as either input has data and drains both in one go. Each input
+// is already in order (books by last_update_id, trades by trade id), so the merge
+// only picks the older head of the two; on a timestamp tie the trade goes first,
+// since the depth update stamped with the same time already includes its fill.
+// When only one input has data, its head is held until the other input has moved
+// past it or it has waited max_hold, which bounds how long a quiet stream can delay
+// the busy one. Events that arrive behind something already delivered are passed on
+// as they are and counted in late_events().
+class LiquidityFeed {
+public:
+    LiquidityFeed(LiquidityTracker& tracker,
+                  BroadcastRing<Traced<OrderBookUpdate>>& books, size_t cursor,
+                  HandoffQueue<Traced<TradeMessageBinary>>& trades,
+                  EventCount& wakeup,
+                  std::chrono::milliseconds max_hold);
+
+    // Deliver events until both inputs are closed and drained. Each event's trace is
+    // recorded once the tracker is done with it.
+    void run();
+
+    // Readable from any thread while run() is going
+    uint64_t delivered_events() const { return delivered_.load(std::memory_order_relaxed); }
+    uint64_t late_events() const { return late_.load(std::memory_order_relaxed); }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct PendingTrade {
+        TradeMessageBinary trade;
+        TraceStamps trace;
+        Clock::time_point seen_at;
+    };
+
+    void pull_trades(Clock::time_point now);
+    bool deliver_next(bool closed, Clock::time_point now);
+    void deliver_book(const Traced<OrderBookUpdate>& book);
+    void deliver_trade(const PendingTrade& trade);
+    bool has_new_input();
+    bool has_pending_trades() const { return pending_head_ < pending_trades_.size(); }
+    std::chrono::nanoseconds wait_timeout(Clock::time_point now) const;
+
+    LiquidityTracker& tracker_;
+    BroadcastRing<Traced<OrderBookUpdate>>& books_;
+    size_t cursor_;
+    HandoffQueue<Traced<TradeMessageBinary>>& trades_;
+    EventCount& wakeup_;
+    std::chrono::nanoseconds max_hold_;
+
+    // Trades pulled but not delivered, from pending_head_ on. Kept in a vector that is
+    // compacted rather than a deque, whose block churn would allocate in steady state.
+    std::vector<PendingTrade> pending_trades_;
+    size_t pending_head_ = 0;
+    const Traced<OrderBookUpdate>* held_book_ = nullptr;  // Ring head already looked at, not yet delivered
+    Clock::time_point held_book_since_;
+
+    uint64_t last_book_ts_ = 0;   // Timestamp of the last delivered update
+    uint64_t last_trade_ts_ = 0;  // Timestamp of the last delivered trade
+    // Written by run()'s thread only
+    std::atomic<uint64_t> delivered_{0};
+    std::atomic<uint64_t> late_{0};
+
+    std::vector<OrderBookLevel> bids_;  // Reused across updates
+    std::vector<OrderBookLevel> asks_;
+};
@@ -1,24 +1,8 @@
 #include "liquidity_tracker.hpp"
-#include <iostream>
-#include <iomanip>
+#include "core/async_logger.hpp"
+#include <algorithm>
 #include <cmath>
 #include <chrono>
-#include <sstream>
-
-// Helper function to format timestamp
-std::string format_timestamp(uint64_t timestamp_ns) {
-    auto timestamp_ms = timestamp_ns / 1000000;
-    auto time_t_sec = timestamp_ms / 1000;
-    auto ms_part = timestamp_ms % 1000;
-    
-    std::time_t time = static_cast<std::time_t>(time_t_sec);
-    std::tm* tm_utc = std::gmtime(&time);
-    
-    std::stringstream ss;
-    ss << std::put_time(tm_utc, "%Y-%m-%d %H:%M:%S");
-    ss << "." << std::setfill('0') << std::setw(3) << ms_part;
-    return ss.str();
-}
 
 LiquidityTracker::LiquidityTracker(double buy_bucket_size_usd,
                                    double sell_bucket_size_usd,
@@ -32,6 +16,7 @@ LiquidityTracker::LiquidityTracker(double buy_bucket_size_usd,
     , depth_levels_track_(depth_levels_track)
     , depth_levels_report_(depth_levels_report)
     , tick_size_(tick_size)
+    , tick_units_(1)
     , buy_accum_usd_(0.0)
     , sell_accum_usd_(0.0)
     , buy_bucket_buyflow_(0.0)
@@ -47,6 +32,10 @@ LiquidityTracker::LiquidityTracker(double buy_bucket_size_usd,
     , cancel_buy_start_ts_ns_(0)
     , cancel_sell_start_ts_ns_(0)
 {
+    // Room for every node the current and previous maps of both sides can hold,
+    // so recycling never grows the spare list
+    spare_levels_.reserve(4 * depth_levels_track_);
+    updateTickUnits();
 }
 
 LiquidityTracker::~LiquidityTracker() {
@@ -57,28 +46,53 @@ void LiquidityTracker::onOrderBookUpdate(
     const std::vector<OrderBookLevel>& bids,
     const std::vector<OrderBookLevel>& asks) {
     
-    // Store previous state for change detection
-    std::map<double, double> prev_bids = last_bids_volume_;
-    std::map<double, double> prev_asks = last_asks_volume_;
-    
-    // Update current state
-    last_bids_volume_.clear();
-    last_asks_volume_.clear();
+    // The current state becomes the previous one; the nodes of the state before it
+    // are reused for the new levels, so a steady book allocates nothing
+    prev_bids_volume_.swap(last_bids_volume_);
+    prev_asks_volume_.swap(last_asks_volume_);
+    storeLevels(last_bids_volume_, bids);
+    storeLevels(last_asks_volume_, asks);
     
-    // Process bids (buy side)
-    for (size_t i = 0; i < std::min(bids.size(), depth_levels_track_); ++i) {
-        double rounded_price = round_price(bids[i].price);
-        last_bids_volume_[rounded_price] = bids[i].volume;
+    // Detect liquidity changes
+    detectLiquidityChanges(timestamp_ns, prev_bids_volume_, prev_asks_volume_);
+}
+
+// Replace the contents of levels with the tracked depth of book, keyed by tick
+void LiquidityTracker::storeLevels(LevelMap& levels, const std::vector<OrderBookLevel>& book) {
+    while (!levels.empty()) {
+        spare_levels_.push_back(levels.extract(levels.begin()));
     }
     
-    // Process asks (sell side)
-    for (size_t i = 0; i < std::min(asks.size(), depth_levels_track_); ++i) {
-        double rounded_price = round_price(asks[i].price);
-        last_asks_volume_[rounded_price] = asks[i].volume;
+    for (size_t i = 0; i < std::min(book.size(), depth_levels_track_); ++i) {
+        int64_t tick;
+        int64_t lots;
+        if (!price_tick(book[i].price, tick) ||
+            !to_fixed_point(book[i].volume, precision_.quantity_decimals, lots)) {
+            // Out of fixed-point range at this precision
+            if (skipped_levels_++ == 0) {
+                log_event(LOG_ORDER_FLOW, LOG_WARN, 0,
+                          "[Liquidity] {} level {} x {} is out of range at {}:{} decimals and skipped, as are any "
+                          "later ones; give it a coarser BINANCE_PRECISION",
+                          symbol_, book[i].price, book[i].volume, unsigned(precision_.price_decimals),
+                          unsigned(precision_.quantity_decimals));
+            }
+            continue;
+        }
+        if (spare_levels_.empty()) {
+            levels[tick] = lots;
+            continue;
+        }
+        LevelMap::node_type node = std::move(spare_levels_.back());
+        spare_levels_.pop_back();
+        node.key() = tick;
+        node.mapped() = lots;
+        auto result = levels.insert(std::move(node));
+        if (!result.inserted) {
+            // Two prices rounded onto one tick: the later level wins, as with operator[]
+            result.position->second = lots;
+            spare_levels_.push_back(std::move(result.node));
+        }
     }
-    
-    // Detect liquidity changes
-    detectLiquidityChanges(timestamp_ns, prev_bids, prev_asks);
 }
 
 void LiquidityTracker::onTrade(const TradeMessageBinary& trade) {
@@ -159,6 +173,26 @@ void LiquidityTracker::setLiquidityChangeCallback(LiquidityChangeCallback cb) {
 
 void LiquidityTracker::setTickSize(double tick_size) {
     tick_size_ = tick_size;
+    updateTickUnits();
+}
+
+void LiquidityTracker::setPrecision(const SymbolPrecision& precision) {
+    precision_ = precision;
+    updateTickUnits();
+}
+
+void LiquidityTracker::setSymbol(const std::string& symbol) {
+    symbol_ = symbol;
+}
+
+// A tick finer than the price precision, out of range, or none at all, keys levels by
+// price unit
+void LiquidityTracker::updateTickUnits() {
+    int64_t units = 0;
+    if (tick_size_ > 0.0) {
+        to_fixed_point(tick_size_, precision_.price_decimals, units);  // Leaves 0 when out of range
+    }
+    tick_units_ = std::max<int64_t>(1, units);
 }
 
 void LiquidityTracker::reset() {
@@ -180,32 +214,45 @@ void LiquidityTracker::reset() {
     
     last_bids_volume_.clear();
     last_asks_volume_.clear();
+    prev_bids_volume_.clear();
+    prev_asks_volume_.clear();
 }
 
 void LiquidityTracker::processCancelVolume(bool is_buy, double cancel_volume, uint64_t ts_ns) {
     processCancelVolumeInternal(is_buy, cancel_volume, ts_ns);
 }
 
-double LiquidityTracker::round_price(double price) const {
-    if (tick_size_ <= 0.0) return price;
-    return std::round(price / tick_size_) * tick_size_;
+bool LiquidityTracker::price_tick(double price, int64_t& tick) const {
+    int64_t units;
+    if (!to_fixed_point(price, precision_.price_decimals, units)) {
+        return false;
+    }
+    tick = nearest_step(units, tick_units_);
+    return true;
+}
+
+// Ticks only come from price_tick, so the product stays within MAX_FIXED_UNITS + tick_units_
+double LiquidityTracker::tick_price(int64_t tick) const {
+    return fixed_to_double(tick * tick_units_, precision_.price_decimals);
 }
 
 void LiquidityTracker::detectLiquidityChanges(
     uint64_t timestamp_ns,
-    const std::map<double, double>& prev_bids,
-    const std::map<double, double>& prev_asks) {
+    const LevelMap& prev_bids,
+    const LevelMap& prev_asks) {
     
     // Detect changes in bids
-    for (const auto& [price, volume] : last_bids_volume_) {
-        auto prev_it = prev_bids.find(price);
-        double prev_volume = (prev_it != prev_bids.end()) ? prev_it->second : 0.0;
+    for (const auto& [tick, lots] : last_bids_volume_) {
+        auto prev_it = prev_bids.find(tick);
+        int64_t prev_lots = (prev_it != prev_bids.end()) ? prev_it->second : 0;
         
-        if (std::abs(volume - prev_volume) > 1e-8) {
-            double volume_delta = volume - prev_volume;
+        if (lots != prev_lots) {
+            int64_t lots_delta = lots - prev_lots;
+            double price = tick_price(tick);
+            double volume_delta = fixed_to_double(lots_delta, precision_.quantity_decimals);
             
-            // If volume decreased significantly, it might be a cancel
-            if (volume_delta < -prev_volume * 0.5 && prev_volume > 0) {
+            // If volume dropped by more than half, it might be a cancel
+            if (2 * lots_delta < -prev_lots && prev_lots > 0) {
                 processCancelVolumeInternal(true, std::abs(volume_delta) * price, timestamp_ns);
             }
             
@@ -217,15 +264,17 @@ void LiquidityTracker::detectLiquidityChanges(
     }
     
     // Detect changes in asks
-    for (const auto& [price, volume] : last_asks_volume_) {
-        auto prev_it = prev_asks.find(price);
-        double prev_volume = (prev_it != prev_asks.end()) ? prev_it->second : 0.0;
+    for (const auto& [tick, lots] : last_asks_volume_) {
+        auto prev_it = prev_asks.find(tick);
+        int64_t prev_lots = (prev_it != prev_asks.end()) ? prev_it->second : 0;
         
-        if (std::abs(volume - prev_volume) > 1e-8) {
-            double volume_delta = volume - prev_volume;
+        if (lots != prev_lots) {
+            int64_t lots_delta = lots - prev_lots;
+            double price = tick_price(tick);
+            double volume_delta = fixed_to_double(lots_delta, precision_.quantity_decimals);
             
-            // If volume decreased significantly, it might be a cancel
-            if (volume_delta < -prev_volume * 0.5 && prev_volume > 0) {
+            // If volume dropped by more than half, it might be a cancel
+            if (2 * lots_delta < -prev_lots && prev_lots > 0) {
                 processCancelVolumeInternal(false, std::abs(volume_delta) * price, timestamp_ns);
             }
             
@@ -8,6 +8,8 @@
 #include <functional>
 #include <mutex>
 #include <atomic>
+#include <string>
+#include "core/fixed_point.hpp"
 #include "core/serialization.hpp"
 
 struct OrderBookLevel {
@@ -52,13 +54,27 @@ public:
 
     void setTickSize(double tick_size);
 
+    // Decimals prices and volumes are held at; levels are keyed by whole ticks at the
+    // price precision, volumes compared as whole lots. Defaults to SymbolPrecision{}.
+    void setPrecision(const SymbolPrecision& precision);
+
+    // Symbol named in warnings
+    void setSymbol(const std::string& symbol);
+
+    // Levels dropped as out of fixed-point range at the precision
+    uint64_t skippedLevels() const { return skipped_levels_; }
+
     void reset();
 
     // For testing: direct cancel volume simulation
     void processCancelVolume(bool is_buy, double cancel_volume, uint64_t ts_ns);
 
 private:
-    double round_price(double price) const;
+    // Index of the tick nearest to price, false if the price is out of fixed-point
+    // range; and the price of a tick index
+    bool price_tick(double price, int64_t& tick) const;
+    double tick_price(int64_t tick) const;
+    void updateTickUnits();
 
     // Config
     double buy_bucket_size_;
@@ -67,10 +83,18 @@ private:
     size_t depth_levels_track_;
     size_t depth_levels_report_;
     double tick_size_;
-
-    // State
-    std::map<double, double> last_bids_volume_;
-    std::map<double, double> last_asks_volume_;
+    SymbolPrecision precision_;
+    int64_t tick_units_;  // tick_size_ in price units, at least 1
+    std::string symbol_;
+    uint64_t skipped_levels_ = 0;
+
+    // State: tick index -> volume in lots
+    using LevelMap = std::map<int64_t, int64_t>;
+    LevelMap last_bids_volume_;
+    LevelMap last_asks_volume_;
+    LevelMap prev_bids_volume_;  // Previous update, kept for change detection
+    LevelMap prev_asks_volume_;
+    std::vector<LevelMap::node_type> spare_levels_;  // Map nodes recycled between updates
 
     // Buy/Sell bucket tracking
     double buy_accum_usd_;
@@ -99,8 +123,10 @@ private:
 
     void detectLiquidityChanges(
         uint64_t timestamp_ns,
-        const std::map<double, double>& prev_bids,
-        const std::map<double, double>& prev_asks);
+        const LevelMap& prev_bids,
+        const LevelMap& prev_asks);
+
+    void storeLevels(LevelMap& levels, const std::vector<OrderBookLevel>& book);
 
     void processCancelVolumeInternal(bool is_buy, double cancel_volume, uint64_t timestamp_ns);
 };
@@ -1,24 +1,7 @@
 #include "liquidity_tracker.hpp"
-#include <iostream>
-#include <iomanip>
+#include "core/async_logger.hpp"
 #include <cmath>
 #include <chrono>
-#include <sstream>
-
-// Helper function to format timestamp
-std::string format_timestamp(uint64_t timestamp_ns) {
-    auto timestamp_ms = timestamp_ns / 1000000;
-    auto time_t_sec = timestamp_ms / 1000;
-    auto ms_part = timestamp_ms % 1000;
-    
-    std::time_t time = static_cast<std::time_t>(time_t_sec);
-    std::tm* tm_utc = std::gmtime(&time);
-    
-    std::stringstream ss;
-    ss << std::put_time(tm_utc, "%Y-%m-%d %H:%M:%S");
-    ss << "." << std::setfill('0') << std::setw(3) << ms_part;
-    return ss.str();
-}
 
 LiquidityTracker::LiquidityTracker(double buy_bucket_size_usd,
                                    double sell_bucket_size_usd,
@@ -94,10 +77,8 @@ void LiquidityTracker::onTrade(const TradeMessageBinary& trade) {
     double trade_value_usd = trade.price * trade.quantity;
     bool is_buy = trade.is_buy();
     
-    std::cout << "[" << format_timestamp(trade.timestamp_ns) << "] "
-              << "[TRADE EXECUTION] " << (is_buy ? "BUY" : "SELL") << " $" 
-              << std::fixed << std::setprecision(2) << trade_value_usd 
-              << " at $" << std::setprecision(2) << trade.price << std::endl;
+    log_event(LOG_TRADE, LOG_INFO, trade.timestamp_ns, "[TRADE EXECUTION] {} ${.2} at ${.2}",
+              is_buy ? "BUY" : "SELL", trade_value_usd, trade.price);
     
     // MODE 2: Track actual trade execution buckets
     if (is_buy) {
@@ -246,23 +227,20 @@ void LiquidityTracker::detectLiquidityChanges(
             if (volume_delta > 0) {
                 // Order addition
                 total_bid_additions += value_delta;
-                std::cout << "[" << format_timestamp(timestamp_ns) << "] "
-                          << "[ORDER FLOW] BID ADD $" << std::fixed << std::setprecision(2) << value_delta
-                          << " at $" << std::setprecision(2) << price << std::endl;
+                log_event(LOG_ORDER_FLOW, LOG_INFO, timestamp_ns, "[ORDER FLOW] BID ADD ${.2} at ${.2}",
+                          value_delta, price);
             } else {
                 // Order removal/cancellation
                 total_bid_removals += std::abs(value_delta);
                 
                 // Large removals might be cancellations
                 if (volume_delta < -prev_volume * 0.3 && prev_volume > 0) {
-                    std::cout << "[" << format_timestamp(timestamp_ns) << "] "
-                              << "[CANCEL DETECTED] BID at $" << std::fixed << std::setprecision(2) << price
-                              << ", cancelled: $" << std::setprecision(2) << std::abs(value_delta) << std::endl;
+                    log_event(LOG_ORDER_FLOW, LOG_INFO, timestamp_ns, "[CANCEL DETECTED] BID at ${.2}, cancelled: ${.2}",
+                              price, std::abs(value_delta));
                     processCancelVolumeInternal(true, std::abs(value_delta), timestamp_ns);
                 } else {
-                    std::cout << "[" << format_timestamp(timestamp_ns) << "] "
-                              << "[ORDER FLOW] BID REMOVE $" << std::fixed << std::setprecision(2) << std::abs(value_delta)
-                              << " at $" << std::setprecision(2) << price << std::endl;
+                    log_event(LOG_ORDER_FLOW, LOG_INFO, timestamp_ns, "[ORDER FLOW] BID REMOVE ${.2} at ${.2}",
+                              std::abs(value_delta), price);
                 }
             }
             
@@ -286,23 +264,20 @@ void LiquidityTracker::detectLiquidityChanges(
             if (volume_delta > 0) {
                 // Order addition
                 total_ask_additions += value_delta;
-                std::cout << "[" << format_timestamp(timestamp_ns) << "] "
-                          << "[ORDER FLOW] ASK ADD $" << std::fixed << std::setprecision(2) << value_delta
-                          << " at $" << std::setprecision(2) << price << std::endl;
+                log_event(LOG_ORDER_FLOW, LOG_INFO, timestamp_ns, "[ORDER FLOW] ASK ADD ${.2} at ${.2}",
+                          value_delta, price);
             } else {
                 // Order removal/cancellation
                 total_ask_removals += std::abs(value_delta);
                 
                 // Large removals might be cancellations
                 if (volume_delta < -prev_volume * 0.3 && prev_volume > 0) {
-                    std::cout << "[" << format_timestamp(timestamp_ns) << "] "
-                              << "[CANCEL DETECTED] ASK at $" << std::fixed << std::setprecision(2) << price
-                              << ", cancelled: $" << std::setprecision(2) << std::abs(value_delta) << std::endl;
+                    log_event(LOG_ORDER_FLOW, LOG_INFO, timestamp_ns, "[CANCEL DETECTED] ASK at ${.2}, cancelled: ${.2}",
+                              price, std::abs(value_delta));
                     processCancelVolumeInternal(false, std::abs(value_delta), timestamp_ns);
                 } else {
-                    std::cout << "[" << format_timestamp(timestamp_ns) << "] "
-                              << "[ORDER FLOW] ASK REMOVE $" << std::fixed << std::setprecision(2) << std::abs(value_delta)
-                              << " at $" << std::setprecision(2) << price << std::endl;
+                    log_event(LOG_ORDER_FLOW, LOG_INFO, timestamp_ns, "[ORDER FLOW] ASK REMOVE ${.2} at ${.2}",
+                              std::abs(value_delta), price);
                 }
             }
             
@@ -1,24 +1,7 @@
 #include "liquidity_tracker.hpp"
-#include <iostream>
-#include <iomanip>
+#include "core/async_logger.hpp"
 #include <cmath>
 #include <chrono>
-#include <sstream>
-
-// Helper function to format timestamp
-std::string format_timestamp(uint64_t timestamp_ns) {
-    auto timestamp_ms = timestamp_ns / 1000000;
-    auto time_t_sec = timestamp_ms / 1000;
-    auto ms_part = timestamp_ms % 1000;
-    
-    std::time_t time = static_cast<std::time_t>(time_t_sec);
-    std::tm* tm_utc = std::gmtime(&time);
-    
-    std::stringstream ss;
-    ss << std::put_time(tm_utc, "%Y-%m-%d %H:%M:%S");
-    ss << "." << std::setfill('0') << std::setw(3) << ms_part;
-    return ss.str();
-}
 
 LiquidityTracker::LiquidityTracker(double buy_bucket_size_usd,
                                    double sell_bucket_size_usd,
@@ -88,9 +71,8 @@ void LiquidityTracker::onTrade(const TradeMessageBinary& trade) {
     double trade_value_usd = trade.price * trade.quantity;
     bool is_buy = trade.is_buy();
     
-    std::cout << "[" << format_timestamp(trade.timestamp_ns) << "] "
-              << "[TRADE FLOW] " << (is_buy ? "BUY" : "SELL") << " $" 
-              << std::fixed << std::setprecision(2) << trade_value_usd << std::endl;
+    log_event(LOG_TRADE, LOG_INFO, trade.timestamp_ns, "[TRADE FLOW] {} ${.2}",
+              is_buy ? "BUY" : "SELL", trade_value_usd);
     
     // Accumulate based on trade direction (actual liquidity consumption)
     if (is_buy) {
@@ -214,10 +196,8 @@ void LiquidityTracker::detectLiquidityChanges(
             
             // If volume decreased significantly, it might be a cancel
             if (volume_delta < -prev_volume * 0.5 && prev_volume > 0) {
-                std::cout << "[" << format_timestamp(timestamp_ns) << "] "
-                          << "[CANCEL DETECTED] BID at $" << std::fixed << std::setprecision(2) << price
-                          << ", cancelled: " << std::setprecision(4) << std::abs(volume_delta)
-                          << " ($" << std::setprecision(2) << (std::abs(volume_delta) * price) << ")" << std::endl;
+                log_event(LOG_ORDER_FLOW, LOG_INFO, timestamp_ns, "[CANCEL DETECTED] BID at ${.2}, cancelled: {.4} (${.2})",
+                          price, std::abs(volume_delta), std::abs(volume_delta) * price);
                 processCancelVolumeInternal(true, std::abs(volume_delta) * price, timestamp_ns);
             }
             
@@ -239,10 +219,8 @@ void LiquidityTracker::detectLiquidityChanges(
             
             // If volume decreased significantly, it might be a cancel
             if (volume_delta < -prev_volume * 0.5 && prev_volume > 0) {
-                std::cout << "[" << format_timestamp(timestamp_ns) << "] "
-                          << "[CANCEL DETECTED] ASK at $" << std::fixed << std::setprecision(2) << price
-                          << ", cancelled: " << std::setprecision(4) << std::abs(volume_delta)
-                          << " ($" << std::setprecision(2) << (std::abs(volume_delta) * price) << ")" << std::endl;
+                log_event(LOG_ORDER_FLOW, LOG_INFO, timestamp_ns, "[CANCEL DETECTED] ASK at ${.2}, cancelled: {.4} (${.2})",
+                          price, std::abs(volume_delta), std::abs(volume_delta) * price);
                 processCancelVolumeInternal(false, std::abs(volume_delta) * price, timestamp_ns);
             }
             
@@ -1,127 +1,262 @@
 #include <iostream>
 #include <thread>
 #include <atomic>
-#include <iomanip>
 #include <csignal>
+#include <memory>
+#include <algorithm>
+#include <string>
+#include <vector>
 #include "io/binance_connector.hpp"
 #include "io/mmap_buffer.hpp"
 #include "io/ring_buffer_consumer.hpp"
+#include "io/exchange_info.hpp"
 #include "features/IcebergDetector.hpp"
 #include "features/liquidity_tracker.hpp"
-#include "core/ts_queue.hpp"
+#include "features/liquidity_feed.hpp"
+#include "features/inline_pipeline.hpp"
+#include "features/symbol_worker_pool.hpp"
+#include "features/coroutine_pipeline.hpp"
+#include "core/handoff_queue.hpp"
+#include "core/broadcast_ring.hpp"
+#include "core/event_count.hpp"
+#include "core/pipeline_config.hpp"
+#include "core/thread_placement.hpp"
+#include "core/symbol_table.hpp"
+#include "core/latency_trace.hpp"
+#include "core/async_logger.hpp"
 
 extern std::atomic<bool> stop_flag;
-extern TSQueue<OrderBookUpdate> iceberg_queue;
+extern BroadcastRing<Traced<OrderBookUpdate>> orderbook_ring;
+extern EventCount feed_event;
 
-// New queues for liquidity tracking
-TSQueue<OrderBookUpdate> liquidity_queue;
-TSQueue<TradeMessageBinary> trade_queue;
+// Trades handed from the ring consumer to the liquidity tracker
+HandoffQueue<Traced<TradeMessageBinary>> trade_queue;
 
 int main() {
-    BinanceConnector connector;
-    IcebergDetector iceberg_detector;
-
-    // Initialize the liquidity tracker
-    LiquidityTracker liquidity_tracker(
-        10000.0, // buy bucket size
-        10000.0, // sell bucket size
-        5000.0,  // cancel bucket size
-        30,      // depth_levels_track
-        20,      // depth_levels_report
-        0.01     // tick_size (price resolution)
-    );
-    liquidity_tracker.setTickSize(0.01); // Adjust tick size as needed
-
-    // Print bucket-level statistics
-    liquidity_tracker.setBuyBucketCallback([](bool is_buy, uint64_t duration_ns, double bucket_size, double ratio) {
-        std::cout << (is_buy ? "[BUY BUCKET]" : "[SELL BUCKET]") << " $" << bucket_size
-                  << " filled in " << (duration_ns / 1e6) << " ms, "
-                  << "Buy/Sell ratio: " << std::setprecision(3) << ratio << std::endl;
-    });
+    PipelineConfig config = load_pipeline_config();
 
-    liquidity_tracker.setSellBucketCallback([](bool is_buy, uint64_t duration_ns, double bucket_size, double ratio) {
-        std::cout << (is_buy ? "[BUY BUCKET]" : "[SELL BUCKET]") << " $" << bucket_size
-                  << " filled in " << (duration_ns / 1e6) << " ms, "
-                  << "Sell/Buy ratio: " << std::setprecision(3) << ratio << std::endl;
-    });
+    // The feed ring is mirrored so frames can always be parsed in place
+    RingOptions ring_options;
+    ring_options.mirrored = true;
+    ring_options.overflow = config.ring_overflow;
+    ring_options.block_timeout = std::chrono::milliseconds(config.ring_block_ms);
+    ring_options.spill_path = config.ring_spill_path;
+    ring_options.huge_pages = config.ring_huge_pages;
+    ring_options.lock_memory = config.ring_lock_memory;
+    ring_options.prefault = config.ring_prefault;
+    ring_options.numa_node = config.ring_numa_node;
+    ring_options.journal_dir = config.journal_dir;
+    ring_options.journal_file_size = config.journal_file_size;
+    ring_options.journal_flush_interval = std::chrono::milliseconds(config.journal_flush_ms);
+    // Threaded and inline modes run one set of detectors, so they track one symbol
+    std::vector<std::string> symbols = config.symbols;
+    bool per_symbol = config.run_mode == RUN_SHARDED || config.run_mode == RUN_COROUTINE;
+    if (!per_symbol && symbols.size() > 1) {
+        std::cerr << "[Config] BINANCE_SYMBOLS lists " << symbols.size()
+                  << " symbols; only sharded and coroutine modes track more than one, using "
+                  << symbols[0] << std::endl;
+        symbols.resize(1);
+    }
+    // Symbols without a BINANCE_PRECISION entry take their exchange tick and step sizes
+    fill_symbol_precision(symbols, config.symbol_precision);
 
-    liquidity_tracker.setCancelBuyBucketCallback([](bool is_buy, uint64_t duration_ns, double bucket_size, double ratio) {
-        std::cout << (is_buy ? "[CANCEL BUY BUCKET]" : "[CANCEL SELL BUCKET]") << " $" << bucket_size
-                  << " cancelled in " << (duration_ns / 1e6) << " ms, "
-                  << "Cancel ratio: " << std::setprecision(3) << ratio << std::endl;
-    });
+    // Liquidity tracker for one symbol, printing bucket-level statistics
+    auto make_liquidity_tracker = [&config](const std::string& symbol) {
+        auto tracker = std::make_unique<LiquidityTracker>(
+            10000.0, // buy bucket size
+            10000.0, // sell bucket size
+            5000.0,  // cancel bucket size
+            30,      // depth_levels_track
+            20,      // depth_levels_report
+            0.01     // tick_size (price resolution)
+        );
+        tracker->setTickSize(0.01); // Adjust tick size as needed
+        tracker->setPrecision(precision_for(config.symbol_precision, symbol));
+        tracker->setSymbol(symbol);
 
-    liquidity_tracker.setCancelSellBucketCallback([](bool is_buy, uint64_t duration_ns, double bucket_size, double ratio) {
-        std::cout << (is_buy ? "[CANCEL BUY BUCKET]" : "[CANCEL SELL BUCKET]") << " $" << bucket_size
-                  << " cancelled in " << (duration_ns / 1e6) << " ms, "
-                  << "Cancel ratio: " << std::setprecision(3) << ratio << std::endl;
-    });
+        tracker->setBuyBucketCallback([symbol](bool is_buy, uint64_t duration_ns, double bucket_size, double ratio) {
+            log_event(LOG_BUCKET, LOG_INFO, 0, "[{}] {} ${.2} filled in {} ms, Buy/Sell ratio: {.3}",
+                      symbol, is_buy ? "[BUY BUCKET]" : "[SELL BUCKET]", bucket_size, duration_ns / 1e6, ratio);
+        });
 
-    std::thread ws_thread([&connector]() {
-        connector.start();
-    });
+        tracker->setSellBucketCallback([symbol](bool is_buy, uint64_t duration_ns, double bucket_size, double ratio) {
+            log_event(LOG_BUCKET, LOG_INFO, 0, "[{}] {} ${.2} filled in {} ms, Sell/Buy ratio: {.3}",
+                      symbol, is_buy ? "[BUY BUCKET]" : "[SELL BUCKET]", bucket_size, duration_ns / 1e6, ratio);
+        });
 
-    std::thread consumer_thread(consume_ring_buffer);
+        tracker->setCancelBuyBucketCallback([symbol](bool is_buy, uint64_t duration_ns, double bucket_size, double ratio) {
+            log_event(LOG_BUCKET, LOG_INFO, 0, "[{}] {} ${.2} cancelled in {} ms, Cancel ratio: {.3}",
+                      symbol, is_buy ? "[CANCEL BUY BUCKET]" : "[CANCEL SELL BUCKET]", bucket_size,
+                      duration_ns / 1e6, ratio);
+        });
 
-    std::thread iceberg_thread([&]() {
-        while (true) {
-            auto update_opt = iceberg_queue.pop();
-            if (!update_opt.has_value())
-                break;
-            iceberg_detector.process_update(update_opt.value());
-        }
+        tracker->setCancelSellBucketCallback([symbol](bool is_buy, uint64_t duration_ns, double bucket_size, double ratio) {
+            log_event(LOG_BUCKET, LOG_INFO, 0, "[{}] {} ${.2} cancelled in {} ms, Cancel ratio: {.3}",
+                      symbol, is_buy ? "[CANCEL BUY BUCKET]" : "[CANCEL SELL BUCKET]", bucket_size,
+                      duration_ns / 1e6, ratio);
+        });
+        return tracker;
+    };
+
+    SymbolTable symbol_table(symbols);
+    IcebergDetector iceberg_detector(symbol_table.name(0), precision_for(config.symbol_precision, symbol_table.name(0)));
+    std::unique_ptr<LiquidityTracker> liquidity_tracker = make_liquidity_tracker(symbol_table.name(0));
+
+    // Sharded and coroutine modes give every symbol its own detectors, run on a pool
+    // of workers or as coroutines on a few executor threads
+    size_t workers = config.worker_threads;
+    if (workers == 0) {
+        workers = std::max<size_t>(1, std::min<size_t>(std::thread::hardware_concurrency(), symbols.size()));
+    }
+    std::unique_ptr<SymbolWorkerPool> worker_pool;
+    if (config.run_mode == RUN_SHARDED) {
+        worker_pool = std::make_unique<SymbolWorkerPool>(symbols, workers, make_liquidity_tracker,
+                                                         config.symbol_precision, config.worker_thread);
+    }
+#if BINANCE_COROUTINES
+    std::unique_ptr<CoroutinePipeline> coroutine_pipeline;
+    if (config.run_mode == RUN_COROUTINE) {
+        coroutine_pipeline = std::make_unique<CoroutinePipeline>(symbols, workers, make_liquidity_tracker,
+                                                                 config.symbol_precision, config.worker_thread);
+    }
+#endif
+
+    // Inline mode runs both detectors inside the network callback; the other modes
+    // publish to the feed ring and fan out from the consumer thread
+    InlinePipeline inline_pipeline(iceberg_detector, *liquidity_tracker);
+    std::unique_ptr<BinanceConnector> connector;
+    if (config.run_mode == RUN_INLINE) {
+        connector = std::make_unique<BinanceConnector>(inline_pipeline, symbols);
+    } else {
+        connector = std::make_unique<BinanceConnector>(config.ring_capacity, ring_options, symbols);
+    }
+
+    // Log output is formatted off the pipeline threads from the first message on
+    set_log_levels(config.log_levels);
+    set_log_rate_limit(static_cast<uint32_t>(config.log_rate));
+    if (config.async_log) {
+        start_async_logger();
+    }
+
+    // Stamps are taken from the first message on, so switch tracing on before any thread starts
+    std::unique_ptr<LatencyReporter> latency_reporter;
+    if (config.trace_latency) {
+        latency_tracing.store(true, std::memory_order_relaxed);
+        latency_reporter = std::make_unique<LatencyReporter>(std::chrono::milliseconds(config.trace_report_ms));
+        latency_reporter->start();
+        std::cout << "[Latency] Tracing on; send SIGUSR1 to print the histograms" << std::endl;
+    }
+
+    // Every pipeline thread places itself first and logs where it landed
+    std::thread ws_thread([&]() {
+        apply_thread_placement(config.ws_thread);
+        connector->start();
     });
 
-    // Add liquidity tracker thread
-    std::thread liquidity_thread([&]() {
-        while (true) {
-            // Process order book updates
-            auto update_opt = liquidity_queue.try_pop();
-            if (update_opt.has_value()) {
-                OrderBookUpdate& update = update_opt.value();
-                std::vector<OrderBookLevel> bids, asks;
-                for (const auto& bid : update.bids)
-                    bids.push_back({bid.price, bid.quantity});
-                for (const auto& ask : update.asks)
-                    asks.push_back({ask.price, ask.quantity});
-                liquidity_tracker.onOrderBookUpdate(update.timestamp_ns, bids, asks);
-            }
-            // Process trades
-            auto trade_opt = trade_queue.try_pop();
-            if (trade_opt.has_value()) {
-                TradeMessageBinary& trade = trade_opt.value();
-                std::cout << "[DEBUG] TradeMessage received. Price: " << trade.price
-                          << ", Quantity: " << trade.quantity << ", IsBuy: " << trade.is_buy() << std::endl;
-                liquidity_tracker.onTrade(trade);
-            }
-            // Exit condition
-            if (liquidity_queue.is_closed() && liquidity_queue.empty() &&
-                trade_queue.is_closed() && trade_queue.empty() &&
-                stop_flag.load(std::memory_order_acquire)) {
-                break;
+    std::thread consumer_thread;
+    std::thread iceberg_thread;
+    std::thread liquidity_thread;
+    std::unique_ptr<LiquidityFeed> liquidity_feed;
+    if (config.run_mode == RUN_THREADED) {
+        // Each detector reads order book updates through its own cursor on the shared ring.
+        // Subscribe before any thread starts so neither misses the first updates.
+        size_t iceberg_cursor = orderbook_ring.subscribe();
+        size_t liquidity_cursor = orderbook_ring.subscribe();
+
+        consumer_thread = std::thread([&]() {
+            apply_thread_placement(config.consumer_thread);
+            consume_ring_buffer(config.wait_strategy, ring_options);
+        });
+
+        iceberg_thread = std::thread([&, iceberg_cursor]() {
+            apply_thread_placement(config.iceberg_thread);
+            while (true) {
+                const Traced<OrderBookUpdate>* update = orderbook_ring.wait(iceberg_cursor);
+                if (!update)
+                    break;
+                iceberg_detector.process_update(update->message);
+                orderbook_ring.advance(iceberg_cursor);
             }
-            std::this_thread::sleep_for(std::chrono::milliseconds(1));
-        }
-        std::cout << "[Liquidity Tracker] Thread stopped" << std::endl;
-    });
+        });
+
+        // Add liquidity tracker thread: trades and book updates merged in timestamp order
+        liquidity_feed = std::make_unique<LiquidityFeed>(
+            *liquidity_tracker, orderbook_ring, liquidity_cursor, trade_queue,
+            feed_event, std::chrono::milliseconds(config.merge_hold_ms));
+        liquidity_thread = std::thread([&]() {
+            apply_thread_placement(config.liquidity_thread);
+            liquidity_feed->run();
+            std::cout << "[Liquidity Tracker] Thread stopped after " << liquidity_feed->delivered_events()
+                      << " events (" << liquidity_feed->late_events() << " out of order)" << std::endl;
+        });
+    } else if (config.run_mode == RUN_SHARDED) {
+        worker_pool->start();
+        consumer_thread = std::thread([&]() {
+            apply_thread_placement(config.consumer_thread);
+            consume_ring_buffer(config.wait_strategy, ring_options, worker_pool.get());
+        });
+    }
+#if BINANCE_COROUTINES
+    else if (config.run_mode == RUN_COROUTINE) {
+        coroutine_pipeline->start();
+        consumer_thread = std::thread([&]() {
+            apply_thread_placement(config.consumer_thread);
+            consume_ring_buffer(config.wait_strategy, ring_options, coroutine_pipeline.get());
+        });
+    }
+#endif
 
     std::cout << "Binance Processor started. Press Enter to stop...\n";
     std::cin.get();
 
     std::cout << "Stopping Binance Processor...\n";
 
-    connector.stop();
+    connector->stop();
     if (ws_thread.joinable()) ws_thread.join();
     stop_flag.store(true, std::memory_order_release);
     if (consumer_thread.joinable()) consumer_thread.join();
 
-    iceberg_queue.close();
-    liquidity_queue.close();
+    orderbook_ring.close();
     trade_queue.close();
+    feed_event.notify();
 
     if (iceberg_thread.joinable()) iceberg_thread.join();
     if (liquidity_thread.joinable()) liquidity_thread.join();
 
+    if (worker_pool) {
+        worker_pool->stop();
+        std::vector<SymbolWorkerPool::WorkerStats> stats = worker_pool->worker_stats();
+        for (size_t i = 0; i < stats.size(); ++i) {
+            std::cout << "[Workers] Worker " << i << ": " << stats[i].messages << " messages, "
+                      << stats[i].steals << " symbols stolen\n";
+        }
+    }
+
+#if BINANCE_COROUTINES
+    if (coroutine_pipeline) {
+        coroutine_pipeline->stop();
+        std::cout << "[Coroutines] " << coroutine_pipeline->stage_count() << " stages on "
+                  << coroutine_pipeline->thread_count() << " executor threads, resumed "
+                  << coroutine_pipeline->resumes() << " times\n";
+    }
+#endif
+
+    // Every logging thread has stopped; write out what they left queued
+    stop_async_logger();
+
+    if (latency_reporter) {
+        latency_reporter->stop();
+        print_latency_report(std::cout);
+    }
+
+    if (config.run_mode != RUN_INLINE) {
+        RingStats ring_stats = connector->ring_stats();
+        std::cout << "Feed ring: high water " << ring_stats.high_water
+                  << " bytes, dropped " << ring_stats.dropped_frames << " frames ("
+                  << ring_stats.dropped_bytes << " bytes), spilled " << ring_stats.spilled_frames
+                  << " frames (" << ring_stats.spilled_bytes << " bytes)\n";
+    }
+
     std::cout << "Binance Processor stopped.\n";
     return 0;
 }
\ No newline at end of file
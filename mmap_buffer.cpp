@@ -1,21 +1,355 @@
 #include "io/mmap_buffer.hpp"
+#include "io/journal.hpp"
 #include <algorithm> // std::min
 #include <cstring>   // memcpy
+#include <cerrno>
+#include <new>       // placement new
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <climits>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <linux/mempolicy.h>
+#include <cstddef>   // offsetof
+#include <fstream>
+#include <limits>
+#include <thread>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace {
+
+constexpr uint32_t RING_MAGIC = 0x424e5247; // "BNRG"
+
+// The header occupies its own page so the data area starts page-aligned
+// (a whole huge page on hugetlbfs, see RingHeader::data_offset)
+constexpr size_t HEADER_PAGE_SIZE = 4096;
+static_assert(sizeof(RingHeader) <= HEADER_PAGE_SIZE, "RingHeader must fit in the header page");
+
+// Frame type written by the producer to skip the unusable tail end of the buffer on wrap
+constexpr uint8_t FRAME_PAD = 0x00;
+
+// Empty-ring polls before a spinning strategy yields or parks
+constexpr int WAIT_SPIN_ITERATIONS = 4096;
+
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#endif
+}
+
+// Shared (not FUTEX_PRIVATE) operations so producer and consumer may live in different processes
+void futex_wait(std::atomic<uint32_t>& word, uint32_t expected, std::chrono::nanoseconds timeout) {
+    struct timespec ts;
+    ts.tv_sec = static_cast<time_t>(timeout.count() / 1000000000);
+    ts.tv_nsec = static_cast<long>(timeout.count() % 1000000000);
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT, expected, &ts, nullptr, 0);
+}
+
+void futex_wake(std::atomic<uint32_t>& word) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+std::runtime_error sys_error(const std::string& what) {
+    return std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+// Default huge page size from /proc/meminfo, which is what hugetlbfs and MFD_HUGETLB use
+size_t huge_page_size() {
+    std::ifstream meminfo("/proc/meminfo");
+    std::string key;
+    size_t kb = 0;
+    while (meminfo >> key) {
+        if (key == "Hugepagesize:" && meminfo >> kb) {
+            return kb * 1024;
+        }
+        meminfo.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    }
+    return 2 * 1024 * 1024;
+}
+
+} // namespace
 
 MMapBuffer::MMapBuffer(size_t capacity)
-    : capacity_(capacity), head_(0), tail_(0), read_only_(false) {
-    buffer_ = new uint8_t[capacity_];
-    if (!buffer_) throw std::runtime_error("Failed to allocate ring buffer");
+    : MMapBuffer(capacity, false) {
 }
 
 MMapBuffer::MMapBuffer(size_t capacity, bool read_only)
-    : capacity_(capacity), head_(0), tail_(0), read_only_(read_only) {
-    buffer_ = new uint8_t[capacity_];
-    if (!buffer_) throw std::runtime_error("Failed to allocate ring buffer");
+    : read_only_(read_only) {
+    fd_ = memfd_create("binance_ring", MFD_CLOEXEC);
+    if (fd_ < 0) throw sys_error("Failed to create ring buffer memfd");
+    map_segment(capacity, true);
+}
+
+MMapBuffer::MMapBuffer(size_t capacity, const RingOptions& options)
+    : options_(options), read_only_(false) {
+    unsigned int flags = MFD_CLOEXEC;
+    if (options_.huge_pages == HUGE_PAGES_HUGETLB) flags |= MFD_HUGETLB;
+    fd_ = memfd_create("binance_ring", flags);
+    if (fd_ < 0) throw sys_error("Failed to create ring buffer memfd");
+    map_segment(capacity, true);
+}
+
+MMapBuffer::MMapBuffer(const std::string& name, size_t capacity, const RingOptions& options)
+    : options_(options), name_(name), owner_(true), read_only_(false) {
+    if (options_.huge_pages == HUGE_PAGES_HUGETLB) {
+        std::string path = HUGETLBFS_DIR + name_;
+        fd_ = open(path.c_str(), O_CREAT | O_TRUNC | O_RDWR | O_CLOEXEC, 0600);
+    } else {
+        fd_ = shm_open(name_.c_str(), O_CREAT | O_TRUNC | O_RDWR, 0600);
+    }
+    if (fd_ < 0) throw sys_error("Failed to create shared ring " + name_);
+    map_segment(capacity, true);
+}
+
+std::unique_ptr<MMapBuffer> MMapBuffer::attach(const std::string& name, bool read_only,
+                                               const RingOptions& local_options) {
+    int fd = shm_open(name.c_str(), O_RDWR, 0);
+    if (fd < 0 && errno == ENOENT) {
+        fd = open((HUGETLBFS_DIR + name).c_str(), O_RDWR | O_CLOEXEC);
+    }
+    if (fd < 0) throw sys_error("Failed to attach to shared ring " + name);
+    return std::unique_ptr<MMapBuffer>(new MMapBuffer(name, read_only, fd, local_options));
+}
+
+MMapBuffer::MMapBuffer(const std::string& name, bool read_only, int fd, const RingOptions& local_options)
+    : fd_(fd), name_(name), owner_(false), read_only_(read_only) {
+    struct stat st;
+    if (fstat(fd_, &st) != 0) {
+        close(fd_);
+        throw sys_error("Failed to stat shared ring " + name_);
+    }
+
+    // The creator's layout is recorded in the header; read it before mapping.
+    // pread works on both tmpfs and hugetlbfs and avoids a huge-page-sized probe mapping.
+    alignas(RingHeader) unsigned char raw[sizeof(RingHeader)];
+    if (static_cast<size_t>(st.st_size) <= sizeof(raw) ||
+        pread(fd_, raw, sizeof(raw), 0) != static_cast<ssize_t>(sizeof(raw))) {
+        close(fd_);
+        throw std::runtime_error("Shared ring " + name_ + " is not initialized");
+    }
+    uint32_t flags;
+    uint64_t data_offset;
+    std::memcpy(&flags, raw + offsetof(RingHeader, flags), sizeof(flags));
+    std::memcpy(&data_offset, raw + offsetof(RingHeader, data_offset), sizeof(data_offset));
+    if (data_offset == 0 || data_offset >= static_cast<uint64_t>(st.st_size)) {
+        close(fd_);
+        throw std::runtime_error("Shared ring " + name_ + " has an incompatible header");
+    }
+
+    options_.mirrored = (flags & RING_FLAG_MIRRORED) != 0;
+    // The consumer only needs to know whether the producer may move tail under it
+    if (flags & RING_FLAG_DROP_OLDEST) options_.overflow = OVERFLOW_DROP_OLDEST;
+    if (flags & RING_FLAG_HUGETLB) options_.huge_pages = HUGE_PAGES_HUGETLB;
+    options_.lock_memory = local_options.lock_memory;
+    options_.prefault = local_options.prefault;
+    data_offset_ = static_cast<size_t>(data_offset);
+
+    map_segment(static_cast<size_t>(st.st_size) - data_offset_, false);
 }
 
 MMapBuffer::~MMapBuffer() {
-    delete[] buffer_;
+    if (mapping_) munmap(mapping_, mapping_size_);
+    if (fd_ >= 0) close(fd_);
+    if (spill_fd_ >= 0) close(spill_fd_);
+    if (owner_ && !name_.empty()) {
+        if (options_.huge_pages == HUGE_PAGES_HUGETLB) {
+            unlink((HUGETLBFS_DIR + name_).c_str());
+        } else {
+            shm_unlink(name_.c_str());
+        }
+    }
+}
+
+void MMapBuffer::unmap_and_close() {
+    if (mapping_) munmap(mapping_, mapping_size_);
+    mapping_ = nullptr;
+    close(fd_);
+    fd_ = -1;
+}
+
+void MMapBuffer::map_segment(size_t capacity, bool create) {
+    if (capacity == 0) {
+        close(fd_);
+        throw std::runtime_error("Ring buffer capacity must be non-zero");
+    }
+
+    bool hugetlb = options_.huge_pages == HUGE_PAGES_HUGETLB;
+    size_t page_size = hugetlb ? huge_page_size() : static_cast<size_t>(sysconf(_SC_PAGESIZE));
+
+    if (create) {
+        // Power-of-two capacity lets positions be computed with a mask instead of a modulo.
+        // A mirrored or hugetlbfs data area must also be a whole number of pages, and on
+        // hugetlbfs the header takes a whole huge page so the data area stays aligned.
+        size_t rounded = (options_.mirrored || hugetlb) ? page_size : 1;
+        while (rounded < capacity) rounded <<= 1;
+        capacity = rounded;
+        data_offset_ = hugetlb ? page_size : HEADER_PAGE_SIZE;
+    } else if ((capacity & (capacity - 1)) != 0) {
+        close(fd_);
+        throw std::runtime_error("Shared ring " + name_ + " capacity is not a power of two");
+    }
+
+    size_t segment_size = data_offset_ + capacity;
+    if (create && ftruncate(fd_, static_cast<off_t>(segment_size)) != 0) {
+        close(fd_);
+        throw sys_error("Failed to size ring buffer");
+    }
+
+    if (options_.mirrored) {
+        map_mirrored(capacity, page_size);
+    } else {
+        mapping_size_ = segment_size;
+        mapping_ = mmap(nullptr, mapping_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        if (mapping_ == MAP_FAILED) {
+            mapping_ = nullptr;
+            close(fd_);
+            throw sys_error("Failed to map ring buffer");
+        }
+        header_ = static_cast<RingHeader*>(mapping_);
+    }
+    buffer_ = reinterpret_cast<uint8_t*>(header_) + data_offset_;
+    capacity_ = capacity;
+    mask_ = capacity - 1;
+
+    // Placement policy has to be in force before the creator first touches the pages
+    place_memory(create);
+
+    if (create) {
+        uint32_t flags = options_.mirrored ? RING_FLAG_MIRRORED : 0;
+        if (options_.overflow == OVERFLOW_DROP_OLDEST) flags |= RING_FLAG_DROP_OLDEST;
+        if (hugetlb) flags |= RING_FLAG_HUGETLB;
+        new (header_) RingHeader{RING_MAGIC, RING_LAYOUT_VERSION, capacity, flags, data_offset_,
+                                 {0}, {0}, {0}, {0}, {0}, {0}, {0}, {0}, {0}, {0}};
+        try {
+            if (options_.overflow == OVERFLOW_SPILL) {
+                open_spill();
+            }
+            if (!options_.journal_dir.empty()) {
+                journal_.reset(new FrameJournal(options_.journal_dir, options_.journal_file_size,
+                                                options_.journal_flush_interval));
+            }
+        } catch (...) {
+            unmap_and_close();
+            throw;
+        }
+    } else if (header_->magic != RING_MAGIC || header_->version != RING_LAYOUT_VERSION ||
+               header_->capacity != capacity) {
+        unmap_and_close();
+        throw std::runtime_error("Shared ring " + name_ + " has an incompatible header");
+    }
+
+    // Seed the cached peer indices from the live header when attaching mid-stream
+    producer_.cached_tail = header_->tail.load(std::memory_order_acquire);
+    consumer_.cached_head = header_->head.load(std::memory_order_acquire);
+}
+
+void MMapBuffer::map_mirrored(size_t capacity, size_t page_size) {
+    // Reserve one contiguous range for header + two copies of the data area, then map
+    // the segment over the front of it and the data pages again right behind it.
+    // Huge page mappings must start on a huge page boundary, so reserve slack to align.
+    size_t segment_size = data_offset_ + capacity;
+    size_t slack = page_size > HEADER_PAGE_SIZE ? page_size : 0;
+    mapping_size_ = segment_size + capacity + slack;
+    mapping_ = mmap(nullptr, mapping_size_, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapping_ == MAP_FAILED) {
+        mapping_ = nullptr;
+        close(fd_);
+        throw sys_error("Failed to reserve mirrored ring buffer");
+    }
+
+    uintptr_t start = reinterpret_cast<uintptr_t>(mapping_);
+    uint8_t* base = reinterpret_cast<uint8_t*>(slack ? (start + slack - 1) & ~(slack - 1) : start);
+    void* primary = mmap(base, segment_size, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_FIXED, fd_, 0);
+    void* mirror = primary == MAP_FAILED ? MAP_FAILED :
+        mmap(base + segment_size, capacity, PROT_READ | PROT_WRITE,
+             MAP_SHARED | MAP_FIXED, fd_, static_cast<off_t>(data_offset_));
+    if (mirror == MAP_FAILED) {
+        unmap_and_close();
+        throw sys_error("Failed to map mirrored ring buffer");
+    }
+    header_ = reinterpret_cast<RingHeader*>(base);
+}
+
+// Apply the huge page, NUMA, prefault and mlock options to the fresh mapping
+void MMapBuffer::place_memory(bool create) {
+    uint8_t* segment = reinterpret_cast<uint8_t*>(header_);
+    size_t segment_size = data_offset_ + capacity_;
+    size_t mapped_size = options_.mirrored ? segment_size + capacity_ : segment_size;
+
+    if (create && options_.huge_pages == HUGE_PAGES_TRANSPARENT &&
+        madvise(buffer_, capacity_, MADV_HUGEPAGE) != 0) {
+        unmap_and_close();
+        throw sys_error("Failed to enable transparent huge pages for ring buffer");
+    }
+
+    if (create && options_.numa_node >= 0) {
+        // Raw syscall so the build does not pick up a libnuma dependency.
+        // The policy is stored on the shared object, so it covers the mirror view too.
+        unsigned long nodemask[4] = {};
+        constexpr unsigned long MASK_BITS = sizeof(nodemask) * CHAR_BIT;
+        constexpr unsigned long WORD_BITS = sizeof(unsigned long) * CHAR_BIT;
+        unsigned long node = static_cast<unsigned long>(options_.numa_node);
+        if (node >= MASK_BITS) {
+            unmap_and_close();
+            throw std::runtime_error("Ring buffer NUMA node " + std::to_string(node) + " is out of range");
+        }
+        nodemask[node / WORD_BITS] |= 1UL << (node % WORD_BITS);
+        if (syscall(SYS_mbind, segment, segment_size, MPOL_BIND, nodemask, MASK_BITS, 0) != 0) {
+            unmap_and_close();
+            throw sys_error("Failed to bind ring buffer to NUMA node " + std::to_string(node));
+        }
+    }
+
+    if (options_.prefault) {
+        // Only the creator may write: an attacher would race the producer
+        if (madvise(segment, mapped_size, create ? MADV_POPULATE_WRITE : MADV_POPULATE_READ) != 0) {
+            // Kernels before 5.14 lack MADV_POPULATE_*: touch one byte per page instead
+            size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+            volatile uint8_t* bytes = segment;
+            for (size_t off = 0; off < mapped_size; off += page_size) {
+                if (create) {
+                    bytes[off] = 0;
+                } else {
+                    (void)bytes[off];
+                }
+            }
+        }
+    }
+
+    if (options_.lock_memory && mlock(segment, mapped_size) != 0) {
+        unmap_and_close();
+        throw sys_error("Failed to lock ring buffer in memory");
+    }
+}
+
+void MMapBuffer::open_spill() {
+    if (options_.spill_path.empty()) {
+        throw std::runtime_error("Spill overflow policy needs a spill_path");
+    }
+    spill_fd_ = open(options_.spill_path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (spill_fd_ < 0) throw sys_error("Failed to open ring spill file " + options_.spill_path);
+}
+
+RingStats MMapBuffer::stats() const {
+    return RingStats{
+        header_->dropped_frames.load(std::memory_order_relaxed),
+        header_->dropped_bytes.load(std::memory_order_relaxed),
+        header_->spilled_frames.load(std::memory_order_relaxed),
+        header_->spilled_bytes.load(std::memory_order_relaxed),
+        header_->high_water.load(std::memory_order_relaxed)
+    };
+}
+
+size_t MMapBuffer::free_space() const {
+    uint64_t head = header_->head.load(std::memory_order_relaxed);
+    uint64_t tail = header_->tail.load(std::memory_order_acquire);
+    return capacity_ - static_cast<size_t>(head - tail);
 }
 
 size_t MMapBuffer::write(const uint8_t* data, size_t len) {
@@ -23,40 +357,449 @@ size_t MMapBuffer::write(const uint8_t* data, size_t len) {
     if (read_only_) {
         return 0;
     }
-    
-    size_t head = head_.load(std::memory_order_relaxed);
-    size_t tail = tail_.load(std::memory_order_acquire);
 
-    size_t space = (tail + capacity_ - head - 1) % capacity_;
+    uint64_t head = header_->head.load(std::memory_order_relaxed);
+    size_t space = capacity_ - static_cast<size_t>(head - producer_.cached_tail);
+    if (space < len) {
+        producer_.cached_tail = header_->tail.load(std::memory_order_acquire);
+        space = capacity_ - static_cast<size_t>(head - producer_.cached_tail);
+    }
     size_t to_write = std::min(len, space);
 
-    size_t first_chunk = std::min(to_write, capacity_ - (head % capacity_));
-    std::memcpy(buffer_ + (head % capacity_), data, first_chunk);
+    size_t pos = head & mask_;
+    size_t first_chunk = options_.mirrored ? to_write : std::min(to_write, capacity_ - pos);
+    std::memcpy(buffer_ + pos, data, first_chunk);
 
     size_t second_chunk = to_write - first_chunk;
     if (second_chunk > 0) {
         std::memcpy(buffer_, data + first_chunk, second_chunk);
     }
 
-    head_.store((head + to_write) % capacity_, std::memory_order_release);
+    header_->head.store(head + to_write, std::memory_order_release);
+    wake_consumer();
     return to_write;
 }
 
 size_t MMapBuffer::read(uint8_t* out, size_t max_len) {
-    size_t head = head_.load(std::memory_order_acquire);
-    size_t tail = tail_.load(std::memory_order_relaxed);
-
-    size_t available = (head + capacity_ - tail) % capacity_;
+    uint64_t tail = header_->tail.load(std::memory_order_relaxed);
+    size_t available = static_cast<size_t>(consumer_.cached_head - tail);
+    if (available < max_len) {
+        consumer_.cached_head = header_->head.load(std::memory_order_acquire);
+        available = static_cast<size_t>(consumer_.cached_head - tail);
+    }
     size_t to_read = std::min(max_len, available);
 
-    size_t first_chunk = std::min(to_read, capacity_ - (tail % capacity_));
-    std::memcpy(out, buffer_ + (tail % capacity_), first_chunk);
+    size_t pos = tail & mask_;
+    size_t first_chunk = options_.mirrored ? to_read : std::min(to_read, capacity_ - pos);
+    std::memcpy(out, buffer_ + pos, first_chunk);
 
     size_t second_chunk = to_read - first_chunk;
     if (second_chunk > 0) {
         std::memcpy(out + first_chunk, buffer_, second_chunk);
     }
 
-    tail_.store((tail + to_read) % capacity_, std::memory_order_release);
+    header_->tail.store(tail + to_read, std::memory_order_release);
     return to_read;
 }
+
+uint8_t* MMapBuffer::try_reserve(uint8_t type, size_t len) {
+    if (read_only_) {
+        return nullptr;
+    }
+
+    size_t need = FRAME_HEADER_SIZE + len;
+    if (need > capacity_) {
+        return nullptr;
+    }
+
+    uint64_t head = header_->head.load(std::memory_order_relaxed);
+    size_t pos = head & mask_;
+    size_t to_end = capacity_ - pos;
+
+    // A frame that would straddle the end is placed at offset 0 instead,
+    // consuming the rest of the buffer as padding. A mirrored ring never pads:
+    // the bytes past the end land at the start through the second mapping.
+    bool wrap = !options_.mirrored && need > to_end;
+    size_t total = wrap ? to_end + need : need;
+    if (total > capacity_ - static_cast<size_t>(head - producer_.cached_tail)) {
+        producer_.cached_tail = header_->tail.load(std::memory_order_acquire);
+        size_t free = capacity_ - static_cast<size_t>(head - producer_.cached_tail);
+        if (total > free) {
+            // Padding plus frame can be more than the whole ring, which would never
+            // fit: publish the padding on its own as soon as it does, so the retry
+            // only needs room for the frame at offset 0
+            if (wrap && total > capacity_ && to_end <= free) {
+                write_pad(pos, to_end);
+                header_->head.store(head + to_end, std::memory_order_release);
+                // A parked consumer must skip the padding to free the space we wait on
+                wake_consumer();
+            }
+            return nullptr;
+        }
+    }
+
+    if (wrap) {
+        write_pad(pos, to_end);
+        pos = 0;
+    }
+
+    producer_.reserve_pos = pos;
+    producer_.reserve_next = head + total;
+    producer_.reserve_type = type;
+    producer_.reserve_len = static_cast<uint32_t>(len);
+    return buffer_ + pos + FRAME_HEADER_SIZE;
+}
+
+// Mark the skipped tail end of an unmirrored buffer as padding when it can hold a
+// frame header, otherwise the consumer skips the short remainder on its own
+void MMapBuffer::write_pad(size_t pos, size_t to_end) {
+    if (to_end >= FRAME_HEADER_SIZE) {
+        buffer_[pos] = FRAME_PAD;
+        uint32_t pad_len = static_cast<uint32_t>(to_end - FRAME_HEADER_SIZE);
+        std::memcpy(buffer_ + pos + 1, &pad_len, sizeof(uint32_t));
+    }
+}
+
+uint8_t* MMapBuffer::reserve(uint8_t type, size_t len) {
+    uint8_t* body = try_reserve(type, len);
+    if (body || read_only_) {
+        return body;
+    }
+
+    size_t frame_bytes = FRAME_HEADER_SIZE + len;
+    switch (options_.overflow) {
+        case OVERFLOW_BLOCK: {
+            if (frame_bytes > capacity_) {
+                break;  // Would wait forever
+            }
+            // A consumer that stalled or went away drops the frame after block_timeout
+            // instead of wedging the producer, and its shutdown, for good
+            auto deadline = std::chrono::steady_clock::now() + options_.block_timeout;
+            do {
+                std::this_thread::yield();
+                body = try_reserve(type, len);
+            } while (!body && std::chrono::steady_clock::now() < deadline);
+            if (body) {
+                return body;
+            }
+            break;
+        }
+
+        case OVERFLOW_DROP_OLDEST:
+            while (!body && evict_oldest()) {
+                body = try_reserve(type, len);
+            }
+            if (body) {
+                return body;
+            }
+            break;
+
+        case OVERFLOW_SPILL:
+            if (len <= UINT32_MAX) {
+                spill_buffer_.resize(len);
+                producer_.spilling = true;
+                producer_.reserve_type = type;
+                producer_.reserve_len = static_cast<uint32_t>(len);
+                return spill_buffer_.data();
+            }
+            break;
+
+        case OVERFLOW_DROP_NEWEST:
+            break;
+    }
+
+    count_drop(frame_bytes);
+    return nullptr;
+}
+
+void MMapBuffer::commit(uint64_t timestamp_ns) {
+    if (producer_.spilling) {
+        producer_.spilling = false;
+        uint8_t frame_header[FRAME_HEADER_SIZE];
+        frame_header[0] = producer_.reserve_type;
+        std::memcpy(frame_header + 1, &producer_.reserve_len, sizeof(uint32_t));
+        struct iovec parts[2] = {
+            {frame_header, FRAME_HEADER_SIZE},
+            {spill_buffer_.data(), producer_.reserve_len}
+        };
+        size_t frame_bytes = FRAME_HEADER_SIZE + producer_.reserve_len;
+        if (writev(spill_fd_, parts, 2) == static_cast<ssize_t>(frame_bytes)) {
+            header_->spilled_frames.store(header_->spilled_frames.load(std::memory_order_relaxed) + 1,
+                                          std::memory_order_relaxed);
+            header_->spilled_bytes.store(header_->spilled_bytes.load(std::memory_order_relaxed) + frame_bytes,
+                                         std::memory_order_relaxed);
+        } else {
+            count_drop(frame_bytes);
+        }
+        if (journal_) {
+            journal_->append(producer_.reserve_type, spill_buffer_.data(), producer_.reserve_len, timestamp_ns);
+        }
+        return;
+    }
+
+    buffer_[producer_.reserve_pos] = producer_.reserve_type;
+    std::memcpy(buffer_ + producer_.reserve_pos + 1, &producer_.reserve_len, sizeof(uint32_t));
+    header_->head.store(producer_.reserve_next, std::memory_order_release);
+    wake_consumer();
+
+    // Journal after publishing so the consumer never waits on it. The frame bytes stay
+    // put: only this producer can overwrite them.
+    if (journal_) {
+        journal_->append(producer_.reserve_type, buffer_ + producer_.reserve_pos + FRAME_HEADER_SIZE,
+                         producer_.reserve_len, timestamp_ns);
+    }
+
+    // The cached tail lags the real one, so this overestimates the fill level. Only when
+    // the estimate beats the recorded mark is the real tail read, which amortizes to one
+    // load of the consumer's cache line per high_water bytes written.
+    uint64_t used = producer_.reserve_next - producer_.cached_tail;
+    if (used > producer_.high_water) {
+        producer_.cached_tail = header_->tail.load(std::memory_order_acquire);
+        used = producer_.reserve_next - producer_.cached_tail;
+        if (used > producer_.high_water) {
+            producer_.high_water = used;
+            header_->high_water.store(used, std::memory_order_relaxed);
+        }
+    }
+}
+
+// Drop-oldest: move tail past the oldest frame on the consumer's behalf.
+// Returns false once the ring is empty.
+bool MMapBuffer::evict_oldest() {
+    uint64_t head = header_->head.load(std::memory_order_relaxed);
+    uint64_t tail = header_->tail.load(std::memory_order_acquire);
+    if (tail == head) {
+        producer_.cached_tail = tail;
+        return false;
+    }
+
+    size_t pos = tail & mask_;
+    size_t to_end = capacity_ - pos;
+    uint64_t next;
+    size_t frame_bytes = 0;
+    if (!options_.mirrored && (to_end < FRAME_HEADER_SIZE || buffer_[pos] == FRAME_PAD)) {
+        next = tail + to_end;
+    } else {
+        uint32_t len;
+        std::memcpy(&len, buffer_ + pos + 1, sizeof(uint32_t));
+        frame_bytes = FRAME_HEADER_SIZE + len;
+        next = tail + frame_bytes;
+    }
+
+    // Losing the race means the consumer released that frame itself: space was freed either way
+    if (header_->tail.compare_exchange_strong(tail, next, std::memory_order_acq_rel)) {
+        producer_.cached_tail = next;
+        if (frame_bytes > 0) count_drop(frame_bytes);
+    } else {
+        producer_.cached_tail = tail;
+    }
+    return true;
+}
+
+void MMapBuffer::count_drop(size_t frame_bytes) {
+    header_->dropped_frames.store(header_->dropped_frames.load(std::memory_order_relaxed) + 1,
+                                  std::memory_order_relaxed);
+    header_->dropped_bytes.store(header_->dropped_bytes.load(std::memory_order_relaxed) + frame_bytes,
+                                 std::memory_order_relaxed);
+}
+
+std::optional<RingFrame> MMapBuffer::peek_frame() {
+    bool evicting = options_.overflow == OVERFLOW_DROP_OLDEST;
+    uint64_t tail = header_->tail.load(evicting ? std::memory_order_acquire : std::memory_order_relaxed);
+    uint64_t start = tail;
+
+    for (;;) {
+        // tail can overtake the cached head when the producer evicts past it
+        if (tail >= consumer_.cached_head) {
+            consumer_.cached_head = header_->head.load(std::memory_order_acquire);
+            if (tail == consumer_.cached_head) {
+                break;
+            }
+        }
+
+        size_t pos = tail & mask_;
+        size_t to_end = capacity_ - pos;
+        if (!options_.mirrored && to_end < FRAME_HEADER_SIZE) {
+            // Too short for a frame header: the producer wrapped without a pad frame
+            tail += to_end;
+            continue;
+        }
+
+        uint8_t type = buffer_[pos];
+        uint32_t len;
+        std::memcpy(&len, buffer_ + pos + 1, sizeof(uint32_t));
+
+        if (type == FRAME_PAD) {
+            tail += to_end;
+            continue;
+        }
+
+        // A frame running past head (or off the end of an unmirrored buffer) was
+        // overwritten after an eviction: resync with the producer's tail
+        uint64_t frame_bytes = FRAME_HEADER_SIZE + static_cast<uint64_t>(len);
+        if (evicting && (frame_bytes > consumer_.cached_head - tail ||
+                         (!options_.mirrored && frame_bytes > to_end))) {
+            tail = start = header_->tail.load(std::memory_order_acquire);
+            continue;
+        }
+
+        // Publish any padding we skipped so the producer can reuse it right away
+        if (tail != start && !publish_tail(start, tail)) {
+            tail = start = header_->tail.load(std::memory_order_acquire);
+            continue;
+        }
+        consumer_.peek_start = tail;
+        consumer_.release_next = tail + frame_bytes;
+        return RingFrame{type, buffer_ + pos + FRAME_HEADER_SIZE, len};
+    }
+
+    if (tail != start) {
+        publish_tail(start, tail);
+    }
+    return std::nullopt;
+}
+
+bool MMapBuffer::release() {
+    return publish_tail(consumer_.peek_start, consumer_.release_next);
+}
+
+// Consumer-side tail update. Only a drop-oldest producer also moves tail, so only
+// then is a compare-and-swap needed; it fails if the producer evicted past expected.
+bool MMapBuffer::publish_tail(uint64_t expected, uint64_t desired) {
+    if (options_.overflow != OVERFLOW_DROP_OLDEST) {
+        header_->tail.store(desired, std::memory_order_release);
+        return true;
+    }
+    return header_->tail.compare_exchange_strong(expected, desired, std::memory_order_acq_rel);
+}
+
+size_t MMapBuffer::drain(size_t max_frames, size_t max_bytes,
+                         const std::function<void(const RingFrame&)>& callback) {
+    if (options_.overflow == OVERFLOW_DROP_OLDEST) {
+        return drain_copying(max_frames, max_bytes, callback);
+    }
+
+    uint64_t tail = header_->tail.load(std::memory_order_relaxed);
+    uint64_t head = header_->head.load(std::memory_order_acquire);
+    consumer_.cached_head = head;
+    uint64_t start = tail;
+    size_t frames = 0;
+    size_t bytes = 0;
+
+    while (tail != head && frames < max_frames) {
+        size_t pos = tail & mask_;
+        size_t to_end = capacity_ - pos;
+        if (!options_.mirrored && (to_end < FRAME_HEADER_SIZE || buffer_[pos] == FRAME_PAD)) {
+            tail += to_end;
+            continue;
+        }
+
+        uint32_t len;
+        std::memcpy(&len, buffer_ + pos + 1, sizeof(uint32_t));
+        size_t frame_bytes = FRAME_HEADER_SIZE + len;
+        if (frames > 0 && bytes + frame_bytes > max_bytes) {
+            break;
+        }
+
+        try {
+            callback(RingFrame{buffer_[pos], buffer_ + pos + FRAME_HEADER_SIZE, len});
+        } catch (...) {
+            // Keep what was handled, including the frame that threw
+            header_->tail.store(tail + frame_bytes, std::memory_order_release);
+            throw;
+        }
+        tail += frame_bytes;
+        bytes += frame_bytes;
+        ++frames;
+    }
+
+    if (tail != start) {
+        header_->tail.store(tail, std::memory_order_release);
+    }
+    return frames;
+}
+
+// Frames of a drop-oldest ring can be overwritten while held, so each one is copied out
+// and only passed on once release() confirms the producer did not evict it meanwhile
+size_t MMapBuffer::drain_copying(size_t max_frames, size_t max_bytes,
+                                 const std::function<void(const RingFrame&)>& callback) {
+    size_t frames = 0;
+    size_t bytes = 0;
+    while (frames < max_frames && (frames == 0 || bytes < max_bytes)) {
+        std::optional<RingFrame> frame = peek_frame();
+        if (!frame) {
+            break;
+        }
+        drain_copy_.assign(frame->data, frame->data + frame->size);
+        uint8_t type = frame->type;
+        if (!release()) {
+            continue;
+        }
+        callback(RingFrame{type, drain_copy_.data(), static_cast<uint32_t>(drain_copy_.size())});
+        bytes += FRAME_HEADER_SIZE + drain_copy_.size();
+        ++frames;
+    }
+    return frames;
+}
+
+void MMapBuffer::wake_consumer() {
+    if (!header_->park_enabled.load(std::memory_order_relaxed)) {
+        return;
+    }
+    // Order the head store before the sleepers check; pairs with the fetch_add in wait_for_data
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (header_->sleepers.load(std::memory_order_relaxed) > 0) {
+        header_->wake_seq.fetch_add(1, std::memory_order_release);
+        futex_wake(header_->wake_seq);
+    }
+}
+
+bool MMapBuffer::has_data() {
+    consumer_.cached_head = header_->head.load(std::memory_order_acquire);
+    return consumer_.cached_head != header_->tail.load(std::memory_order_relaxed);
+}
+
+bool MMapBuffer::wait_for_data(WaitStrategy strategy, std::chrono::milliseconds timeout) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+
+    if (strategy != WAIT_BLOCKING) {
+        for (int i = 0; i < WAIT_SPIN_ITERATIONS; ++i) {
+            if (has_data()) return true;
+            cpu_relax();
+        }
+    }
+
+    while (std::chrono::steady_clock::now() < deadline) {
+        switch (strategy) {
+            case WAIT_BUSY_SPIN:
+                for (int i = 0; i < WAIT_SPIN_ITERATIONS; ++i) {
+                    if (has_data()) return true;
+                    cpu_relax();
+                }
+                break;
+
+            case WAIT_SPIN_YIELD:
+                if (has_data()) return true;
+                std::this_thread::yield();
+                break;
+
+            case WAIT_SPIN_PARK:
+            case WAIT_BLOCKING: {
+                // A producer that has not seen park_enabled yet may skip one wake-up;
+                // the futex timeout bounds that delay
+                header_->park_enabled.store(1, std::memory_order_relaxed);
+                uint32_t seen = header_->wake_seq.load(std::memory_order_acquire);
+                header_->sleepers.fetch_add(1, std::memory_order_seq_cst);
+                bool ready = has_data();
+                if (!ready) {
+                    futex_wait(header_->wake_seq, seen, deadline - std::chrono::steady_clock::now());
+                    ready = has_data();
+                }
+                header_->sleepers.fetch_sub(1, std::memory_order_relaxed);
+                if (ready) return true;
+                break;
+            }
+        }
+    }
+    return has_data();
+}
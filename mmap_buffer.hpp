@@ -2,15 +2,155 @@
 #include <cstddef>
 #include <cstdint>
 #include <atomic>
+#include <chrono>
+#include <functional>
 #include <stdexcept>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
 
+// Name of the shared segment the connector publishes the feed into.
+// Other processes (strategy, recorder) attach to it with MMapBuffer::attach(FEED_RING_NAME).
+constexpr char FEED_RING_NAME[] = "/binance_feed";
+
+// Feed ring size when none is configured; comfortably holds bursts of 50-level depth frames
+constexpr size_t DEFAULT_FEED_RING_CAPACITY = 1 << 20;
+
+// Layout version of RingHeader and the frames behind it, bumped whenever either changes
+constexpr uint32_t RING_LAYOUT_VERSION = 9;
+
+// Every frame in the ring starts with a 1-byte type and a 4-byte body length
+constexpr size_t FRAME_HEADER_SIZE = 5;
+
+// A committed frame, viewed in place inside the ring
+struct RingFrame {
+    uint8_t type;
+    const uint8_t* data;
+    uint32_t size;
+};
+
+constexpr size_t CACHE_LINE_SIZE = 64;
+
+// RingHeader::flags bits
+constexpr uint32_t RING_FLAG_MIRRORED = 0x1;
+constexpr uint32_t RING_FLAG_DROP_OLDEST = 0x2;  // Producer may evict unread frames
+constexpr uint32_t RING_FLAG_HUGETLB = 0x4;      // Segment lives on hugetlbfs
+
+// Where named HUGE_PAGES_HUGETLB rings are created; must be a hugetlbfs mount
+constexpr char HUGETLBFS_DIR[] = "/dev/hugepages";
+
+// How a consumer waits when the ring is empty
+enum WaitStrategy {
+    WAIT_BUSY_SPIN,   // Spin on the head index; lowest latency, burns a whole core
+    WAIT_SPIN_YIELD,  // Spin briefly, then yield the CPU between checks
+    WAIT_SPIN_PARK,   // Spin briefly, then sleep on a futex until the producer wakes us
+    WAIT_BLOCKING     // Sleep on the futex straight away
+};
+
+// What MMapBuffer::reserve() does when a frame does not fit
+enum OverflowPolicy {
+    OVERFLOW_BLOCK,        // Wait up to block_timeout for the consumer to free space; stalls the producer
+    OVERFLOW_DROP_NEWEST,  // Drop the frame being written
+    OVERFLOW_DROP_OLDEST,  // Evict the oldest unread frames until the new one fits
+    OVERFLOW_SPILL         // Append the frame to RingOptions::spill_path instead
+};
+
+// Page size backing the ring memory
+enum HugePageMode {
+    HUGE_PAGES_NONE,
+    HUGE_PAGES_TRANSPARENT,  // madvise(MADV_HUGEPAGE); shmem THP must be set to advise or always
+    HUGE_PAGES_HUGETLB       // Reserved huge pages (vm.nr_hugepages) through hugetlbfs
+};
+
+// Creation-time options for a ring
+struct RingOptions {
+    // Map the data area twice, back to back, so any frame is contiguous in virtual
+    // memory even when it wraps. Capacity is rounded up to a whole number of pages.
+    bool mirrored = false;
+    OverflowPolicy overflow = OVERFLOW_DROP_NEWEST;
+    // Longest OVERFLOW_BLOCK waits for space before dropping the frame after all
+    std::chrono::milliseconds block_timeout{1000};
+    // Spill file for OVERFLOW_SPILL, opened for append. Frames keep their ring framing
+    // (type, length, body) so the file can be replayed with the same parser.
+    std::string spill_path;
+
+    // Memory placement. Large rings otherwise take TLB misses, can be paged out and land
+    // on whichever NUMA node first touches them. Failures throw std::runtime_error.
+    HugePageMode huge_pages = HUGE_PAGES_NONE;
+    bool lock_memory = false;  // mlock the mapping so it is never paged out
+    bool prefault = false;     // Fault every page in up front rather than on first use
+    int numa_node = -1;        // Bind the ring's pages to this node; -1 leaves it to first touch
+
+    // Journal mode: every committed (or spilled) frame is also appended to rolling
+    // memory-mapped files in journal_dir, flushed in the background. Empty disables it.
+    // See FrameJournal in journal.hpp for the file layout.
+    std::string journal_dir;
+    size_t journal_file_size = 256 << 20;
+    std::chrono::milliseconds journal_flush_interval{100};
+};
+
+// Producer-side overflow counters. Frames lost to a frame larger than the ring
+// are counted as dropped under every policy.
+struct RingStats {
+    uint64_t dropped_frames;
+    uint64_t dropped_bytes;
+    uint64_t spilled_frames;
+    uint64_t spilled_bytes;
+    uint64_t high_water;  // Most bytes seen queued at once
+};
+
+class FrameJournal;
+
+// Control block stored in the first page of the mapping, ahead of the data area.
+// head and tail are monotonically increasing byte counters (never wrapped); the
+// position in the data area is counter & (capacity - 1). Each lives on its own
+// cache line so the producer and consumer never write to the same line.
+struct RingHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t capacity;
+    uint32_t flags;
+    uint64_t data_offset;  // Start of the data area: one (possibly huge) page past the header
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> head;  // Written by the producer only
+    // Written by the consumer, and also by the producer when it evicts under drop-oldest
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> tail;
+    // Futex parking: the consumer announces itself in sleepers and waits on wake_seq,
+    // which the producer bumps after publishing. park_enabled is set once a consumer
+    // first parks so producers of spin-only rings never pay for the wake check.
+    alignas(CACHE_LINE_SIZE) std::atomic<uint32_t> wake_seq;
+    std::atomic<uint32_t> sleepers;
+    std::atomic<uint32_t> park_enabled;
+    // Overflow accounting (see RingStats), written by the producer only
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> dropped_frames;
+    std::atomic<uint64_t> dropped_bytes;
+    std::atomic<uint64_t> spilled_frames;
+    std::atomic<uint64_t> spilled_bytes;
+    std::atomic<uint64_t> high_water;
+};
+
+// Single-producer/single-consumer byte ring. Capacities are rounded up to a power of two.
 class MMapBuffer {
 public:
+    // Private ring backed by an anonymous memfd
     explicit MMapBuffer(size_t capacity);
     // Add constructor with read mode flag
     explicit MMapBuffer(size_t capacity, bool read_only);
+    MMapBuffer(size_t capacity, const RingOptions& options);
+    // Create (or recreate) a named shared-memory ring that other processes can attach to
+    MMapBuffer(const std::string& name, size_t capacity, const RingOptions& options = RingOptions());
     ~MMapBuffer();
 
+    // Attach to an existing named ring; capacity, mirroring and page size are taken from its
+    // header. Of local_options only lock_memory and prefault apply, to this mapping.
+    // Throws std::runtime_error if the segment does not exist or has a different layout.
+    static std::unique_ptr<MMapBuffer> attach(const std::string& name, bool read_only = true,
+                                              const RingOptions& local_options = RingOptions());
+
+    MMapBuffer(const MMapBuffer&) = delete;
+    MMapBuffer& operator=(const MMapBuffer&) = delete;
+
+    // Raw byte-stream API; do not mix with the framed API on the same ring.
     // Write raw data into ring buffer
     // Returns number of bytes actually written (0 if no space)
     size_t write(const uint8_t* data, size_t len);
@@ -18,14 +158,100 @@ public:
     // Read raw data from ring buffer
     // Returns number of bytes actually read (0 if empty)
     size_t read(uint8_t* out, size_t max_len);
-    
+
+    // Number of bytes that can currently be written without blocking
+    size_t free_space() const;
+
+    // Framed, zero-copy producer API.
+    // Reserves a contiguous body of len bytes for a frame of the given type and returns a
+    // pointer to it, or nullptr if the whole frame does not fit. Nothing is visible to the
+    // consumer until commit(), so a frame is either published in full or not at all.
+    uint8_t* try_reserve(uint8_t type, size_t len);
+    // As try_reserve(), but applies the ring's overflow policy when the frame does not fit.
+    // Returns nullptr only when the frame is dropped; the drop is counted in stats().
+    uint8_t* reserve(uint8_t type, size_t len);
+    // timestamp_ns is the frame's exchange timestamp, used only to index the journal
+    void commit(uint64_t timestamp_ns = 0);
+
+    // Framed, zero-copy consumer API.
+    // Returns a view of the oldest committed frame without copying it out of the ring.
+    // The view stays valid until release(), which hands the space back to the producer.
+    // Under drop-oldest the producer may evict and overwrite the frame while it is being
+    // read; release() then returns false and whatever was read from the view is garbage.
+    std::optional<RingFrame> peek_frame();
+    bool release();
+
+    // Batch consumer API: hands every available frame, up to max_frames frames or about
+    // max_bytes bytes (at least one frame), to callback in order, reading head once and
+    // publishing tail once for the whole batch. Returns the number of frames handled.
+    // Drop-oldest rings copy each frame out and validate it before the callback sees it.
+    size_t drain(size_t max_frames, size_t max_bytes, const std::function<void(const RingFrame&)>& callback);
+
+    // Wait until the ring may hold unread data, using the given strategy.
+    // Returns false if the timeout expired first, so callers can check stop flags.
+    bool wait_for_data(WaitStrategy strategy, std::chrono::milliseconds timeout);
+
     // Check if this buffer is in read-only mode
     bool is_read_only() const { return read_only_; }
 
+    size_t capacity() const { return capacity_; }
+    bool is_mirrored() const { return options_.mirrored; }
+    const std::string& name() const { return name_; }
+    OverflowPolicy overflow_policy() const { return options_.overflow; }
+
+    // Snapshot of the overflow counters; readable from any process attached to the ring
+    RingStats stats() const;
+
 private:
-    uint8_t* buffer_;
-    size_t capacity_;
-    std::atomic<size_t> head_;
-    std::atomic<size_t> tail_;
+    MMapBuffer(const std::string& name, bool read_only, int fd, const RingOptions& local_options);
+    void map_segment(size_t capacity, bool create);
+    void map_mirrored(size_t capacity, size_t page_size);
+    void place_memory(bool create);
+    void unmap_and_close();
+    bool has_data();
+    void write_pad(size_t pos, size_t to_end);
+    void wake_consumer();
+    bool evict_oldest();
+    bool publish_tail(uint64_t expected, uint64_t desired);
+    void count_drop(size_t frame_bytes);
+    void open_spill();
+    size_t drain_copying(size_t max_frames, size_t max_bytes, const std::function<void(const RingFrame&)>& callback);
+
+    int fd_ = -1;
+    void* mapping_ = nullptr;
+    size_t mapping_size_ = 0;
+    RingHeader* header_ = nullptr;  // Start of the segment; mapping_ may begin earlier for alignment
+    size_t data_offset_ = 0;
+    uint8_t* buffer_ = nullptr;
+    size_t capacity_ = 0;
+    size_t mask_ = 0;
+    RingOptions options_;
+    std::string name_;
+    int spill_fd_ = -1;
+    std::vector<uint8_t> spill_buffer_;  // Holds a spilled frame's body between reserve() and commit()
+    std::vector<uint8_t> drain_copy_;    // Drop-oldest drain() copies frames out here
+    std::unique_ptr<FrameJournal> journal_;
+
+    // Producer-local state: last tail seen and the outstanding reservation.
+    // The shared tail is only reloaded when the cached value shows too little space.
+    struct alignas(CACHE_LINE_SIZE) ProducerState {
+        uint64_t cached_tail = 0;
+        size_t reserve_pos = 0;
+        uint64_t reserve_next = 0;
+        uint8_t reserve_type = 0;
+        uint32_t reserve_len = 0;
+        bool spilling = false;     // Outstanding reservation lives in spill_buffer_
+        uint64_t high_water = 0;   // Local copy of header_->high_water
+    } producer_;
+
+    // Consumer-local state: last head seen and the bounds of the peeked frame.
+    // The shared head is only reloaded when the cached value shows the ring empty.
+    struct alignas(CACHE_LINE_SIZE) ConsumerState {
+        uint64_t cached_head = 0;
+        uint64_t peek_start = 0;
+        uint64_t release_next = 0;
+    } consumer_;
+
+    bool owner_ = false;      // Creator unlinks the named segment on destruction
     bool read_only_ = false;  // Default to write mode
 };
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+// Bounded lock-free multi-producer/multi-consumer queue with the TSQueue interface
+// (Dmitry Vyukov's sequence-per-slot design).
+//
+// Every cell carries a sequence number that says whose turn it is: a producer may fill
+// cell pos & mask when its sequence equals pos, a consumer may drain it when it equals
+// pos + 1. Producers only contend on one CAS of enqueue_pos_, consumers on one CAS of
+// dequeue_pos_; nobody ever waits for another thread to finish a half-done operation
+// on a different cell. Cells are padded to a cache line so neighbouring producers do
+// not false-share.
+template <typename T>
+class MPMCQueue {
+public:
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+    static constexpr size_t DEFAULT_CAPACITY = 65536;
+
+    explicit MPMCQueue(size_t capacity = DEFAULT_CAPACITY) {
+        size_t rounded = 2;
+        while (rounded < capacity) rounded <<= 1;
+        cells_.reset(new Cell[rounded]);
+        mask_ = rounded - 1;
+        for (size_t i = 0; i < rounded; ++i) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MPMCQueue(const MPMCQueue&) = delete;
+    MPMCQueue& operator=(const MPMCQueue&) = delete;
+
+    // Any producer: false if the queue is full
+    bool try_push(const T& value) {
+        uint64_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &cells_[pos & mask_];
+            uint64_t seq = cell->sequence.load(std::memory_order_acquire);
+            int64_t diff = static_cast<int64_t>(seq - pos);
+            if (diff == 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;  // The cell still holds an item from one lap ago
+            } else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        cell->value = value;
+        cell->sequence.store(pos + 1, std::memory_order_release);
+
+        if (blocking_.load(std::memory_order_relaxed)) {
+            // Order the publish before the waiter check; pairs with the fetch_add in pop()
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (waiters_.load(std::memory_order_relaxed) > 0) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                cond_.notify_one();
+            }
+        }
+        return true;
+    }
+
+    // Any producer: waits while the queue is full. Items pushed after close() while full
+    // are discarded, so shutdown never hangs on a stalled consumer.
+    void push(const T& value) {
+        while (!try_push(value)) {
+            if (closed_.load(std::memory_order_acquire)) {
+                return;
+            }
+            std::this_thread::yield();
+        }
+    }
+
+    // Any consumer: next item, or std::nullopt if the queue is empty
+    std::optional<T> try_pop() {
+        uint64_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &cells_[pos & mask_];
+            uint64_t seq = cell->sequence.load(std::memory_order_acquire);
+            int64_t diff = static_cast<int64_t>(seq - (pos + 1));
+            if (diff == 0) {
+                if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return std::nullopt;  // Not filled yet
+            } else {
+                pos = dequeue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        std::optional<T> value(std::move(cell->value));
+        cell->sequence.store(pos + mask_ + 1, std::memory_order_release);
+        return value;
+    }
+
+    // Any consumer: block until an item arrives, or return std::nullopt once the queue
+    // is closed and drained
+    std::optional<T> pop() {
+        for (;;) {
+            if (std::optional<T> value = try_pop()) {
+                return value;
+            }
+            if (closed_.load(std::memory_order_acquire)) {
+                return try_pop();
+            }
+
+            // A producer that has not seen blocking_ yet may skip one notify;
+            // the wait timeout bounds that delay
+            blocking_.store(true, std::memory_order_relaxed);
+            std::unique_lock<std::mutex> lock(mutex_);
+            waiters_.fetch_add(1, std::memory_order_seq_cst);
+            cond_.wait_for(lock, std::chrono::milliseconds(1), [&] {
+                return !empty() || closed_.load(std::memory_order_acquire);
+            });
+            waiters_.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
+    // Approximate while producers or consumers are mid-operation
+    bool empty() const {
+        uint64_t pos = dequeue_pos_.load(std::memory_order_seq_cst);
+        const Cell& cell = cells_[pos & mask_];
+        return cell.sequence.load(std::memory_order_seq_cst) != pos + 1;
+    }
+
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closed_.store(true, std::memory_order_release);
+        }
+        cond_.notify_all();
+    }
+
+    bool is_closed() const {
+        return closed_.load(std::memory_order_acquire);
+    }
+
+    size_t capacity() const { return mask_ + 1; }
+
+private:
+    struct alignas(CACHE_LINE_SIZE) Cell {
+        std::atomic<uint64_t> sequence;
+        T value;
+    };
+
+    std::unique_ptr<Cell[]> cells_;
+    size_t mask_ = 0;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> enqueue_pos_{0};
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> dequeue_pos_{0};
+
+    alignas(CACHE_LINE_SIZE) std::atomic<int> waiters_{0};
+    std::atomic<bool> blocking_{false};  // Set once a consumer first blocks in pop()
+    std::atomic<bool> closed_{false};
+    std::mutex mutex_;
+    std::condition_variable cond_;
+};
@@ -0,0 +1,335 @@
+#include "core/pipeline_config.hpp"
+#include "core/coro_scheduler.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <iostream>
+#include <utility>
+
+static bool parse_run_mode(const std::string& name, RunMode& out) {
+    if (name == "threaded") out = RUN_THREADED;
+    else if (name == "inline") out = RUN_INLINE;
+    else if (name == "sharded") out = RUN_SHARDED;
+    else if (name == "coroutine") out = RUN_COROUTINE;
+    else return false;
+    return true;
+}
+
+static bool parse_wait_strategy(const std::string& name, WaitStrategy& out) {
+    if (name == "busy_spin") out = WAIT_BUSY_SPIN;
+    else if (name == "spin_yield") out = WAIT_SPIN_YIELD;
+    else if (name == "spin_park") out = WAIT_SPIN_PARK;
+    else if (name == "blocking") out = WAIT_BLOCKING;
+    else return false;
+    return true;
+}
+
+static bool parse_overflow_policy(const std::string& name, OverflowPolicy& out) {
+    if (name == "block") out = OVERFLOW_BLOCK;
+    else if (name == "drop_newest") out = OVERFLOW_DROP_NEWEST;
+    else if (name == "drop_oldest") out = OVERFLOW_DROP_OLDEST;
+    else if (name == "spill") out = OVERFLOW_SPILL;
+    else return false;
+    return true;
+}
+
+static bool parse_huge_pages(const std::string& name, HugePageMode& out) {
+    if (name == "none") out = HUGE_PAGES_NONE;
+    else if (name == "transparent") out = HUGE_PAGES_TRANSPARENT;
+    else if (name == "hugetlb") out = HUGE_PAGES_HUGETLB;
+    else return false;
+    return true;
+}
+
+static bool parse_bool(const std::string& text, bool& out) {
+    if (text == "1" || text == "true" || text == "on") out = true;
+    else if (text == "0" || text == "false" || text == "off") out = false;
+    else return false;
+    return true;
+}
+
+static bool parse_int(const std::string& text, int& out) {
+    char* end = nullptr;
+    errno = 0;
+    long value = std::strtol(text.c_str(), &end, 10);
+    if (text.empty() || *end != '\0' || errno == ERANGE || value < INT_MIN || value > INT_MAX) {
+        return false;
+    }
+    out = static_cast<int>(value);
+    return true;
+}
+
+static bool parse_size(const std::string& text, size_t& out) {
+    char* end = nullptr;
+    errno = 0;
+    unsigned long long value = std::strtoull(text.c_str(), &end, 10);
+    if (text.empty() || *end != '\0' || errno == ERANGE || value == 0) {
+        return false;
+    }
+    out = static_cast<size_t>(value);
+    return true;
+}
+
+static bool parse_thread_placement(const std::string& text, ThreadPlacement& out) {
+    ThreadPlacement placement = out;
+    size_t start = 0;
+    while (start <= text.size()) {
+        size_t end = text.find(',', start);
+        if (end == std::string::npos) end = text.size();
+        std::string item = text.substr(start, end - start);
+        start = end + 1;
+        if (item.empty()) continue;
+
+        size_t eq = item.find('=');
+        if (eq == std::string::npos) return false;
+        std::string key = item.substr(0, eq);
+        std::string value = item.substr(eq + 1);
+        if (key == "cpu") {
+            if (!parse_int(value, placement.cpu) || placement.cpu < -1) return false;
+        } else if (key == "fifo") {
+            if (!parse_int(value, placement.fifo_priority) ||
+                placement.fifo_priority < 0 || placement.fifo_priority > 99) return false;
+        } else if (key == "node") {
+            if (!parse_int(value, placement.numa_node) || placement.numa_node < -1) return false;
+        } else if (key == "name") {
+            if (value.empty()) return false;
+            placement.name = value;
+        } else {
+            return false;
+        }
+    }
+    out = placement;
+    return true;
+}
+
+// "BTCUSDT=2:5,ETHUSDT=2:4": price and quantity decimals per symbol, each at most
+// MAX_SYMBOL_DECIMALS so that realistic prices and quantities stay within MAX_FIXED_UNITS
+static bool parse_precision_table(const std::string& text, PrecisionTable& out) {
+    PrecisionTable table;
+    size_t start = 0;
+    while (start <= text.size()) {
+        size_t end = text.find(',', start);
+        if (end == std::string::npos) end = text.size();
+        std::string item = text.substr(start, end - start);
+        start = end + 1;
+        if (item.empty()) continue;
+
+        size_t eq = item.find('=');
+        size_t colon = item.find(':', eq);
+        if (eq == std::string::npos || eq == 0 || colon == std::string::npos) return false;
+        int price_decimals;
+        int quantity_decimals;
+        if (!parse_int(item.substr(eq + 1, colon - eq - 1), price_decimals) ||
+            !parse_int(item.substr(colon + 1), quantity_decimals) ||
+            price_decimals < 0 || price_decimals > static_cast<int>(MAX_SYMBOL_DECIMALS) ||
+            quantity_decimals < 0 || quantity_decimals > static_cast<int>(MAX_SYMBOL_DECIMALS)) {
+            return false;
+        }
+        // Upper case, as SymbolTable names symbols
+        std::string symbol = item.substr(0, eq);
+        std::transform(symbol.begin(), symbol.end(), symbol.begin(),
+                       [](unsigned char c) { return static_cast<char>(std::toupper(c)); });
+        table[symbol] = {static_cast<uint8_t>(price_decimals), static_cast<uint8_t>(quantity_decimals)};
+    }
+    out = std::move(table);
+    return true;
+}
+
+PipelineConfig load_pipeline_config() {
+    PipelineConfig config;
+
+    if (const char* value = std::getenv("BINANCE_RUN_MODE")) {
+        if (!parse_run_mode(value, config.run_mode)) {
+            std::cerr << "[Config] Unknown BINANCE_RUN_MODE '" << value
+                      << "', using threaded" << std::endl;
+        }
+        if (config.run_mode == RUN_COROUTINE && !BINANCE_COROUTINES) {
+            std::cerr << "[Config] BINANCE_RUN_MODE=coroutine needs a C++20 build, using threaded" << std::endl;
+            config.run_mode = RUN_THREADED;
+        }
+    }
+
+    if (const char* value = std::getenv("BINANCE_SYMBOLS")) {
+        std::vector<std::string> symbols;
+        std::string text = value;
+        size_t start = 0;
+        while (start <= text.size()) {
+            size_t end = text.find(',', start);
+            if (end == std::string::npos) end = text.size();
+            if (end > start) symbols.push_back(text.substr(start, end - start));
+            start = end + 1;
+        }
+        if (symbols.empty()) {
+            std::cerr << "[Config] Empty BINANCE_SYMBOLS, using " << DEFAULT_SYMBOL << std::endl;
+        } else {
+            config.symbols = symbols;
+        }
+    }
+
+    if (const char* value = std::getenv("BINANCE_PRECISION")) {
+        if (!parse_precision_table(value, config.symbol_precision)) {
+            std::cerr << "[Config] Invalid BINANCE_PRECISION '" << value
+                      << "', using 8 price and quantity decimals" << std::endl;
+        }
+    }
+
+    if (const char* value = std::getenv("BINANCE_WORKERS")) {
+        int workers;
+        if (parse_int(value, workers) && workers >= 0) {
+            config.worker_threads = static_cast<size_t>(workers);
+        } else {
+            std::cerr << "[Config] Invalid BINANCE_WORKERS '" << value
+                      << "', using one per core" << std::endl;
+        }
+    }
+
+    if (const char* value = std::getenv("BINANCE_WAIT_STRATEGY")) {
+        if (!parse_wait_strategy(value, config.wait_strategy)) {
+            std::cerr << "[Config] Unknown BINANCE_WAIT_STRATEGY '" << value
+                      << "', using spin_park" << std::endl;
+        }
+    }
+
+    if (const char* value = std::getenv("BINANCE_RING_CAPACITY")) {
+        if (!parse_size(value, config.ring_capacity)) {
+            std::cerr << "[Config] Invalid BINANCE_RING_CAPACITY '" << value
+                      << "', using " << config.ring_capacity << " bytes" << std::endl;
+        }
+    }
+
+    if (const char* value = std::getenv("BINANCE_RING_OVERFLOW")) {
+        if (!parse_overflow_policy(value, config.ring_overflow)) {
+            std::cerr << "[Config] Unknown BINANCE_RING_OVERFLOW '" << value
+                      << "', using drop_newest" << std::endl;
+        }
+    }
+
+    if (const char* value = std::getenv("BINANCE_RING_BLOCK_MS")) {
+        int block_ms;
+        if (parse_int(value, block_ms) && block_ms > 0) {
+            config.ring_block_ms = block_ms;
+        } else {
+            std::cerr << "[Config] Invalid BINANCE_RING_BLOCK_MS '" << value
+                      << "', using " << config.ring_block_ms << " ms" << std::endl;
+        }
+    }
+
+    if (const char* value = std::getenv("BINANCE_RING_SPILL_PATH")) {
+        config.ring_spill_path = value;
+    }
+
+    if (const char* value = std::getenv("BINANCE_RING_HUGE_PAGES")) {
+        if (!parse_huge_pages(value, config.ring_huge_pages)) {
+            std::cerr << "[Config] Unknown BINANCE_RING_HUGE_PAGES '" << value
+                      << "', using none" << std::endl;
+        }
+    }
+
+    if (const char* value = std::getenv("BINANCE_RING_MLOCK")) {
+        if (!parse_bool(value, config.ring_lock_memory)) {
+            std::cerr << "[Config] Invalid BINANCE_RING_MLOCK '" << value << "', using 0" << std::endl;
+        }
+    }
+
+    if (const char* value = std::getenv("BINANCE_RING_PREFAULT")) {
+        if (!parse_bool(value, config.ring_prefault)) {
+            std::cerr << "[Config] Invalid BINANCE_RING_PREFAULT '" << value << "', using 0" << std::endl;
+        }
+    }
+
+    if (const char* value = std::getenv("BINANCE_RING_NUMA_NODE")) {
+        if (!parse_int(value, config.ring_numa_node) || config.ring_numa_node < -1) {
+            config.ring_numa_node = -1;
+            std::cerr << "[Config] Invalid BINANCE_RING_NUMA_NODE '" << value
+                      << "', leaving ring placement to the kernel" << std::endl;
+        }
+    }
+
+    if (const char* value = std::getenv("BINANCE_JOURNAL_DIR")) {
+        config.journal_dir = value;
+    }
+
+    if (const char* value = std::getenv("BINANCE_JOURNAL_FILE_SIZE")) {
+        if (!parse_size(value, config.journal_file_size)) {
+            std::cerr << "[Config] Invalid BINANCE_JOURNAL_FILE_SIZE '" << value
+                      << "', using " << config.journal_file_size << " bytes" << std::endl;
+        }
+    }
+
+    if (const char* value = std::getenv("BINANCE_JOURNAL_FLUSH_MS")) {
+        int flush_ms;
+        if (parse_int(value, flush_ms) && flush_ms > 0) {
+            config.journal_flush_ms = flush_ms;
+        } else {
+            std::cerr << "[Config] Invalid BINANCE_JOURNAL_FLUSH_MS '" << value
+                      << "', using " << config.journal_flush_ms << " ms" << std::endl;
+        }
+    }
+
+    if (const char* value = std::getenv("BINANCE_MERGE_HOLD_MS")) {
+        int hold_ms;
+        if (parse_int(value, hold_ms) && hold_ms >= 0) {
+            config.merge_hold_ms = hold_ms;
+        } else {
+            std::cerr << "[Config] Invalid BINANCE_MERGE_HOLD_MS '" << value
+                      << "', using " << config.merge_hold_ms << " ms" << std::endl;
+        }
+    }
+
+    if (const char* value = std::getenv("BINANCE_TRACE")) {
+        if (!parse_bool(value, config.trace_latency)) {
+            std::cerr << "[Config] Invalid BINANCE_TRACE '" << value << "', using 0" << std::endl;
+        }
+    }
+
+    if (const char* value = std::getenv("BINANCE_TRACE_REPORT_MS")) {
+        int report_ms;
+        if (parse_int(value, report_ms) && report_ms >= 0) {
+            config.trace_report_ms = report_ms;
+        } else {
+            std::cerr << "[Config] Invalid BINANCE_TRACE_REPORT_MS '" << value
+                      << "', reporting only on SIGUSR1" << std::endl;
+        }
+    }
+
+    if (const char* value = std::getenv("BINANCE_ASYNC_LOG")) {
+        if (!parse_bool(value, config.async_log)) {
+            std::cerr << "[Config] Invalid BINANCE_ASYNC_LOG '" << value << "', using 1" << std::endl;
+        }
+    }
+
+    if (const char* value = std::getenv("BINANCE_LOG_LEVELS")) {
+        if (!parse_log_levels(value, config.log_levels)) {
+            std::cerr << "[Config] Invalid BINANCE_LOG_LEVELS '" << value << "', using info" << std::endl;
+        }
+    }
+
+    if (const char* value = std::getenv("BINANCE_LOG_RATE")) {
+        int rate;
+        if (parse_int(value, rate) && rate >= 0) {
+            config.log_rate = rate;
+        } else {
+            std::cerr << "[Config] Invalid BINANCE_LOG_RATE '" << value << "', not rate limiting" << std::endl;
+        }
+    }
+
+    const std::pair<const char*, ThreadPlacement*> placements[] = {
+        {"BINANCE_THREAD_WS", &config.ws_thread},
+        {"BINANCE_THREAD_CONSUMER", &config.consumer_thread},
+        {"BINANCE_THREAD_ICEBERG", &config.iceberg_thread},
+        {"BINANCE_THREAD_LIQUIDITY", &config.liquidity_thread},
+        {"BINANCE_THREAD_WORKERS", &config.worker_thread},
+    };
+    for (const auto& [variable, placement] : placements) {
+        if (const char* value = std::getenv(variable)) {
+            if (!parse_thread_placement(value, *placement)) {
+                std::cerr << "[Config] Invalid " << variable << " '" << value
+                          << "', leaving " << placement->name << " unplaced" << std::endl;
+            }
+        }
+    }
+
+    return config;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "io/mmap_buffer.hpp"
+#include "io/binance_connector.hpp"
+#include "core/thread_placement.hpp"
+#include "core/async_logger.hpp"
+#include "core/fixed_point.hpp"
+
+// How messages get from the network thread to the detectors
+enum RunMode {
+    RUN_THREADED,  // Feed ring, consumer thread and one thread per detector
+    RUN_INLINE,    // Everything on the network thread, inside the receive callback
+    RUN_SHARDED,   // Feed ring and consumer thread, then a worker pool sharded by symbol
+    RUN_COROUTINE  // Feed ring and consumer thread, then per-symbol detector coroutines on
+                   // a few executor threads; C++20 builds only
+};
+
+// Per-deployment pipeline settings.
+// Each field can be overridden by the BINANCE_* environment variable named next to it.
+struct PipelineConfig {
+    RunMode run_mode = RUN_THREADED;  // BINANCE_RUN_MODE: threaded|inline|sharded|coroutine
+    std::vector<std::string> symbols = {DEFAULT_SYMBOL};  // BINANCE_SYMBOLS: comma-separated, more than one needs sharded or coroutine
+    // BINANCE_PRECISION: price and quantity decimals per symbol, e.g. "BTCUSDT=2:5,ETHUSDT=2:4";
+    // the detectors key levels by integer ticks and lots at this precision. Unlisted symbols
+    // take the decimals of their exchangeInfo tickSize and stepSize, 8:8 if that fails.
+    // At most 8 decimals each; levels beyond MAX_FIXED_UNITS at that precision are skipped
+    // and counted, with a warning on the first.
+    PrecisionTable symbol_precision;
+    size_t worker_threads = 0;  // BINANCE_WORKERS: sharded pool or coroutine executor size, 0 for one per core up to one per symbol
+    WaitStrategy wait_strategy = WAIT_SPIN_PARK;  // BINANCE_WAIT_STRATEGY: busy_spin|spin_yield|spin_park|blocking
+    size_t ring_capacity = DEFAULT_FEED_RING_CAPACITY;  // BINANCE_RING_CAPACITY: bytes, rounded up to a power of two
+    OverflowPolicy ring_overflow = OVERFLOW_DROP_NEWEST;  // BINANCE_RING_OVERFLOW: block|drop_newest|drop_oldest|spill
+    int ring_block_ms = 1000;       // BINANCE_RING_BLOCK_MS: longest block waits for space before dropping a frame
+    std::string ring_spill_path = "binance_feed.spill";  // BINANCE_RING_SPILL_PATH
+    HugePageMode ring_huge_pages = HUGE_PAGES_NONE;  // BINANCE_RING_HUGE_PAGES: none|transparent|hugetlb
+    bool ring_lock_memory = false;  // BINANCE_RING_MLOCK: 0|1
+    bool ring_prefault = false;     // BINANCE_RING_PREFAULT: 0|1
+    int ring_numa_node = -1;        // BINANCE_RING_NUMA_NODE: node id, -1 for no binding
+    std::string journal_dir;        // BINANCE_JOURNAL_DIR: empty disables journaling
+    size_t journal_file_size = 256 << 20;  // BINANCE_JOURNAL_FILE_SIZE: bytes per journal file
+    int journal_flush_ms = 100;     // BINANCE_JOURNAL_FLUSH_MS: background sync interval
+    int merge_hold_ms = 150;        // BINANCE_MERGE_HOLD_MS: longest an event waits for the other stream, 0 for arrival order
+    bool trace_latency = false;     // BINANCE_TRACE: 0|1, stamp every message and keep per-stage latency histograms
+    int trace_report_ms = 0;        // BINANCE_TRACE_REPORT_MS: print the histograms this often, 0 for only on SIGUSR1
+    bool async_log = true;          // BINANCE_ASYNC_LOG: 0|1, format and write log output on a background thread
+    // BINANCE_LOG_LEVELS: debug|info|warn|error|off for every category, then per-category
+    // overrides, e.g. "info,consumer=warn,websocket=debug"
+    LogLevels log_levels = default_log_levels();
+    int log_rate = 0;               // BINANCE_LOG_RATE: records per second per thread and category, 0 for no limit
+
+    // BINANCE_THREAD_WS, _CONSUMER, _ICEBERG, _LIQUIDITY: comma-separated
+    // cpu=<core>,fifo=<1-99>,node=<numa node>,name=<thread name>, e.g. "cpu=3,fifo=80"
+    ThreadPlacement ws_thread{"bn-ws"};
+    ThreadPlacement consumer_thread{"bn-consumer"};
+    ThreadPlacement iceberg_thread{"bn-iceberg"};
+    ThreadPlacement liquidity_thread{"bn-liquidity"};
+    // BINANCE_THREAD_WORKERS: as above, for pool workers and coroutine executors; worker n
+    // is pinned to cpu + n
+    ThreadPlacement worker_thread{"bn-worker"};
+};
+
+// Defaults overridden by whatever is set in the environment.
+// Invalid values are reported on stderr and the default is kept.
+PipelineConfig load_pipeline_config();
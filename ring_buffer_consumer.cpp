@@ -1,139 +1,162 @@
 #include "io/mmap_buffer.hpp"
-#include "core/ts_queue.hpp"
+#include "io/ring_buffer_consumer.hpp"
+#include "core/handoff_queue.hpp"
+#include "core/broadcast_ring.hpp"
+#include "core/event_count.hpp"
 #include "core/serialization.hpp"
+#include "core/wire_format.hpp"
+#include "core/latency_trace.hpp"
+#include "core/async_logger.hpp"
 #include <atomic>
 #include <thread>
 #include <iostream>
-#include <iomanip>
 #include <cstring>
 #include <chrono>
-#include <sstream>
+#include <memory>
 
 // Import external variables
 extern std::atomic<bool> stop_flag;
-extern TSQueue<OrderBookUpdate> iceberg_queue;
-extern TSQueue<OrderBookUpdate> liquidity_queue;
-extern TSQueue<TradeMessageBinary> trade_queue;
+extern BroadcastRing<Traced<OrderBookUpdate>> orderbook_ring;
+extern HandoffQueue<Traced<TradeMessageBinary>> trade_queue;
+extern EventCount feed_event;
 
-// Use the same message type identifiers as in binance_connector.cpp
-enum MessageType : uint8_t {
-    TYPE_TRADE = 0x01,
-    TYPE_ORDERBOOK = 0x02
-};
+// Most frames handled per drain() before stop_flag is checked again
+constexpr size_t DRAIN_MAX_FRAMES = 1024;
 
-// Helper function to format timestamp
-std::string format_timestamp_consumer(uint64_t timestamp_ns) {
-    auto timestamp_ms = timestamp_ns / 1000000;
-    auto time_t_sec = timestamp_ms / 1000;
-    auto ms_part = timestamp_ms % 1000;
-    
-    std::time_t time = static_cast<std::time_t>(time_t_sec);
-    std::tm* tm_utc = std::gmtime(&time);
+// Decode one frame and hand it to handler if there is one, otherwise to the trade
+// queue or the order book ring
+static void process_frame(const RingFrame& frame, FeedHandler* handler) {
+    MessageType msg_type = static_cast<MessageType>(frame.type);
+    uint32_t msg_length = frame.size;
+    if (msg_length < FRAME_TRAILER_SIZE) {
+        log_event(LOG_CONSUMER, LOG_ERROR, 0, "[Consumer] Frame too short for its trailer: {} bytes", msg_length);
+        return;
+    }
+
+    // Producer stamps from the trailer, plus our own
+    FrameTrailer trailer = read_frame_trailer(frame.data, msg_length);
+    TraceStamps trace;
+    trace.received_ns = trailer.received_ns;
+    trace.parsed_ns = trailer.parsed_ns;
+    trace.committed_ns = trailer.committed_ns;
+    trace.dequeued_ns = trace_stamp();
     
-    std::stringstream ss;
-    ss << std::put_time(tm_utc, "%Y-%m-%d %H:%M:%S");
-    ss << "." << std::setfill('0') << std::setw(3) << ms_part;
-    return ss.str();
+    // Process based on message type
+    switch (msg_type) {
+        case TYPE_TRADE: {
+            if (msg_length == sizeof(TradeMessageBinary) + FRAME_TRAILER_SIZE) {
+                TradeMessageBinary trade = Serialization::deserialize_trade(
+                    frame.data, sizeof(TradeMessageBinary));
+                
+                // Hand to the worker pool, or push to trade queue for liquidity tracking
+                if (handler) {
+                    handler->on_trade(trailer.symbol, trade, trace);
+                } else {
+                    trade_queue.push({trade, trace});
+                }
+                
+                // Enhanced output with timestamp and dollar values, formatted off this thread
+                double trade_value_usd = trade.price * trade.quantity;
+                log_event(LOG_CONSUMER, LOG_INFO, trade.timestamp_ns,
+                          "[Consumer] Processed trade: {}, price: ${.2}, quantity: {.4}, value: ${.2}, side: {}",
+                          trade.trade_id, trade.price, trade.quantity, trade_value_usd,
+                          trade.is_buy() ? "BUY" : "SELL");
+            } else {
+                log_event(LOG_CONSUMER, LOG_ERROR, 0, "[Consumer] Invalid trade message size: {}", msg_length);
+            }
+            break;
+        }
+        
+        case TYPE_ORDERBOOK: {
+            try {
+                size_t book_length = msg_length - FRAME_TRAILER_SIZE;
+                if (handler) {
+                    // Consumer-thread scratch update, refilled in place for every frame
+                    static OrderBookUpdate book;
+                    deserialize_orderbook_into(frame.data, book_length, book);
+                    handler->on_orderbook(trailer.symbol, book, trace);
+                    break;
+                }
+
+                // Wait for the slowest detector to free a slot rather than drop the update
+                Traced<OrderBookUpdate>* slot = orderbook_ring.try_claim();
+                while (!slot && !stop_flag.load(std::memory_order_acquire)) {
+                    std::this_thread::yield();
+                    slot = orderbook_ring.try_claim();
+                }
+                if (!slot) {
+                    break;
+                }
+                
+                // Deserialize once into the shared slot; every detector reads it in place.
+                // The slot is recycled once the slowest detector has advanced past it,
+                // and refilling it reuses the level storage it already has.
+                deserialize_orderbook_into(frame.data, book_length, slot->message);
+                slot->trace = trace;
+                const OrderBookUpdate& book = slot->message;
+                orderbook_ring.publish();
+                
+                // Calculate total volume in USD for best bid/ask
+                double best_bid_value = 0.0;
+                double best_ask_value = 0.0;
+                
+                if (!book.bids.empty()) {
+                    best_bid_value = book.bids[0].price * book.bids[0].quantity;
+                }
+                if (!book.asks.empty()) {
+                    best_ask_value = book.asks[0].price * book.asks[0].quantity;
+                }
+                
+                log_event(LOG_CONSUMER, LOG_INFO, book.timestamp_ns,
+                          "[Consumer] Processed orderbook update: {}, bids: {}, asks: {}, "
+                          "best bid value: ${.2}, best ask value: ${.2}",
+                          book.last_update_id, book.bids.size(), book.asks.size(),
+                          best_bid_value, best_ask_value);
+            } catch (const std::exception& e) {
+                log_event(LOG_CONSUMER, LOG_ERROR, 0, "[Consumer] Error deserializing order book: {}", e.what());
+            }
+            break;
+        }
+        
+        default:
+            log_event(LOG_CONSUMER, LOG_ERROR, 0, "[Consumer] Unknown message type: {}", static_cast<int>(msg_type));
+            break;
+    }
 }
 
-void consume_ring_buffer() {
-    MMapBuffer buffer(4096, false); // Open existing buffer in read mode
+void consume_ring_buffer(WaitStrategy strategy, const RingOptions& local_options, FeedHandler* handler,
+                         const std::string& ring_name) {
+    // Attach to the ring the connector publishes into; it may not exist yet if we started first
+    std::unique_ptr<MMapBuffer> ring;
+    while (!ring && !stop_flag.load(std::memory_order_acquire)) {
+        try {
+            ring = MMapBuffer::attach(ring_name, true, local_options);
+        } catch (const std::exception&) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+    }
+    if (!ring) {
+        return;
+    }
+    MMapBuffer& buffer = *ring;
     
-    // Allocate a buffer large enough for any message type
-    constexpr size_t MAX_MESSAGE_SIZE = 8192; // Adjust based on expected order book size
-    std::vector<uint8_t> data_buffer(MAX_MESSAGE_SIZE);
+    // Space is only handed back to the producer at the end of a batch, so cap each
+    // batch at a quarter of the ring to let the producer refill while we work
+    const size_t batch_bytes = buffer.capacity() / 4;
     
     while (!stop_flag.load(std::memory_order_acquire)) {
-        // First, try to read the message header (type + length)
-        constexpr size_t HEADER_SIZE = 5;
-        size_t header_bytes_read = buffer.read(data_buffer.data(), HEADER_SIZE);
-        
-        if (header_bytes_read == HEADER_SIZE) {
-            MessageType msg_type = static_cast<MessageType>(data_buffer[0]);
-            uint32_t msg_length;
-            std::memcpy(&msg_length, data_buffer.data() + 1, sizeof(uint32_t));
-            
-            // Make sure our buffer is large enough
-            if (msg_length > data_buffer.size()) {
-                data_buffer.resize(msg_length);
-            }
-            
-            // Read the rest of the message
-            size_t body_bytes_read = buffer.read(data_buffer.data(), msg_length);
-            
-            if (body_bytes_read == msg_length) {
-                // Process based on message type
-                switch (msg_type) {
-                    case TYPE_TRADE: {
-                        if (msg_length == sizeof(TradeMessageBinary)) {
-                            TradeMessageBinary trade = Serialization::deserialize_trade(
-                                data_buffer.data(), msg_length);
-                            
-                            // Push to trade queue for liquidity tracking
-                            trade_queue.push(trade);
-                            
-                            // Enhanced output with timestamp and dollar values
-                            double trade_value_usd = trade.price * trade.quantity;
-                            std::cout << "[" << format_timestamp_consumer(trade.timestamp_ns) << "] "
-                                      << "[Consumer] Processed trade: " << trade.trade_id
-                                      << ", price: $" << std::fixed << std::setprecision(2) << trade.price
-                                      << ", quantity: " << std::setprecision(4) << trade.quantity
-                                      << ", value: $" << std::setprecision(2) << trade_value_usd
-                                      << ", side: " << (trade.is_buy() ? "BUY" : "SELL")
-                                      << std::endl;
-                        } else {
-                            std::cerr << "[Consumer] Invalid trade message size: " << msg_length << std::endl;
-                        }
-                        break;
-                    }
-                    
-                    case TYPE_ORDERBOOK: {
-                        try {
-                            OrderBookUpdate book = Serialization::deserialize_orderbook(
-                                data_buffer.data(), msg_length);
-                            
-                            // Push to both queues that need order book data
-                            iceberg_queue.push(book);
-                            liquidity_queue.push(book);
-                            
-                            // Calculate total volume in USD for best bid/ask
-                            double best_bid_value = 0.0;
-                            double best_ask_value = 0.0;
-                            
-                            if (!book.bids.empty()) {
-                                best_bid_value = book.bids[0].price * book.bids[0].quantity;
-                            }
-                            if (!book.asks.empty()) {
-                                best_ask_value = book.asks[0].price * book.asks[0].quantity;
-                            }
-                            
-                            std::cout << "[" << format_timestamp_consumer(book.timestamp_ns) << "] "
-                                      << "[Consumer] Processed orderbook update: " << book.last_update_id
-                                      << ", bids: " << book.bids.size()
-                                      << ", asks: " << book.asks.size()
-                                      << ", best bid value: $" << std::fixed << std::setprecision(2) << best_bid_value
-                                      << ", best ask value: $" << std::setprecision(2) << best_ask_value
-                                      << std::endl;
-                        } catch (const std::exception& e) {
-                            std::cerr << "[Consumer] Error deserializing order book: " << e.what() << std::endl;
-                        }
-                        break;
-                    }
-                    
-                    default:
-                        std::cerr << "[Consumer] Unknown message type: " << static_cast<int>(msg_type) << std::endl;
-                        break;
-                }
-            } else {
-                std::cerr << "[Consumer] Incomplete message body read: expected " << msg_length 
-                          << ", got " << body_bytes_read << std::endl;
-            }
-        } else if (header_bytes_read > 0) {
-            std::cerr << "[Consumer] Incomplete header read: " << header_bytes_read << " bytes" << std::endl;
+        // Take every whole frame (type + length + body) available, in place from the ring
+        size_t drained = buffer.drain(DRAIN_MAX_FRAMES, batch_bytes, [handler](const RingFrame& frame) {
+            process_frame(frame, handler);
+        });
+        if (drained > 0) {
+            // One wake-up per batch for threads waiting on both outputs
+            feed_event.notify();
+            continue;
         }
         
-        // Sleep a bit to avoid spinning unnecessarily
-        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        // Ring drained: wait for the producer, waking periodically to check stop_flag
+        buffer.wait_for_data(strategy, std::chrono::milliseconds(100));
     }
     
     std::cout << "[Consumer] Ring buffer consumer thread exiting" << std::endl;
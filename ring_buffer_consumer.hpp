@@ -1,4 +1,15 @@
 #pragma once
 
-// Function to consume data from the ring buffer and distribute to appropriate queues
-void consume_ring_buffer();
+#include "io/mmap_buffer.hpp"
+#include "io/binance_connector.hpp"
+#include <string>
+
+// Function to consume data from the ring buffer and distribute to appropriate queues.
+// Drains every available frame, then waits for more using the given strategy.
+// local_options sets mlock/prefault for the consumer's own mapping of the ring.
+// With a handler, every decoded message goes to it (tagged with its symbol) instead of
+// to trade_queue and orderbook_ring. Either way it carries its trace stamps, with the
+// dequeue stamped here. ring_name is the segment to attach to; tests and benchmarks
+// pass a private one so they never touch a live processor's ring.
+void consume_ring_buffer(WaitStrategy strategy, const RingOptions& local_options,
+                         FeedHandler* handler = nullptr, const std::string& ring_name = FEED_RING_NAME);
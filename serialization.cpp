@@ -1,4 +1,5 @@
 #include "core/serialization.hpp"
+#include "core/wire_format.hpp"
 #include <cstring>
 #include <stdexcept>
 #include <chrono>  // ✅ Add this for timestamps
@@ -64,16 +65,17 @@ TradeMessageBinary Serialization::deserialize_trade(const uint8_t* data, size_t
 
 // New functions for order book handling
 
-std::optional<OrderBookUpdate> Serialization::parse_orderbook_json(const std::string& json_str) {
+bool parse_orderbook_json_into(const std::string& json_str, OrderBookUpdate& update) {
     try {
         auto j = json::parse(json_str);
         
         // Check if this is a depth update
         if (!j.contains("e") || j["e"] != "depthUpdate") {
-            return std::nullopt;
+            return false;
         }
         
-        OrderBookUpdate update{};
+        update.bids.clear();
+        update.asks.clear();
         
         // Set timestamps - both event time and local time
         uint64_t event_time = (j.contains("E") && !j["E"].is_null()) ? j["E"].get<uint64_t>() : 0;
@@ -93,8 +95,8 @@ std::optional<OrderBookUpdate> Serialization::parse_orderbook_json(const std::st
         if (j.contains("b") && j["b"].is_array()) {
             for (const auto& bid : j["b"]) {
                 if (bid.is_array() && bid.size() >= 2) {
-                    double price = std::stod(bid[0].get<std::string>());
-                    double quantity = std::stod(bid[1].get<std::string>());
+                    double price = std::stod(bid[0].get_ref<const std::string&>());
+                    double quantity = std::stod(bid[1].get_ref<const std::string&>());
                     
                     // Quantity of 0 means remove this price level - don't include it
                     if (quantity > 0) {
@@ -108,8 +110,8 @@ std::optional<OrderBookUpdate> Serialization::parse_orderbook_json(const std::st
         if (j.contains("a") && j["a"].is_array()) {
             for (const auto& ask : j["a"]) {
                 if (ask.is_array() && ask.size() >= 2) {
-                    double price = std::stod(ask[0].get<std::string>());
-                    double quantity = std::stod(ask[1].get<std::string>());
+                    double price = std::stod(ask[0].get_ref<const std::string&>());
+                    double quantity = std::stod(ask[1].get_ref<const std::string&>());
                     
                     // Quantity of 0 means remove this price level - don't include it
                     if (quantity > 0) {
@@ -119,21 +121,29 @@ std::optional<OrderBookUpdate> Serialization::parse_orderbook_json(const std::st
             }
         }
         
-        return update;
+        return true;
     } catch (const std::exception& e) {
         std::cerr << "[Error] Failed to parse orderbook: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+std::optional<OrderBookUpdate> Serialization::parse_orderbook_json(const std::string& json_str) {
+    OrderBookUpdate update{};
+    if (!parse_orderbook_json_into(json_str, update)) {
         return std::nullopt;
     }
+    return update;
 }
 
-std::vector<uint8_t> Serialization::serialize_orderbook(const OrderBookUpdate& book) {
-    // Calculate buffer size: header + all price levels
-    size_t bid_size = book.bids.size() * sizeof(PriceLevel);
-    size_t ask_size = book.asks.size() * sizeof(PriceLevel);
-    size_t header_size = sizeof(uint64_t) * 2 + sizeof(uint32_t) * 2; // timestamp, last_update_id, bid_count, ask_count
-    
-    std::vector<uint8_t> buffer(header_size + bid_size + ask_size);
-    uint8_t* ptr = buffer.data();
+size_t orderbook_wire_size(const OrderBookUpdate& book) {
+    // header: timestamp, last_update_id, bid_count, ask_count
+    size_t header_size = sizeof(uint64_t) * 2 + sizeof(uint32_t) * 2;
+    return header_size + (book.bids.size() + book.asks.size()) * sizeof(PriceLevel);
+}
+
+void serialize_orderbook_into(const OrderBookUpdate& book, uint8_t* out) {
+    uint8_t* ptr = out;
     
     // Write header
     std::memcpy(ptr, &book.timestamp_ns, sizeof(uint64_t));
@@ -161,16 +171,51 @@ std::vector<uint8_t> Serialization::serialize_orderbook(const OrderBookUpdate& b
         std::memcpy(ptr, &ask, sizeof(PriceLevel));
         ptr += sizeof(PriceLevel);
     }
-    
+}
+
+void write_frame_trailer(uint8_t* body, size_t message_size, const FrameTrailer& trailer) {
+    uint8_t* ptr = body + message_size;
+    std::memcpy(ptr, &trailer.symbol, sizeof(SymbolId));
+    ptr += sizeof(SymbolId);
+    std::memcpy(ptr, &trailer.received_ns, sizeof(uint64_t));
+    ptr += sizeof(uint64_t);
+    std::memcpy(ptr, &trailer.parsed_ns, sizeof(uint64_t));
+    ptr += sizeof(uint64_t);
+    std::memcpy(ptr, &trailer.committed_ns, sizeof(uint64_t));
+}
+
+FrameTrailer read_frame_trailer(const uint8_t* body, size_t body_size) {
+    FrameTrailer trailer;
+    const uint8_t* ptr = body + body_size - FRAME_TRAILER_SIZE;
+    std::memcpy(&trailer.symbol, ptr, sizeof(SymbolId));
+    ptr += sizeof(SymbolId);
+    std::memcpy(&trailer.received_ns, ptr, sizeof(uint64_t));
+    ptr += sizeof(uint64_t);
+    std::memcpy(&trailer.parsed_ns, ptr, sizeof(uint64_t));
+    ptr += sizeof(uint64_t);
+    std::memcpy(&trailer.committed_ns, ptr, sizeof(uint64_t));
+    return trailer;
+}
+
+std::vector<uint8_t> Serialization::serialize_orderbook(const OrderBookUpdate& book) {
+    std::vector<uint8_t> buffer(orderbook_wire_size(book));
+    serialize_orderbook_into(book, buffer.data());
     return buffer;
 }
 
-OrderBookUpdate Serialization::deserialize_orderbook(const uint8_t* data, size_t size) {
+void reserve_levels(std::vector<PriceLevel>& levels, size_t count) {
+    if (levels.capacity() < count) {
+        size_t rounded = 1;
+        while (rounded < count) rounded <<= 1;
+        levels.reserve(rounded);
+    }
+}
+
+void deserialize_orderbook_into(const uint8_t* data, size_t size, OrderBookUpdate& book) {
     if (size < sizeof(uint64_t) * 2 + sizeof(uint32_t) * 2) {
         throw std::runtime_error("Buffer too small for OrderBookUpdate header");
     }
     
-    OrderBookUpdate book;
     const uint8_t* ptr = data;
     
     // Read header
@@ -195,7 +240,8 @@ OrderBookUpdate Serialization::deserialize_orderbook(const uint8_t* data, size_t
         throw std::runtime_error("Buffer too small for OrderBookUpdate data");
     }
     
-    // Read bids
+    // Read bids; a reused update keeps the capacity it already has
+    reserve_levels(book.bids, bid_count);
     book.bids.resize(bid_count);
     for (uint32_t i = 0; i < bid_count; ++i) {
         std::memcpy(&book.bids[i], ptr, sizeof(PriceLevel));
@@ -203,11 +249,16 @@ OrderBookUpdate Serialization::deserialize_orderbook(const uint8_t* data, size_t
     }
     
     // Read asks
+    reserve_levels(book.asks, ask_count);
     book.asks.resize(ask_count);
     for (uint32_t i = 0; i < ask_count; ++i) {
         std::memcpy(&book.asks[i], ptr, sizeof(PriceLevel));
         ptr += sizeof(PriceLevel);
     }
-    
+}
+
+OrderBookUpdate Serialization::deserialize_orderbook(const uint8_t* data, size_t size) {
+    OrderBookUpdate book;
+    deserialize_orderbook_into(data, size, book);
     return book;
 }
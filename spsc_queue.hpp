@@ -0,0 +1,176 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+// Bounded lock-free single-producer/single-consumer queue with the TSQueue interface.
+//
+// head_ and tail_ are monotonically increasing counters on separate cache lines, and
+// each side keeps a cached copy of the other's counter so the shared line is only read
+// when the queue looks full (producer) or empty (consumer). A hop costs two relaxed
+// loads and a release store. The mutex and condition variable are only touched when
+// the consumer blocks in pop(); until a consumer first blocks, push() skips even the
+// fence needed to check for waiters.
+template <typename T>
+class SPSCQueue {
+public:
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+    static constexpr size_t DEFAULT_CAPACITY = 65536;
+
+    explicit SPSCQueue(size_t capacity = DEFAULT_CAPACITY) {
+        size_t rounded = 1;
+        while (rounded < capacity) rounded <<= 1;
+        slots_.resize(rounded);
+        mask_ = rounded - 1;
+    }
+
+    SPSCQueue(const SPSCQueue&) = delete;
+    SPSCQueue& operator=(const SPSCQueue&) = delete;
+
+    // Producer: false if the queue is full
+    bool try_push(const T& value) {
+        T* slot = try_claim();
+        if (!slot) {
+            return false;
+        }
+        *slot = value;
+        publish();
+        return true;
+    }
+
+    // Producer: waits for the consumer while the queue is full. Items pushed after
+    // close() while full are discarded, so shutdown never hangs on a stalled consumer.
+    void push(const T& value) {
+        while (!try_push(value)) {
+            if (closed_.load(std::memory_order_acquire)) {
+                return;
+            }
+            std::this_thread::yield();
+        }
+    }
+
+    // Producer: slot for the next item, or nullptr if the queue is full. As with
+    // BroadcastRing, the slot keeps whatever it held last time, so containers in T
+    // can be refilled without reallocating. Nothing is visible until publish().
+    T* try_claim() {
+        uint64_t head = head_.load(std::memory_order_relaxed);
+        if (head - producer_.cached_tail > mask_) {
+            producer_.cached_tail = tail_.load(std::memory_order_acquire);
+            if (head - producer_.cached_tail > mask_) {
+                return nullptr;
+            }
+        }
+        return &slots_[head & mask_];
+    }
+
+    void publish() {
+        head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        if (blocking_.load(std::memory_order_relaxed)) {
+            // Order the head store before the waiter check; pairs with the fetch_add in pop()
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (waiters_.load(std::memory_order_relaxed) > 0) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                cond_.notify_one();
+            }
+        }
+    }
+
+    // Consumer: next item read in place, or nullptr if the queue is empty. The item
+    // stays valid, and keeps its storage for the producer to reuse, until advance().
+    T* peek() {
+        uint64_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail == consumer_.cached_head) {
+            consumer_.cached_head = head_.load(std::memory_order_acquire);
+            if (tail == consumer_.cached_head) {
+                return nullptr;
+            }
+        }
+        return &slots_[tail & mask_];
+    }
+
+    void advance() {
+        tail_.store(tail_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // Consumer: next item, or std::nullopt if the queue is empty
+    std::optional<T> try_pop() {
+        T* slot = peek();
+        if (!slot) {
+            return std::nullopt;
+        }
+        std::optional<T> value(std::move(*slot));
+        advance();
+        return value;
+    }
+
+    // Consumer: block until an item arrives, or return std::nullopt once the queue is
+    // closed and drained
+    std::optional<T> pop() {
+        for (;;) {
+            if (std::optional<T> value = try_pop()) {
+                return value;
+            }
+            if (closed_.load(std::memory_order_acquire)) {
+                return try_pop();
+            }
+
+            // A producer that has not seen blocking_ yet may skip one notify;
+            // the wait timeout bounds that delay
+            blocking_.store(true, std::memory_order_relaxed);
+            std::unique_lock<std::mutex> lock(mutex_);
+            waiters_.fetch_add(1, std::memory_order_seq_cst);
+            uint64_t tail = tail_.load(std::memory_order_relaxed);
+            cond_.wait_for(lock, std::chrono::milliseconds(1), [&] {
+                return head_.load(std::memory_order_seq_cst) != tail ||
+                       closed_.load(std::memory_order_acquire);
+            });
+            waiters_.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
+    bool empty() const {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closed_.store(true, std::memory_order_release);
+        }
+        cond_.notify_all();
+    }
+
+    bool is_closed() const {
+        return closed_.load(std::memory_order_acquire);
+    }
+
+    size_t capacity() const { return slots_.size(); }
+
+private:
+    std::vector<T> slots_;
+    size_t mask_ = 0;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> head_{0};  // Next slot to fill
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> tail_{0};  // Next slot to drain
+
+    struct alignas(CACHE_LINE_SIZE) ProducerState {
+        uint64_t cached_tail = 0;
+    } producer_;
+
+    struct alignas(CACHE_LINE_SIZE) ConsumerState {
+        uint64_t cached_head = 0;
+    } consumer_;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<int> waiters_{0};
+    std::atomic<bool> blocking_{false};  // Set once the consumer first blocks in pop()
+    std::atomic<bool> closed_{false};
+    std::mutex mutex_;
+    std::condition_variable cond_;
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "core/wire_format.hpp"
+
+// Fixed list of traded symbols, numbered in configuration order. The connector, the
+// ring consumer and the worker pool each build one from the same list, so a SymbolId
+// means the same pair everywhere. Names are kept upper case, as Binance reports them
+// in the "s" field.
+class SymbolTable {
+public:
+    explicit SymbolTable(const std::vector<std::string>& symbols) {
+        if (symbols.empty()) {
+            throw std::runtime_error("SymbolTable needs at least one symbol");
+        }
+        if (symbols.size() > static_cast<size_t>(std::numeric_limits<SymbolId>::max()) + 1) {
+            throw std::runtime_error("Too many symbols for a SymbolId");
+        }
+        // ids_ keys view names_, so names_ must never reallocate
+        names_.reserve(symbols.size());
+        for (const std::string& symbol : symbols) {
+            std::string name = symbol;
+            std::transform(name.begin(), name.end(), name.begin(),
+                           [](unsigned char c) { return static_cast<char>(std::toupper(c)); });
+            if (ids_.count(name)) {
+                throw std::runtime_error("Duplicate symbol " + name);
+            }
+            names_.push_back(name);
+            ids_.emplace(names_.back(), static_cast<SymbolId>(names_.size() - 1));
+        }
+    }
+
+    SymbolTable(const SymbolTable&) = delete;
+    SymbolTable& operator=(const SymbolTable&) = delete;
+
+    // Id of an upper-case symbol name, or std::nullopt if it was not configured
+    std::optional<SymbolId> find(std::string_view name) const {
+        auto it = ids_.find(name);
+        if (it == ids_.end()) {
+            return std::nullopt;
+        }
+        return it->second;
+    }
+
+    const std::string& name(SymbolId id) const { return names_.at(id); }
+    size_t size() const { return names_.size(); }
+
+private:
+    std::vector<std::string> names_;
+    std::unordered_map<std::string_view, SymbolId> ids_;
+};
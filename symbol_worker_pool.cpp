@@ -0,0 +1,276 @@
+#include "features/symbol_worker_pool.hpp"
+#include "core/symbol_table.hpp"
+#include "core/wire_format.hpp"
+#include "core/async_logger.hpp"
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+// How long an idle worker sleeps before re-checking for shutdown
+constexpr auto WORKER_IDLE_WAIT = std::chrono::milliseconds(100);
+
+SymbolWorkerPool::Shard::Shard(const std::string& name, const SymbolPrecision& precision,
+                               std::unique_ptr<LiquidityTracker> tracker, size_t home)
+    : iceberg(name, precision),
+      liquidity(std::move(tracker)),
+      pipeline(iceberg, *liquidity),
+      inbox(SHARD_INBOX_CAPACITY),
+      books(SHARD_BOOK_CAPACITY),
+      owner(home) {}
+
+SymbolWorkerPool::SymbolWorkerPool(const std::vector<std::string>& symbols, size_t workers,
+                                   const TrackerFactory& make_tracker, const PrecisionTable& precision,
+                                   const ThreadPlacement& placement)
+    : placement_(placement) {
+    if (workers == 0) {
+        throw std::runtime_error("SymbolWorkerPool needs at least one worker");
+    }
+    SymbolTable table(symbols);
+    for (size_t i = 0; i < workers; ++i) {
+        workers_.push_back(std::make_unique<Worker>(table.size()));
+    }
+
+    // Symbols start spread round-robin; stealing rebalances them from there
+    for (size_t i = 0; i < table.size(); ++i) {
+        const std::string& name = table.name(static_cast<SymbolId>(i));
+        shards_.push_back(std::make_unique<Shard>(name, precision_for(precision, name), make_tracker(name),
+                                                  i % workers));
+    }
+}
+
+SymbolWorkerPool::~SymbolWorkerPool() {
+    stop();
+}
+
+void SymbolWorkerPool::start() {
+    stopping_.store(false, std::memory_order_release);
+    for (size_t i = 0; i < workers_.size(); ++i) {
+        workers_[i]->thread = std::thread([this, i]() {
+            ThreadPlacement placement = placement_;
+            placement.name += "-" + std::to_string(i);
+            if (placement.cpu >= 0) {
+                placement.cpu += static_cast<int>(i);
+            }
+            apply_thread_placement(placement);
+            worker_loop(i);
+        });
+    }
+}
+
+void SymbolWorkerPool::stop() {
+    stopping_.store(true, std::memory_order_release);
+    wakeup_.notify();
+    for (auto& worker : workers_) {
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+        }
+    }
+}
+
+void SymbolWorkerPool::on_trade(SymbolId symbol, const TradeMessageBinary& trade, const TraceStamps& trace) {
+    ShardMessage* message = claim(symbol);
+    if (!message) {
+        return;
+    }
+    message->type = TYPE_TRADE;
+    message->trade = trade;
+    message->trace = trace;
+    dispatch(symbol);
+}
+
+void SymbolWorkerPool::on_orderbook(SymbolId symbol, const OrderBookUpdate& book, const TraceStamps& trace) {
+    ShardMessage* message = claim(symbol);
+    if (!message) {
+        return;
+    }
+    Shard& shard = *shards_[symbol];
+
+    // Refill a recycled book slot's levels in place, published ahead of the message
+    // that refers to it. A slot that has to grow goes straight to the deepest book
+    // this symbol has had rather than to this one.
+    OrderBookUpdate& slot = *wait_for_slot(shard.books);
+    slot.timestamp_ns = book.timestamp_ns;
+    slot.last_update_id = book.last_update_id;
+    shard.max_levels = std::max({shard.max_levels, book.bids.size(), book.asks.size()});
+    if (slot.bids.capacity() < book.bids.size()) {
+        reserve_levels(slot.bids, shard.max_levels);
+    }
+    slot.bids.assign(book.bids.begin(), book.bids.end());
+    if (slot.asks.capacity() < book.asks.size()) {
+        reserve_levels(slot.asks, shard.max_levels);
+    }
+    slot.asks.assign(book.asks.begin(), book.asks.end());
+    shard.books.publish();
+
+    message->type = TYPE_ORDERBOOK;
+    message->trace = trace;
+    dispatch(symbol);
+}
+
+std::vector<SymbolWorkerPool::WorkerStats> SymbolWorkerPool::worker_stats() const {
+    std::vector<WorkerStats> stats;
+    for (const auto& worker : workers_) {
+        stats.push_back({worker->messages.load(std::memory_order_relaxed),
+                         worker->steals.load(std::memory_order_relaxed)});
+    }
+    return stats;
+}
+
+// Inbox slot to fill for symbol, waiting while the inbox is full; nullptr if the
+// symbol is unknown
+SymbolWorkerPool::ShardMessage* SymbolWorkerPool::claim(SymbolId symbol) {
+    if (symbol >= shards_.size()) {
+        log_event(LOG_CONSUMER, LOG_WARN, 0, "[Workers] Message for unknown symbol id {}", symbol);
+        return nullptr;
+    }
+    return wait_for_slot(shards_[symbol]->inbox);
+}
+
+template <typename T>
+T* SymbolWorkerPool::wait_for_slot(SPSCQueue<T>& queue) {
+    for (;;) {
+        if (T* slot = queue.try_claim()) {
+            return slot;
+        }
+        std::this_thread::yield();
+    }
+}
+
+void SymbolWorkerPool::dispatch(SymbolId symbol) {
+    Shard& shard = *shards_[symbol];
+    shard.inbox.publish();
+
+    // Order the publish before reading scheduled; pairs with the fence in run_shard()
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!shard.scheduled.exchange(true, std::memory_order_acq_rel)) {
+        enqueue(shard.owner.load(std::memory_order_relaxed), &shard);
+    }
+}
+
+void SymbolWorkerPool::enqueue(size_t worker, Shard* shard) {
+    Worker& target = *workers_[worker];
+    {
+        std::lock_guard<std::mutex> lock(target.mutex);
+        target.run_queue.push_back(shard);
+        target.queued.store(target.run_queue.size(), std::memory_order_release);
+    }
+    // Wakes the owner, and any idle worker that may steal it
+    wakeup_.notify();
+}
+
+SymbolWorkerPool::Shard* SymbolWorkerPool::take(size_t worker) {
+    Worker& self = *workers_[worker];
+    if (self.queued.load(std::memory_order_acquire) == 0) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(self.mutex);
+    if (self.run_queue.empty()) {
+        return nullptr;
+    }
+    Shard* shard = self.run_queue.pop_front();
+    self.queued.store(self.run_queue.size(), std::memory_order_release);
+    return shard;
+}
+
+// Take the most recently queued shard of the busiest other worker. Only the back
+// is taken, so the victim keeps the shards it is about to run.
+SymbolWorkerPool::Shard* SymbolWorkerPool::steal(size_t thief) {
+    size_t victim = thief;
+    size_t longest = STEAL_MIN_QUEUED - 1;
+    for (size_t i = 0; i < workers_.size(); ++i) {
+        size_t queued = workers_[i]->queued.load(std::memory_order_acquire);
+        if (i != thief && queued > longest) {
+            victim = i;
+            longest = queued;
+        }
+    }
+    if (victim == thief) {
+        return nullptr;
+    }
+
+    Worker& target = *workers_[victim];
+    std::lock_guard<std::mutex> lock(target.mutex);
+    if (target.run_queue.empty()) {
+        return nullptr;
+    }
+    Shard* shard = target.run_queue.pop_back();
+    target.queued.store(target.run_queue.size(), std::memory_order_release);
+    workers_[thief]->steals.fetch_add(1, std::memory_order_relaxed);
+    return shard;
+}
+
+void SymbolWorkerPool::run_shard(size_t worker, Shard& shard) {
+    // Whoever runs a shard owns it from now on, so a stolen symbol stays with its thief
+    shard.owner.store(worker, std::memory_order_relaxed);
+
+    size_t processed = 0;
+    while (processed < SHARD_BATCH) {
+        // Read in place: the slot, and the level capacity of its book, go back to the feeder
+        const ShardMessage* message = shard.inbox.peek();
+        if (!message) {
+            break;
+        }
+        if (message->type == TYPE_TRADE) {
+            shard.pipeline.on_trade(0, message->trade, message->trace);
+        } else {
+            shard.pipeline.on_orderbook(0, *shard.books.peek(), message->trace);
+            shard.books.advance();
+        }
+        shard.inbox.advance();
+        ++processed;
+    }
+    workers_[worker]->messages.fetch_add(processed, std::memory_order_relaxed);
+
+    if (!shard.inbox.empty()) {
+        // Batch used up: back of the queue, behind the other symbols waiting here
+        enqueue(worker, &shard);
+        return;
+    }
+
+    // Drained: unschedule, then catch a message published after the last peek() whose
+    // feeder still saw the shard as scheduled. The store releases this worker's inbox,
+    // detector and tracker state to whichever worker the next dispatch() hands the
+    // shard to; seq_cst keeps it ordered against the fence below as well.
+    shard.scheduled.store(false, std::memory_order_seq_cst);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!shard.inbox.empty() && !shard.scheduled.exchange(true, std::memory_order_acq_rel)) {
+        enqueue(worker, &shard);
+    }
+}
+
+bool SymbolWorkerPool::any_queued() const {
+    for (const auto& worker : workers_) {
+        if (worker->queued.load(std::memory_order_acquire) > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void SymbolWorkerPool::worker_loop(size_t worker) {
+    for (;;) {
+        Shard* shard = take(worker);
+        if (!shard) {
+            shard = steal(worker);
+        }
+        if (shard) {
+            run_shard(worker, *shard);
+            continue;
+        }
+
+        // Queued shards always sit on some run queue, so once stopping with every
+        // queue empty, all messages fed before stop() have been handled
+        if (stopping_.load(std::memory_order_acquire) && !any_queued()) {
+            break;
+        }
+
+        uint64_t key = wakeup_.prepare_wait();
+        if (any_queued() || stopping_.load(std::memory_order_acquire)) {
+            wakeup_.cancel_wait();
+            continue;
+        }
+        wakeup_.wait(key, WORKER_IDLE_WAIT);
+    }
+}
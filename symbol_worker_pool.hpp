@@ -0,0 +1,149 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "io/binance_connector.hpp"
+#include "core/event_count.hpp"
+#include "core/spsc_queue.hpp"
+#include "core/thread_placement.hpp"
+#include "features/IcebergDetector.hpp"
+#include "features/inline_pipeline.hpp"
+#include "features/liquidity_tracker.hpp"
+
+// Messages queued per symbol before the feeding thread waits for its worker
+constexpr size_t SHARD_INBOX_CAPACITY = 1024;
+
+// Order book updates queued per symbol. Books live in their own ring rather than in
+// every inbox slot, so a symbol holds this many deep books, not one per message.
+constexpr size_t SHARD_BOOK_CAPACITY = 64;
+
+// Messages a worker handles for one symbol before giving the next symbol on its queue a turn
+constexpr size_t SHARD_BATCH = 256;
+
+// A worker counts as overloaded, and open to stealing, with this many symbols queued
+// behind the one it is running. Stealing a lone queued symbol would bounce its state
+// between cores for little gain.
+constexpr size_t STEAL_MIN_QUEUED = 2;
+
+// Runs the analytics of many symbols on a fixed pool of worker threads.
+//
+// Every symbol is a shard: its IcebergDetector, its LiquidityTracker and an inbox of
+// pending messages. A shard belongs to one worker at a time, so its state stays in
+// that core's cache and needs no locking. When the feeding thread queues a message
+// for an idle shard, the shard goes on its owner's run queue; the owner works through
+// its queue a batch at a time. A worker with nothing queued steals the shard at the
+// back of the longest queue, if that worker is overloaded, and becomes its owner, so
+// a burst on a few symbols spreads over the idle cores instead of piling up behind one.
+class SymbolWorkerPool : public FeedHandler {
+public:
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+
+    using TrackerFactory = std::function<std::unique_ptr<LiquidityTracker>(const std::string& symbol)>;
+
+    struct WorkerStats {
+        uint64_t messages;  // Messages processed
+        uint64_t steals;    // Shards taken from another worker's queue
+    };
+
+    // Shard i tracks symbols[i], matching the connector's SymbolIds, at its precision
+    // from the table. Worker n runs with placement, named "<name>-n" and pinned to
+    // placement.cpu + n when a cpu is set.
+    SymbolWorkerPool(const std::vector<std::string>& symbols, size_t workers,
+                     const TrackerFactory& make_tracker, const PrecisionTable& precision,
+                     const ThreadPlacement& placement);
+    ~SymbolWorkerPool();
+
+    SymbolWorkerPool(const SymbolWorkerPool&) = delete;
+    SymbolWorkerPool& operator=(const SymbolWorkerPool&) = delete;
+
+    void start();
+    // Finish every queued message, then join the workers. Call after the feeding thread stopped.
+    void stop();
+
+    // Feeding thread only (the ring consumer); waits while the symbol's inbox is full
+    void on_trade(SymbolId symbol, const TradeMessageBinary& trade, const TraceStamps& trace) override;
+    void on_orderbook(SymbolId symbol, const OrderBookUpdate& book, const TraceStamps& trace) override;
+
+    size_t worker_count() const { return workers_.size(); }
+    std::vector<WorkerStats> worker_stats() const;
+
+private:
+    // An order book message's levels are the next entry of the shard's book ring
+    struct ShardMessage {
+        MessageType type = TYPE_TRADE;
+        TradeMessageBinary trade{};
+        TraceStamps trace;
+    };
+
+    struct alignas(CACHE_LINE_SIZE) Shard {
+        Shard(const std::string& name, const SymbolPrecision& precision,
+              std::unique_ptr<LiquidityTracker> tracker, size_t home);
+
+        IcebergDetector iceberg;
+        std::unique_ptr<LiquidityTracker> liquidity;
+        InlinePipeline pipeline;  // Runs both detectors on one message
+        SPSCQueue<ShardMessage> inbox;
+        SPSCQueue<OrderBookUpdate> books;      // Read in step with the inbox's book messages
+        size_t max_levels = 0;                 // Deepest book side fed so far; feeding thread only
+        std::atomic<size_t> owner;             // Worker whose run queue the shard goes on
+        std::atomic<bool> scheduled{false};    // On a run queue or being run
+    };
+
+    // Fixed ring of shards waiting for a worker. A shard is on at most one run queue
+    // at a time, so room for every shard means it never fills and never allocates.
+    class RunQueue {
+    public:
+        explicit RunQueue(size_t capacity) : slots_(capacity) {}
+
+        bool empty() const { return count_ == 0; }
+        size_t size() const { return count_; }
+        void push_back(Shard* shard) { slots_[(head_ + count_++) % slots_.size()] = shard; }
+        Shard* pop_front() {
+            Shard* shard = slots_[head_];
+            head_ = (head_ + 1) % slots_.size();
+            --count_;
+            return shard;
+        }
+        Shard* pop_back() { return slots_[(head_ + --count_) % slots_.size()]; }
+
+    private:
+        std::vector<Shard*> slots_;
+        size_t head_ = 0;
+        size_t count_ = 0;
+    };
+
+    struct Worker {
+        explicit Worker(size_t shards) : run_queue(shards) {}
+
+        std::mutex mutex;
+        RunQueue run_queue;
+        std::atomic<size_t> queued{0};  // run_queue.size(), readable without the lock
+        std::atomic<uint64_t> messages{0};
+        std::atomic<uint64_t> steals{0};
+        std::thread thread;
+    };
+
+    ShardMessage* claim(SymbolId symbol);
+    template <typename T>
+    static T* wait_for_slot(SPSCQueue<T>& queue);
+    void dispatch(SymbolId symbol);
+    void enqueue(size_t worker, Shard* shard);
+    Shard* take(size_t worker);
+    Shard* steal(size_t thief);
+    void run_shard(size_t worker, Shard& shard);
+    void worker_loop(size_t worker);
+    bool any_queued() const;
+
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+    ThreadPlacement placement_;
+    EventCount wakeup_;
+    std::atomic<bool> stopping_{false};
+};
@@ -0,0 +1,274 @@
+// Heap allocations per message once the pipeline has warmed up; the steady state
+// should make none.
+//
+// Replaces global operator new with a counting one, feeds a warm-up run that grows
+// every recycled buffer to its working size, then counts the allocations made while
+// a second run goes through. Book prices drift a tick per update, so the iceberg
+// detector and the liquidity tracker keep seeing new levels in the measured run.
+//
+//   allocation_test inline     InlinePipeline called directly
+//   allocation_test threaded   ring -> consumer -> orderbook_ring/trade_queue ->
+//                              iceberg thread and LiquidityFeed, as main.cpp runs it
+//   allocation_test sharded    ring -> consumer -> SymbolWorkerPool
+//
+// Links against every translation unit except main.cpp, binance_connector.cpp,
+// exchange_info.cpp and binance_orderbook_w1.cpp. Exits non-zero if anything allocated.
+
+#include "features/IcebergDetector.hpp"
+#include "features/inline_pipeline.hpp"
+#include "features/liquidity_feed.hpp"
+#include "features/symbol_worker_pool.hpp"
+#include "io/ring_buffer_consumer.hpp"
+#include "io/mmap_buffer.hpp"
+#include "core/wire_format.hpp"
+#include "core/latency_trace.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+static std::atomic<bool> counting{false};
+static std::atomic<uint64_t> allocations{0};
+// Set on the thread waiting for the pipeline, whose polling is the test's own work
+static thread_local bool waiting = false;
+
+void* operator new(size_t size) {
+    if (counting.load(std::memory_order_relaxed) && !waiting) {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    void* p = std::malloc(size ? size : 1);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+extern std::atomic<bool> stop_flag;
+extern BroadcastRing<Traced<OrderBookUpdate>> orderbook_ring;
+extern EventCount feed_event;
+HandoffQueue<Traced<TradeMessageBinary>> trade_queue;
+
+constexpr int WARM_UP = 50000;
+constexpr int MEASURED = 200000;
+constexpr size_t BOOK_DEPTH = 20;
+// Longest the consuming threads get to catch up before the run counts as failed
+constexpr auto SETTLE_TIMEOUT = std::chrono::seconds(10);
+
+static std::atomic<uint64_t> bucket_events{0};
+
+static std::unique_ptr<LiquidityTracker> make_tracker(const std::string&) {
+    auto tracker = std::make_unique<LiquidityTracker>(50000.0, 50000.0, 5000.0, 30, 20, 0.01);
+    auto count = [](bool, uint64_t, double, double) { bucket_events.fetch_add(1); };
+    tracker->setBuyBucketCallback(count);
+    tracker->setSellBucketCallback(count);
+    tracker->setCancelBuyBucketCallback(count);
+    tracker->setCancelSellBucketCallback(count);
+    return tracker;
+}
+
+// Every fifth message is a book whose depth and volumes change each time and whose
+// prices move up a tick per update; the rest are trades
+template <typename Send>
+static void drive(Send&& send, int from, int to, unsigned symbols) {
+    static OrderBookUpdate book;
+    TradeMessageBinary trade{};
+    for (int i = from; i < to; ++i) {
+        uint64_t ts = 1700000000000000000ull + uint64_t(i) * 1000;
+        SymbolId symbol = SymbolId(i % symbols);
+        double drift = 0.01 * (i / 5);
+        if (i % 5 == 4) {
+            book.bids.resize(BOOK_DEPTH);
+            book.asks.resize(BOOK_DEPTH);
+            for (size_t k = 0; k < BOOK_DEPTH; ++k) {
+                book.bids[k] = {100.0 + drift - 0.01 * k, 1.0 + (i * 7 + k) % 13};
+                book.asks[k] = {100.5 + drift + 0.01 * k, 1.0 + (i * 3 + k) % 11};
+            }
+            book.bids.resize(10 + i % 11);
+            book.asks.resize(10 + (i / 3) % 11);
+            book.timestamp_ns = ts;
+            book.last_update_id = i;
+            send(symbol, nullptr, &book);
+        } else {
+            trade.timestamp_ns = ts;
+            trade.trade_id = i;
+            trade.price = 100.2 + drift;
+            trade.quantity = 0.5 + i % 4;
+            trade.flags = i % 2;
+            send(symbol, &trade, nullptr);
+        }
+    }
+}
+
+static void write_frame(MMapBuffer& ring, SymbolId symbol,
+                        const TradeMessageBinary* trade, const OrderBookUpdate* book) {
+    FrameTrailer trailer{symbol, trace_stamp(), trace_stamp(), trace_stamp()};
+    if (trade) {
+        uint8_t* body = ring.reserve(TYPE_TRADE, sizeof(*trade) + FRAME_TRAILER_SIZE);
+        std::memcpy(body, trade, sizeof(*trade));
+        write_frame_trailer(body, sizeof(*trade), trailer);
+        ring.commit(trade->timestamp_ns);
+    } else {
+        size_t size = orderbook_wire_size(*book);
+        uint8_t* body = ring.reserve(TYPE_ORDERBOOK, size + FRAME_TRAILER_SIZE);
+        serialize_orderbook_into(*book, body);
+        write_frame_trailer(body, size, trailer);
+        ring.commit(book->timestamp_ns);
+    }
+}
+
+// Messages from 0 up to count that drive() sends as books
+static uint64_t books_in(int count) {
+    return count / 5;
+}
+
+// Wait until the consuming threads are done(), or SETTLE_TIMEOUT passes; report()
+// then sees the shortfall
+template <typename Done>
+static void settle(Done&& done) {
+    waiting = true;
+    auto deadline = std::chrono::steady_clock::now() + SETTLE_TIMEOUT;
+    while (!done() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    waiting = false;
+}
+
+// Ring private to this process, so a live processor's FEED_RING_NAME is never touched
+static std::string test_ring_name() {
+    return "/binance_allocation_test_" + std::to_string(getpid());
+}
+
+static bool report(const char* mode, uint64_t processed, uint64_t expected) {
+    uint64_t count = allocations.load();
+    std::printf("%s: %d messages measured, %llu allocations, %llu of %llu handled\n",
+                mode, MEASURED, (unsigned long long)count,
+                (unsigned long long)processed, (unsigned long long)expected);
+    return count == 0 && processed == expected;
+}
+
+static bool run_inline() {
+    IcebergDetector iceberg;
+    auto tracker = make_tracker("BTCUSDT");
+    InlinePipeline pipeline(iceberg, *tracker);
+    uint64_t handled = 0;
+    auto send = [&](SymbolId, const TradeMessageBinary* trade, const OrderBookUpdate* book) {
+        TraceStamps trace;
+        if (trade) {
+            pipeline.on_trade(0, *trade, trace);
+        } else {
+            pipeline.on_orderbook(0, *book, trace);
+        }
+        ++handled;
+    };
+    drive(send, 0, WARM_UP, 1);
+    counting = true;
+    drive(send, WARM_UP, WARM_UP + MEASURED, 1);
+    counting = false;
+    return report("inline", handled, WARM_UP + MEASURED);
+}
+
+static bool run_threaded(MMapBuffer& ring, const RingOptions& options) {
+    IcebergDetector iceberg;
+    auto tracker = make_tracker("BTCUSDT");
+    size_t iceberg_cursor = orderbook_ring.subscribe();
+    size_t liquidity_cursor = orderbook_ring.subscribe();
+    std::atomic<uint64_t> iceberg_books{0};
+    std::thread consumer([&] { consume_ring_buffer(WAIT_SPIN_PARK, options, nullptr, ring.name()); });
+    std::thread iceberg_thread([&] {
+        while (const Traced<OrderBookUpdate>* update = orderbook_ring.wait(iceberg_cursor)) {
+            iceberg.process_update(update->message);
+            orderbook_ring.advance(iceberg_cursor);
+            iceberg_books.fetch_add(1, std::memory_order_relaxed);
+        }
+    });
+    LiquidityFeed feed(*tracker, orderbook_ring, liquidity_cursor, trade_queue, feed_event,
+                       std::chrono::milliseconds(5));
+    std::thread liquidity_thread([&] { feed.run(); });
+
+    auto send = [&](SymbolId, const TradeMessageBinary* trade, const OrderBookUpdate* book) {
+        write_frame(ring, 0, trade, book);
+    };
+    // Both detectors have everything sent so far
+    auto handled_all = [&](int sent) {
+        return [&, sent] {
+            return feed.delivered_events() >= static_cast<uint64_t>(sent) && iceberg_books >= books_in(sent);
+        };
+    };
+    drive(send, 0, WARM_UP, 1);
+    settle(handled_all(WARM_UP));
+    counting = true;
+    drive(send, WARM_UP, WARM_UP + MEASURED, 1);
+    settle(handled_all(WARM_UP + MEASURED));
+    counting = false;
+
+    stop_flag = true;
+    consumer.join();
+    orderbook_ring.close();
+    trade_queue.close();
+    feed_event.notify();
+    iceberg_thread.join();
+    liquidity_thread.join();
+    return report("threaded", feed.delivered_events(), WARM_UP + MEASURED);
+}
+
+static bool run_sharded(MMapBuffer& ring, const RingOptions& options) {
+    constexpr unsigned SYMBOLS = 8;
+    std::vector<std::string> symbols;
+    for (unsigned i = 0; i < SYMBOLS; ++i) {
+        symbols.push_back("SYM" + std::to_string(i) + "USDT");
+    }
+    SymbolWorkerPool pool(symbols, 3, make_tracker, PrecisionTable(), ThreadPlacement("worker"));
+    pool.start();
+    std::thread consumer([&] { consume_ring_buffer(WAIT_SPIN_PARK, options, &pool, ring.name()); });
+
+    auto send = [&](SymbolId symbol, const TradeMessageBinary* trade, const OrderBookUpdate* book) {
+        write_frame(ring, symbol, trade, book);
+    };
+    auto handled = [&] {
+        uint64_t processed = 0;
+        for (const auto& worker : pool.worker_stats()) {
+            processed += worker.messages;
+        }
+        return processed;
+    };
+    drive(send, 0, WARM_UP, SYMBOLS);
+    settle([&] { return handled() >= WARM_UP; });
+    counting = true;
+    drive(send, WARM_UP, WARM_UP + MEASURED, SYMBOLS);
+    settle([&] { return handled() >= WARM_UP + MEASURED; });
+    counting = false;
+
+    stop_flag = true;
+    consumer.join();
+    pool.stop();
+    return report("sharded", handled(), WARM_UP + MEASURED);
+}
+
+int main(int argc, char** argv) {
+    const char* mode = argc > 1 ? argv[1] : "";
+    latency_tracing = true;
+    if (!std::strcmp(mode, "inline")) {
+        return run_inline() ? 0 : 1;
+    }
+
+    RingOptions options;
+    options.mirrored = true;
+    options.overflow = OVERFLOW_BLOCK;
+    if (!std::strcmp(mode, "threaded")) {
+        MMapBuffer ring(test_ring_name(), 1 << 22, options);
+        return run_threaded(ring, options) ? 0 : 1;
+    }
+    if (!std::strcmp(mode, "sharded")) {
+        MMapBuffer ring(test_ring_name(), 1 << 22, options);
+        return run_sharded(ring, options) ? 0 : 1;
+    }
+    std::fprintf(stderr, "usage: %s inline|threaded|sharded\n", argv[0]);
+    return 2;
+}
@@ -0,0 +1,184 @@
+// DepthBook against the book it should reconstruct.
+//
+// A simulated exchange book takes random adds, changes and removals, one diff event
+// of them per update id range. A DepthBook subscribes part way through, gets a
+// snapshot taken a few events later, as a REST request would return it, and after
+// every event must match the top levels of the exchange book. Events are dropped now
+// and then to check that the gap is caught and a new snapshot resyncs the book.
+// Fixed cases cover the sequencing rules on their own.
+//
+// Links against depth_book.cpp and feed_parser.cpp. Exits non-zero on any mismatch.
+
+#include "core/depth_book.hpp"
+#include <cstdio>
+#include <map>
+#include <random>
+
+static int failures = 0;
+
+static void check(bool ok, const char* what) {
+    if (!ok) {
+        std::printf("FAIL %s\n", what);
+        ++failures;
+    }
+}
+
+static DepthMessage diff(uint64_t first, uint64_t final,
+                         std::initializer_list<std::pair<double, double>> bids,
+                         std::initializer_list<std::pair<double, double>> asks) {
+    DepthMessage message;
+    message.first_update_id = first;
+    message.final_update_id = final;
+    for (const auto& [price, quantity] : bids) {
+        message.bids.prices.push_back(price);
+        message.bids.quantities.push_back(quantity);
+    }
+    for (const auto& [price, quantity] : asks) {
+        message.asks.prices.push_back(price);
+        message.asks.quantities.push_back(quantity);
+    }
+    return message;
+}
+
+static void fixed_cases() {
+    DepthBook book;
+    check(book.apply(diff(100, 105, {{10.0, 1.0}}, {})) == DepthBook::BUFFERED, "buffered before snapshot");
+    check(book.apply(diff(106, 110, {{10.0, 0.0}, {9.0, 2.0}}, {{11.0, 3.0}})) == DepthBook::BUFFERED,
+          "second buffered");
+    // Snapshot at 103 sits inside the first event, which must straddle it
+    check(book.load_snapshot(diff(0, 103, {{10.0, 5.0}, {8.0, 1.0}}, {{12.0, 1.0}})), "snapshot connects");
+    check(book.synced() && book.last_update_id() == 110, "replayed to 110");
+    OrderBookUpdate top;
+    book.top_levels(10, top);
+    check(top.bids.size() == 2 && top.bids[0].price == 9.0 && top.bids[1].price == 8.0, "bid removed and added");
+    check(top.asks.size() == 2 && top.asks[0].price == 11.0 && top.asks[1].price == 12.0, "asks best first");
+    check(top.last_update_id == 110, "top carries the update id");
+
+    check(book.apply(diff(105, 110, {{7.0, 1.0}}, {})) == DepthBook::STALE, "covered event dropped");
+    check(book.apply(diff(115, 120, {}, {})) == DepthBook::GAP && !book.synced(), "gap unsyncs");
+    check(!book.load_snapshot(diff(0, 112, {}, {})), "snapshot before the gap does not connect");
+    check(book.load_snapshot(diff(0, 117, {{1.0, 1.0}}, {})) && book.last_update_id() == 120, "later snapshot does");
+
+    // Snapshot newer than everything buffered
+    DepthBook late;
+    late.apply(diff(1, 5, {{1.0, 1.0}}, {}));
+    check(late.load_snapshot(diff(0, 9, {{2.0, 1.0}}, {})) && late.last_update_id() == 9, "newer snapshot");
+    check(late.apply(diff(10, 11, {}, {})) == DepthBook::APPLIED, "continues after newer snapshot");
+}
+
+using Side = std::map<double, double>;
+
+static void fill_snapshot(const Side& bids, const Side& asks, uint64_t id, size_t depth, DepthMessage& out) {
+    out = DepthMessage();
+    out.final_update_id = id;
+    for (auto it = bids.rbegin(); it != bids.rend() && out.bids.size() < depth; ++it) {
+        out.bids.prices.push_back(it->first);
+        out.bids.quantities.push_back(it->second);
+    }
+    for (auto it = asks.begin(); it != asks.end() && out.asks.size() < depth; ++it) {
+        out.asks.prices.push_back(it->first);
+        out.asks.quantities.push_back(it->second);
+    }
+}
+
+// Whether the top depth levels of book match those of the exchange, ignoring levels
+// beyond the snapshot depth, which the book cannot know about
+static bool matches(const DepthBook& book, const Side& bids, const Side& asks, size_t depth) {
+    OrderBookUpdate top;
+    book.top_levels(depth, top);
+    DepthMessage expected;
+    fill_snapshot(bids, asks, 0, depth, expected);
+    if (top.bids.size() != expected.bids.size() || top.asks.size() != expected.asks.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < top.bids.size(); ++i) {
+        if (top.bids[i].price != expected.bids.prices[i] || top.bids[i].quantity != expected.bids.quantities[i]) {
+            return false;
+        }
+    }
+    for (size_t i = 0; i < top.asks.size(); ++i) {
+        if (top.asks[i].price != expected.asks.prices[i] || top.asks[i].quantity != expected.asks.quantities[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void random_run(unsigned seed) {
+    std::mt19937 rng(seed);
+    constexpr size_t SNAPSHOT_LEVELS = 200;  // Deeper than the book ever gets, so it is complete
+    constexpr size_t COMPARED_LEVELS = 50;
+    Side bids;
+    Side asks;
+    DepthBook book;
+    uint64_t next_id = 1;
+    int snapshot_taken_in = -1;      // Events until the requested snapshot is taken
+    int snapshot_delivered_in = -1;  // Then until it reaches the book
+    DepthMessage snapshot;
+    int mismatches = 0;
+    int gaps = 0;
+
+    for (int event = 0; event < 20000; ++event) {
+        DepthMessage message;
+        message.first_update_id = next_id;
+        int changes = 1 + rng() % 8;
+        for (int i = 0; i < changes; ++i) {
+            bool is_bid = rng() % 2;
+            double price = is_bid ? 100.0 - (rng() % 60) * 0.01 : 100.01 + (rng() % 60) * 0.01;
+            double quantity = rng() % 4 == 0 ? 0.0 : (1 + rng() % 1000) * 0.001;
+            Side& side = is_bid ? bids : asks;
+            if (quantity > 0.0) {
+                side[price] = quantity;
+            } else {
+                side.erase(price);
+            }
+            DepthLevels& levels = is_bid ? message.bids : message.asks;
+            levels.prices.push_back(price);
+            levels.quantities.push_back(quantity);
+        }
+        next_id += 1 + rng() % 3;  // Several updates per event, as the 100 ms stream batches them
+        message.final_update_id = next_id - 1;
+
+        bool dropped = event > 100 && rng() % 500 == 0;
+        DepthBook::Result result = dropped ? DepthBook::STALE : book.apply(message);
+        gaps += result == DepthBook::GAP;
+
+        // The book asks for a snapshot whenever it is unsynced. The exchange takes it
+        // a few events later, and it reaches the book a few events after that, so the
+        // events buffered meanwhile have to be replayed on top of it.
+        if (!book.synced() && snapshot_taken_in < 0 && snapshot_delivered_in < 0) {
+            snapshot_taken_in = rng() % 5;
+        }
+        if (snapshot_taken_in == 0) {
+            fill_snapshot(bids, asks, next_id - 1, SNAPSHOT_LEVELS, snapshot);
+            snapshot_delivered_in = rng() % 5;
+        }
+        if (snapshot_taken_in >= 0) {
+            --snapshot_taken_in;
+        }
+        if (snapshot_delivered_in == 0) {
+            book.load_snapshot(snapshot);
+        }
+        if (snapshot_delivered_in >= 0) {
+            --snapshot_delivered_in;
+        }
+
+        // A dropped event only shows as a gap when the next one arrives
+        if (!dropped && book.synced() && !matches(book, bids, asks, COMPARED_LEVELS)) {
+            if (++mismatches <= 5) {
+                std::printf("MISMATCH seed %u event %d\n", seed, event);
+            }
+        }
+    }
+    failures += mismatches;
+    check(gaps > 0, "random run dropped events without a gap");
+}
+
+int main() {
+    fixed_cases();
+    for (unsigned seed = 1; seed <= 20; ++seed) {
+        random_run(seed);
+    }
+    std::printf("depth book: %d failures\n", failures);
+    return failures == 0 ? 0 : 1;
+}
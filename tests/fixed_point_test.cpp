@@ -0,0 +1,178 @@
+// Exact decimal-to-fixed-point conversion against a std::from_chars reference.
+//
+// Every string of up to max_length characters (default 6) over "0123456789.x", then a
+// few million random Binance-shaped and overlong strings, is converted at every
+// precision from 0 to MAX_FIXED_DECIMALS three ways, each compared with the reference:
+//
+//   parse_fixed_point           the string on its own
+//   parse_depth_message         the string as a bid price inside a depthUpdate payload,
+//                               where the 16-byte SSE4.1 scan has room to load
+//   parse_depth_message         the same payload decoded to doubles, against
+//                               std::from_chars(double)
+//
+// Links against feed_parser.cpp. Build it twice to cover both scanners: as is (SSE4.1
+// when the CPU has it) and with feed_parser.cpp compiled with -DFEED_PARSER_SCALAR=1.
+// Exits non-zero on any mismatch.
+
+#include "core/feed_parser.hpp"
+#include <charconv>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+// Longest digit string the scanner takes, so that its mantissa fits in 64 bits
+constexpr size_t MAX_DIGITS = 19;
+
+// Syntax checked by hand, value by std::from_chars on the digits rescaled as a string
+static bool reference(const std::string& text, unsigned decimals, int64_t& units) {
+    if (text.empty() || text.find_first_not_of("0123456789.") != std::string::npos) {
+        return false;
+    }
+    size_t dot = text.find('.');
+    if (dot != std::string::npos && text.find('.', dot + 1) != std::string::npos) {
+        return false;
+    }
+    std::string integer = dot == std::string::npos ? text : text.substr(0, dot);
+    std::string fraction = dot == std::string::npos ? "" : text.substr(dot + 1);
+    if ((integer.empty() && fraction.empty()) || integer.size() + fraction.size() > MAX_DIGITS) {
+        return false;
+    }
+    if (fraction.size() > decimals) {
+        if (fraction.find_first_not_of('0', decimals) != std::string::npos) {
+            return false;
+        }
+        fraction.resize(decimals);
+    } else {
+        fraction.append(decimals - fraction.size(), '0');
+    }
+    std::string digits = integer + fraction;
+    if (digits.empty()) {
+        digits = "0";
+    }
+    std::from_chars_result result = std::from_chars(digits.data(), digits.data() + digits.size(), units);
+    return result.ec == std::errc() && result.ptr == digits.data() + digits.size();
+}
+
+static long conversions = 0;
+static long mismatches = 0;
+
+static void mismatch(const char* path, const std::string& text, unsigned decimals,
+                     bool got_ok, int64_t got, bool want_ok, int64_t want) {
+    if (++mismatches <= 20) {
+        std::printf("MISMATCH %s '%s' at %u decimals: got %d %lld, want %d %lld\n", path, text.c_str(),
+                    decimals, got_ok, (long long)got, want_ok, (long long)want);
+    }
+}
+
+static void check(const std::string& text) {
+    static std::string payload;
+    static FixedDepthMessage fixed;
+    static DepthMessage depth;
+    payload = "{\"e\":\"depthUpdate\",\"E\":1,\"U\":1,\"u\":2,\"b\":[[\"" + text + "\",\"1\"]],\"a\":[]}";
+
+    for (unsigned decimals = 0; decimals <= MAX_FIXED_DECIMALS; ++decimals) {
+        int64_t want = 0;
+        bool want_ok = reference(text, decimals, want);
+
+        int64_t units = 0;
+        bool ok = parse_fixed_point(text.data(), text.size(), decimals, units);
+        if (ok != want_ok || (ok && units != want)) {
+            mismatch("parse_fixed_point", text, decimals, ok, units, want_ok, want);
+        }
+
+        SymbolPrecision precision{static_cast<uint8_t>(decimals), 0};
+        ok = parse_depth_message(payload.data(), payload.size(), precision, fixed);
+        units = ok ? fixed.bids.prices[0] : 0;
+        if (ok != want_ok || (ok && units != want)) {
+            mismatch("depth payload", text, decimals, ok, units, want_ok, want);
+        }
+        conversions += 2;
+    }
+
+    // Doubles must come out exactly as from_chars rounds them
+    double want = 0.0;
+    std::from_chars_result result = std::from_chars(text.data(), text.data() + text.size(), want);
+    bool want_ok = !text.empty() && result.ec == std::errc() && result.ptr == text.data() + text.size();
+    bool ok = parse_depth_message(payload.data(), payload.size(), depth);
+    if (ok != want_ok || (ok && depth.bids.prices[0] != want)) {
+        if (++mismatches <= 20) {
+            std::printf("MISMATCH double '%s': got %d %.17g, want %d %.17g\n", text.c_str(), ok,
+                        ok ? depth.bids.prices[0] : 0.0, want_ok, want);
+        }
+    }
+    ++conversions;
+}
+
+static void check_exhaustive(size_t max_length) {
+    static const char alphabet[] = "0123456789.x";
+    const size_t letters = sizeof(alphabet) - 1;
+    for (size_t length = 0; length <= max_length; ++length) {
+        std::string text(length, alphabet[0]);
+        std::vector<size_t> index(length, 0);
+        for (;;) {
+            for (size_t i = 0; i < length; ++i) {
+                text[i] = alphabet[index[i]];
+            }
+            check(text);
+            size_t i = length;
+            while (i > 0 && ++index[i - 1] == letters) {
+                index[--i] = 0;
+            }
+            if (i == 0) {
+                break;
+            }
+        }
+    }
+}
+
+// Up to 19 integer and 19 fraction digits, zero-heavy fractions as Binance pads them,
+// sometimes cut short
+static void check_random(int count) {
+    std::mt19937_64 rng(7);
+    for (int n = 0; n < count; ++n) {
+        std::string text;
+        int integer = static_cast<int>(rng() % 20);
+        for (int i = 0; i < integer; ++i) {
+            text += static_cast<char>('0' + rng() % 10);
+        }
+        if (rng() % 8) {
+            text += '.';
+            int fraction = static_cast<int>(rng() % 20);
+            for (int i = 0; i < fraction; ++i) {
+                text += static_cast<char>('0' + (rng() % 3 ? rng() % 10 : 0));
+            }
+        }
+        if (rng() % 4 == 0 && text.size() > 2) {
+            text.resize(text.size() - rng() % 3);
+        }
+        check(text);
+    }
+}
+
+// Values around the int64_t and 19-digit limits, at both ends of the precision range
+static void check_edges() {
+    for (const char* text : {"9223372036854775807", "9223372036854775808", "922337203685477580.7",
+                             "9.223372036854775807", "9.223372036854775808", "18446744073709551615",
+                             "0.000000000000000001", "0.0000000000000000001", "0.0000000000000000010",
+                             "1000000000000000000", "99999999.99999999", "0.00000000"}) {
+        check(text);
+    }
+}
+
+int main(int argc, char** argv) {
+    size_t max_length = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 6;
+
+    check_exhaustive(max_length);
+    long exhaustive = conversions;
+    std::printf("exhaustive to %zu characters: %ld conversions\n", max_length, exhaustive);
+
+    check_random(2000000);
+    check_edges();
+    std::printf("random and edge cases: %ld conversions\n", conversions - exhaustive);
+
+    std::printf("%ld mismatches\n", mismatches);
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,194 @@
+#include "core/thread_placement.hpp"
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+
+// Linux limit on thread names, excluding the terminator
+constexpr size_t THREAD_NAME_MAX = 15;
+
+static std::string error_text() {
+    return std::strerror(errno);
+}
+
+static std::string read_sysfs_line(const std::string& path) {
+    std::ifstream file(path);
+    std::string line;
+    std::getline(file, line);
+    return line;
+}
+
+static std::string format_cpu_list(const cpu_set_t& set) {
+    std::ostringstream out;
+    int run_start = -1;
+    bool first = true;
+    for (int cpu = 0; cpu <= CPU_SETSIZE; ++cpu) {
+        bool in_set = cpu < CPU_SETSIZE && CPU_ISSET(cpu, &set);
+        if (in_set && run_start < 0) {
+            run_start = cpu;
+        } else if (!in_set && run_start >= 0) {
+            out << (first ? "" : ",") << run_start;
+            if (cpu - 1 > run_start) out << "-" << cpu - 1;
+            first = false;
+            run_start = -1;
+        }
+    }
+    return out.str();
+}
+
+bool parse_cpu_list(const std::string& text, std::vector<int>& out) {
+    out.clear();
+    std::istringstream in(text);
+    std::string range;
+    while (std::getline(in, range, ',')) {
+        if (range.empty()) continue;
+        char* end = nullptr;
+        long first = std::strtol(range.c_str(), &end, 10);
+        long last = first;
+        if (end == range.c_str()) return false;
+        if (*end == '-') {
+            const char* second = end + 1;
+            last = std::strtol(second, &end, 10);
+            if (end == second) return false;
+        }
+        if (*end != '\0' || first < 0 || last < first || last >= CPU_SETSIZE) return false;
+        for (long cpu = first; cpu <= last; ++cpu) {
+            out.push_back(static_cast<int>(cpu));
+        }
+    }
+    return true;
+}
+
+static void apply_affinity(const ThreadPlacement& placement) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (placement.cpu >= 0) {
+        if (placement.cpu >= CPU_SETSIZE) {
+            std::cerr << "[Placement] " << placement.name << ": cpu " << placement.cpu
+                      << " is out of range" << std::endl;
+            return;
+        }
+        CPU_SET(placement.cpu, &set);
+    } else {
+        std::string path = "/sys/devices/system/node/node" + std::to_string(placement.numa_node) + "/cpulist";
+        std::vector<int> cpus;
+        if (!parse_cpu_list(read_sysfs_line(path), cpus) || cpus.empty()) {
+            std::cerr << "[Placement] " << placement.name << ": no cores found for NUMA node "
+                      << placement.numa_node << std::endl;
+            return;
+        }
+        for (int cpu : cpus) CPU_SET(cpu, &set);
+    }
+
+    int rc = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (rc != 0) {
+        std::cerr << "[Placement] " << placement.name << ": failed to set affinity to "
+                  << format_cpu_list(set) << ": " << std::strerror(rc) << std::endl;
+    }
+}
+
+static void apply_memory_node(const ThreadPlacement& placement) {
+    // Preferred rather than bound: a full node falls back instead of failing allocations.
+    // Raw syscall so the build does not pick up a libnuma dependency.
+    unsigned long nodemask[4] = {};
+    constexpr unsigned long MASK_BITS = sizeof(nodemask) * CHAR_BIT;
+    constexpr unsigned long WORD_BITS = sizeof(unsigned long) * CHAR_BIT;
+    unsigned long node = static_cast<unsigned long>(placement.numa_node);
+    if (node >= MASK_BITS) {
+        std::cerr << "[Placement] " << placement.name << ": NUMA node " << node
+                  << " is out of range" << std::endl;
+        return;
+    }
+    nodemask[node / WORD_BITS] |= 1UL << (node % WORD_BITS);
+    if (syscall(SYS_set_mempolicy, MPOL_PREFERRED, nodemask, MASK_BITS) != 0) {
+        std::cerr << "[Placement] " << placement.name << ": failed to prefer NUMA node "
+                  << node << ": " << error_text() << std::endl;
+    }
+}
+
+static void apply_priority(const ThreadPlacement& placement) {
+    sched_param param{};
+    param.sched_priority = placement.fifo_priority;
+    int rc = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if (rc != 0) {
+        std::cerr << "[Placement] " << placement.name << ": failed to set SCHED_FIFO priority "
+                  << placement.fifo_priority << ": " << std::strerror(rc) << std::endl;
+    }
+}
+
+void apply_thread_placement(const ThreadPlacement& placement) {
+    if (!placement.name.empty()) {
+        std::string name = placement.name.substr(0, THREAD_NAME_MAX);
+        pthread_setname_np(pthread_self(), name.c_str());
+    }
+    // Memory policy first so anything the affinity change allocates already lands on the node
+    if (placement.numa_node >= 0) {
+        apply_memory_node(placement);
+    }
+    if (placement.cpu >= 0 || placement.numa_node >= 0) {
+        apply_affinity(placement);
+    }
+    if (placement.fifo_priority > 0) {
+        apply_priority(placement);
+    }
+    std::cout << "[Placement] " << describe_thread_placement() << std::endl;
+}
+
+std::string describe_thread_placement() {
+    std::ostringstream out;
+
+    char name[THREAD_NAME_MAX + 1] = {};
+    pthread_getname_np(pthread_self(), name, sizeof(name));
+    out << name << " (tid " << syscall(SYS_gettid) << "):";
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (pthread_getaffinity_np(pthread_self(), sizeof(set), &set) == 0) {
+        out << " cores " << format_cpu_list(set);
+    }
+
+    unsigned cpu = 0;
+    unsigned node = 0;
+    if (syscall(SYS_getcpu, &cpu, &node, nullptr) == 0) {
+        out << ", on core " << cpu << " (node " << node << ")";
+        std::vector<int> isolated;
+        if (parse_cpu_list(read_sysfs_line("/sys/devices/system/cpu/isolated"), isolated)) {
+            for (int id : isolated) {
+                if (id == static_cast<int>(cpu)) {
+                    out << " isolated";
+                    break;
+                }
+            }
+        }
+    }
+
+    int policy = 0;
+    sched_param param{};
+    if (pthread_getschedparam(pthread_self(), &policy, &param) == 0) {
+        if (policy == SCHED_FIFO) out << ", SCHED_FIFO " << param.sched_priority;
+        else if (policy == SCHED_RR) out << ", SCHED_RR " << param.sched_priority;
+        else out << ", SCHED_OTHER";
+    }
+
+    int mode = 0;
+    unsigned long nodemask[4] = {};
+    if (syscall(SYS_get_mempolicy, &mode, nodemask, sizeof(nodemask) * CHAR_BIT, nullptr, 0) == 0 &&
+        mode == MPOL_PREFERRED) {
+        constexpr unsigned long WORD_BITS = sizeof(unsigned long) * CHAR_BIT;
+        for (unsigned long bit = 0; bit < sizeof(nodemask) * CHAR_BIT; ++bit) {
+            if (nodemask[bit / WORD_BITS] & (1UL << (bit % WORD_BITS))) {
+                out << ", memory from node " << bit;
+                break;
+            }
+        }
+    }
+    return out.str();
+}
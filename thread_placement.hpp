@@ -0,0 +1,27 @@
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+// Where and how a pipeline thread runs. Every field defaults to "leave it to the OS".
+struct ThreadPlacement {
+    ThreadPlacement() = default;
+    explicit ThreadPlacement(std::string thread_name) : name(std::move(thread_name)) {}
+
+    std::string name;        // Thread name shown by top/perf; truncated to 15 characters
+    int cpu = -1;            // Pin to this core; -1 leaves the affinity mask alone
+    int fifo_priority = 0;   // SCHED_FIFO priority 1-99; 0 keeps SCHED_OTHER
+    int numa_node = -1;      // Allocate memory from this node; without a cpu, also run on its cores
+};
+
+// Apply placement to the calling thread, then log where it actually ended up.
+// Each setting that fails (typically SCHED_FIFO without CAP_SYS_NICE) is reported on
+// stderr and skipped; the thread keeps running with the rest.
+void apply_thread_placement(const ThreadPlacement& placement);
+
+// Name, allowed cores, current core, scheduling policy and memory node of the calling thread
+std::string describe_thread_placement();
+
+// Parse a kernel cpulist such as "0-3,8,10-11"; false on malformed input
+bool parse_cpu_list(const std::string& text, std::vector<int>& out);
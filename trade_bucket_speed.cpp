@@ -1,23 +1,5 @@
 #include "trade_bucket_speed.hpp"
-#include <iostream>
-#include <iomanip>
-#include <chrono>
-#include <sstream>
-
-// Helper function to format timestamp
-std::string format_timestamp_bucket(uint64_t timestamp_ns) {
-    auto timestamp_ms = timestamp_ns / 1000000;
-    auto time_t_sec = timestamp_ms / 1000;
-    auto ms_part = timestamp_ms % 1000;
-    
-    std::time_t time = static_cast<std::time_t>(time_t_sec);
-    std::tm* tm_utc = std::gmtime(&time);
-    
-    std::stringstream ss;
-    ss << std::put_time(tm_utc, "%Y-%m-%d %H:%M:%S");
-    ss << "." << std::setfill('0') << std::setw(3) << ms_part;
-    return ss.str();
-}
+#include "core/async_logger.hpp"
 
 TradeBucketSpeed::TradeBucketSpeed() 
     : bucket_size_usd_(10000.0)
@@ -52,11 +34,9 @@ void TradeBucketSpeed::processTrade(const TradeMessageBinary& trade) {
             callback_(duration_ns, bucket_accum_usd_);
         } else {
             // Default output with timestamp
-            std::cout << "[" << format_timestamp_bucket(trade.timestamp_ns) << "] "
-                      << "[TRADE BUCKET] $" << std::fixed << std::setprecision(2) << bucket_accum_usd_
-                      << " traded in " << std::setprecision(1) << (duration_ns / 1e6) << " ms"
-                      << " (rate: $" << std::setprecision(0) << (bucket_accum_usd_ / (duration_ns / 1e9)) << "/s)"
-                      << std::endl;
+            log_event(LOG_BUCKET, LOG_INFO, trade.timestamp_ns,
+                      "[TRADE BUCKET] ${.2} traded in {.1} ms (rate: ${.0}/s)",
+                      bucket_accum_usd_, duration_ns / 1e6, bucket_accum_usd_ / (duration_ns / 1e9));
         }
         
         // Reset the bucket
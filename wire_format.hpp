@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "core/serialization.hpp"
+
+// Message type identifiers carried in the ring buffer frame header.
+// 0x00 is reserved for ring padding frames.
+enum MessageType : uint8_t {
+    TYPE_TRADE = 0x01,
+    TYPE_ORDERBOOK = 0x02
+};
+
+// Position of a symbol in the configured symbol list (see SymbolTable)
+using SymbolId = uint16_t;
+
+// Every frame body ends with a trailer after the serialized message: the SymbolId of
+// the stream it came from and the producer's trace stamps (zero when not tracing)
+struct FrameTrailer {
+    SymbolId symbol;
+    uint64_t received_ns;
+    uint64_t parsed_ns;
+    uint64_t committed_ns;
+};
+
+// Packed size on the wire: symbol, then the three stamps
+constexpr size_t FRAME_TRAILER_SIZE = sizeof(SymbolId) + 3 * sizeof(uint64_t);
+
+void write_frame_trailer(uint8_t* body, size_t message_size, const FrameTrailer& trailer);
+
+// Trailer of a frame body of body_size bytes (message plus trailer)
+FrameTrailer read_frame_trailer(const uint8_t* body, size_t body_size);
+
+// Number of bytes serialize_orderbook_into() writes for this update
+size_t orderbook_wire_size(const OrderBookUpdate& book);
+
+// Serialize an order book update straight into caller-provided memory
+// (e.g. a ring buffer reservation) that holds at least orderbook_wire_size(book) bytes
+void serialize_orderbook_into(const OrderBookUpdate& book, uint8_t* out);
+
+// The *_into decoders below fill a caller-owned update, reusing the capacity its
+// bids/asks already have, so a recycled update costs no allocation once warmed up.
+
+// Make room for count levels in a recycled update's side. Capacity is rounded up to a
+// power of two, so a slot settles after a reallocation or two instead of growing by
+// one level each time it meets a slightly deeper book.
+void reserve_levels(std::vector<PriceLevel>& levels, size_t count);
+
+// Inverse of serialize_orderbook_into(); throws std::runtime_error on a short buffer
+void deserialize_orderbook_into(const uint8_t* data, size_t size, OrderBookUpdate& book);
+
+// Parse a Binance depthUpdate message; false (and book unspecified) if it is not one
+// or is malformed
+bool parse_orderbook_json_into(const std::string& json_str, OrderBookUpdate& book);